@@ -0,0 +1,139 @@
+/**
+ * JSON String Escaping Micro-Benchmark
+ * Tiered escapeString vs the previous per-character loop vs JSON.stringify,
+ * across string length distributions (clean and needing escapes).
+ */
+import { escapeString } from "../utils/core/compile-serializer.js";
+
+const SAMPLES = 1000;
+const TARGET_CHARS = 20_000_000; // work per measurement, scaled by length
+
+// Previous implementation: charCodeAt over every character
+function escapeLoop(str) {
+  if (str.length === 0) return '""';
+
+  let result = '"';
+  let last = 0;
+
+  for (let i = 0; i < str.length; i++) {
+    const code = str.charCodeAt(i);
+    if (code < 32 || code === 34 || code === 92) {
+      if (i > last) result += str.slice(last, i);
+      switch (code) {
+        case 34:
+          result += '\\"';
+          break;
+        case 92:
+          result += "\\\\";
+          break;
+        case 10:
+          result += "\\n";
+          break;
+        default:
+          result += "\\u" + code.toString(16).padStart(4, "0");
+      }
+      last = i + 1;
+    }
+  }
+
+  if (last === 0) return '"' + str + '"';
+  if (last < str.length) result += str.slice(last);
+  return result + '"';
+}
+
+// Distinct strings per distribution so nothing is served from a cache
+function generate(minLen, maxLen, dirty) {
+  const out = [];
+  const alphabet = "abcdefghijklmnopqrstuvwxyz0123456789-_";
+  for (let i = 0; i < SAMPLES; i++) {
+    const len = minLen + Math.floor(Math.random() * (maxLen - minLen + 1));
+    let s = "";
+    for (let j = 0; j < len; j++) {
+      s += alphabet[Math.floor(Math.random() * alphabet.length)];
+    }
+    if (dirty) {
+      const at = Math.floor(len / 2);
+      s = s.slice(0, at) + (i % 2 ? '"' : "\n") + s.slice(at + 1);
+    }
+    out.push(s);
+  }
+  return out;
+}
+
+const DISTRIBUTIONS = [
+  ["ids (8-24)", generate(8, 24, false)],
+  ["slugs (24-64)", generate(24, 64, false)],
+  ["text (64-256)", generate(64, 256, false)],
+  ["long (1k-4k)", generate(1024, 4096, false)],
+  ["ids, dirty", generate(8, 24, true)],
+  ["text, dirty", generate(64, 256, true)],
+  ["long, dirty", generate(1024, 4096, true)],
+];
+
+const CANDIDATES = [
+  ["escapeString", escapeString],
+  ["previous loop", escapeLoop],
+  ["JSON.stringify", JSON.stringify],
+];
+
+const RUNS = 7;
+
+// One timed pass of fn over the samples, in ns/op
+function pass(fn, data, rounds) {
+  let sink = 0;
+  const start = process.hrtime.bigint();
+  for (let r = 0; r < rounds; r++) {
+    for (let i = 0; i < data.length; i++) sink += fn(data[i]).length;
+  }
+  const ns = Number(process.hrtime.bigint() - start) / (rounds * data.length);
+  if (sink === 0) console.log("unreachable");
+  return ns;
+}
+
+// Median ns/op per candidate. Candidates are interleaved within each run
+// so host noise and JIT drift hit all of them alike.
+function measure(data) {
+  const chars = data.reduce((n, s) => n + s.length, 0);
+  const rounds = Math.max(1, Math.round(TARGET_CHARS / chars / RUNS));
+  const runs = CANDIDATES.map(() => []);
+
+  for (const [, fn] of CANDIDATES) pass(fn, data, rounds); // warmup
+  for (let run = 0; run < RUNS; run++) {
+    CANDIDATES.forEach(([, fn], c) => runs[c].push(pass(fn, data, rounds)));
+  }
+  return runs.map((r) => r.sort((a, b) => a - b)[RUNS >> 1]);
+}
+
+// Correctness first: every candidate must agree with JSON.stringify
+for (const [, data] of DISTRIBUTIONS) {
+  for (const s of data) {
+    if (escapeString(s) !== JSON.stringify(s)) {
+      console.error(`❌ escapeString mismatch for ${JSON.stringify(s)}`);
+      process.exit(1);
+    }
+  }
+}
+
+console.log("🔬 JSON String Escaping Benchmark (ns/op, lower is better)\n");
+console.log("=".repeat(78));
+console.log(
+  `| ${"Distribution".padEnd(16)} | ${CANDIDATES.map(([n]) => n.padEnd(14)).join(" | ")} | ${"vs prev".padEnd(8)} |`,
+);
+console.log("=".repeat(78));
+
+let regressions = 0;
+for (const [label, data] of DISTRIBUTIONS) {
+  const times = measure(data);
+  const speedup = times[1] / times[0];
+  if (speedup < 0.9) regressions++;
+  console.log(
+    `| ${label.padEnd(16)} | ${times.map((t) => t.toFixed(1).padEnd(14)).join(" | ")} | ${(speedup.toFixed(2) + "x").padEnd(8)} |`,
+  );
+}
+
+console.log("=".repeat(78));
+console.log(
+  regressions === 0
+    ? "\n✅ No distribution regressed against the previous loop\n"
+    : `\n⚠️  ${regressions} distribution(s) slower than the previous loop\n`,
+);
@@ -0,0 +1,93 @@
+/**
+ * Streaming JSON Body Benchmark
+ * parseJsonStream with a path selection vs buffering the whole document
+ * and calling JSON.parse. Reports throughput and peak memory growth while
+ * reading a large `{ "items": [...] }` import from a chunked stream.
+ *
+ * Run with --expose-gc for stable memory numbers:
+ *   node --expose-gc tests/bench-json-stream.js [megabytes]
+ */
+import { Readable } from "stream";
+import { parseJsonStream } from "../utils/core/parser.js";
+
+const MEGABYTES = Number(process.argv[2]) || 100;
+
+// One realistic import row; ids vary so rows are not identical strings
+function row(i) {
+  return JSON.stringify({
+    id: i,
+    sku: `SKU-${i.toString(36)}`,
+    name: `Product "${i}" édition`,
+    price: (i % 1000) / 10,
+    tags: ["import", i % 2 ? "odd" : "even"],
+    stock: { warehouse: "eu-1", qty: i % 97 },
+  });
+}
+
+// Sampled as chunks are pulled (await-only loops never let timers run)
+let peak = 0;
+
+// One block of rows (~50 KB), repeated: the source holds no document
+const BLOCK = Buffer.from(
+  Array.from({ length: 400 }, (_, i) => row(i)).join(",") + ",",
+);
+
+function source() {
+  const blocks = Math.ceil((MEGABYTES * 1024 * 1024) / BLOCK.length);
+  return Readable.from(
+    (function* () {
+      yield Buffer.from('{"meta":{"source":"bench"},"items":[');
+      for (let b = 0; b < blocks; b++) {
+        peak = Math.max(peak, memory());
+        yield BLOCK;
+      }
+      yield Buffer.from('{"id":-1}]}');
+    })(),
+  );
+}
+
+// Heap plus Buffer memory, which lives outside the JS heap
+function memory() {
+  const m = process.memoryUsage();
+  return m.heapUsed + m.external;
+}
+
+async function run(label, consume) {
+  globalThis.gc?.();
+  const base = memory();
+  peak = base;
+  const start = process.hrtime.bigint();
+  const count = await consume(source());
+  const ms = Number(process.hrtime.bigint() - start) / 1e6;
+  peak = Math.max(peak, memory());
+  console.log(
+    `| ${label.padEnd(28)} | ${String(count).padEnd(9)} | ${(MEGABYTES / (ms / 1000)).toFixed(0).padStart(6)} MB/s | ${((peak - base) / 1048576).toFixed(1).padStart(8)} MB |`,
+  );
+}
+
+console.log(`🔬 Streaming JSON Benchmark (${MEGABYTES} MB document)\n`);
+console.log("=".repeat(70));
+console.log(
+  `| ${"Mode".padEnd(28)} | ${"Items".padEnd(9)} | ${"Throughput".padEnd(11)} | ${"Peak mem".padEnd(11)} |`,
+);
+console.log("=".repeat(70));
+
+await run("buffer + JSON.parse", async (stream) => {
+  const chunks = [];
+  for await (const chunk of stream) chunks.push(chunk);
+  return JSON.parse(Buffer.concat(chunks).toString()).items.length;
+});
+
+await run("parseJsonStream (whole)", async (stream) => {
+  return (await parseJsonStream(stream)).items.length;
+});
+
+await run('parseJsonStream "$.items[*]"', async (stream) => {
+  let count = 0;
+  for await (const item of parseJsonStream(stream, "$.items[*]")) {
+    if (item) count++;
+  }
+  return count;
+});
+
+console.log("=".repeat(70));
@@ -1,8 +1,13 @@
 /**
  * OVERLOAD Benchmark — Vibe vs Fastify vs Express vs Hono
- * 20,000 requests × 200 concurrent connections
+ * 20,000 requests × 200 concurrent connections, plus abuse scenarios:
+ * - slow-loris: many connections dribbling a JSON body one byte at a time
+ * - oversized: bodies far over the JSON limit (declared and chunked)
+ * Both report server memory growth (from a /mem route) and whether
+ * normal requests are still answered.
  */
 import http from "http";
+import net from "net";
 import fs from "fs";
 import { spawn } from "child_process";
 import { fileURLToPath } from "url";
@@ -13,6 +18,12 @@ const PORT = 4000;
 const REQUESTS = 20000;
 const CONCURRENCY = 200;
 
+// Abuse scenarios
+const LORIS_SOCKETS = 500;
+const LORIS_DURATION = 5000; // ms
+const OVERSIZED_REQUESTS = 50;
+const OVERSIZED_BYTES = 64 * 1024 * 1024; // declared / attempted per request
+
 http.globalAgent.maxSockets = CONCURRENCY + 50;
 
 function makeRequest(reqPath) {
@@ -64,6 +75,165 @@ function calcStats(arr) {
   };
 }
 
+// ── Abuse scenarios ──────────────────────────────────────────────────
+const MB = 1024 * 1024;
+
+async function serverMemory() {
+  return new Promise((resolve) => {
+    http
+      .get(`http://127.0.0.1:${PORT}/mem`, (res) => {
+        let data = "";
+        res.on("data", (chunk) => (data += chunk));
+        res.on("end", () => {
+          try {
+            resolve(JSON.parse(data));
+          } catch {
+            resolve(null);
+          }
+        });
+      })
+      .on("error", () => resolve(null));
+  });
+}
+
+// rss/heapUsed delta in MB between two /mem snapshots
+function memDelta(before, after) {
+  if (!before || !after) return { rss: NaN, heap: NaN };
+  return {
+    rss: (after.rss - before.rss) / MB,
+    heap: (after.heapUsed - before.heapUsed) / MB,
+  };
+}
+
+// Latency of one normal request while the server is under attack
+async function probe() {
+  try {
+    const { time, status } = await makeRequest("/json");
+    return status === 200 ? time : NaN;
+  } catch {
+    return NaN;
+  }
+}
+
+/**
+ * Slow-loris: each socket declares a 1 MB JSON body and sends one byte
+ * every 200 ms. A server that buffers per-connection state grows; one that
+ * drops the connection (or never allocates) stays flat.
+ */
+async function slowLoris(sockets, duration) {
+  const before = await serverMemory();
+  const conns = [];
+  let closedByServer = 0;
+
+  for (let i = 0; i < sockets; i++) {
+    const socket = net.connect(PORT, "127.0.0.1");
+    socket.on("error", () => {});
+    socket.on("close", () => {
+      if (!socket._vibeBenchDone) closedByServer++;
+    });
+    socket.write(
+      "POST /ingest HTTP/1.1\r\nHost: 127.0.0.1\r\n" +
+        "Content-Type: application/json\r\nContent-Length: 1000000\r\n\r\n[",
+    );
+    conns.push(socket);
+  }
+
+  const drip = setInterval(() => {
+    for (const socket of conns) {
+      if (!socket.destroyed) socket.write("0,");
+    }
+  }, 200);
+
+  await new Promise((r) => setTimeout(r, duration / 2));
+  const during = await serverMemory();
+  const probeMs = await probe();
+  await new Promise((r) => setTimeout(r, duration / 2));
+
+  clearInterval(drip);
+  for (const socket of conns) {
+    socket._vibeBenchDone = true;
+    socket.destroy();
+  }
+  await new Promise((r) => setTimeout(r, 1000));
+  const after = await serverMemory();
+
+  return {
+    during: memDelta(before, during),
+    after: memDelta(before, after),
+    closedByServer,
+    probeMs,
+  };
+}
+
+/**
+ * Oversized bodies: half declare a huge Content-Length, half use chunked
+ * encoding. Each client writes as fast as the socket takes it until the
+ * server answers or closes; we record the status and bytes it accepted.
+ */
+async function oversized(count, bytes) {
+  const before = await serverMemory();
+  const statuses = {};
+  let accepted = 0;
+  const block = Buffer.alloc(64 * 1024, 0x20); // JSON whitespace
+
+  const one = (chunked) =>
+    new Promise((resolve) => {
+      let sent = 0;
+      let done = false;
+      const finish = (status) => {
+        if (done) return;
+        done = true;
+        statuses[status] = (statuses[status] || 0) + 1;
+        accepted += sent;
+        resolve();
+      };
+
+      const req = http.request({
+        hostname: "127.0.0.1",
+        port: PORT,
+        path: "/ingest",
+        method: "POST",
+        agent: false,
+        headers: chunked
+          ? { "content-type": "application/json" }
+          : { "content-type": "application/json", "content-length": bytes },
+      });
+      req.on("response", (res) => {
+        res.resume();
+        finish(res.statusCode);
+        req.destroy();
+      });
+      req.on("error", () => finish("reset"));
+      req.on("close", () => finish("closed"));
+      req.setTimeout(15000, () => req.destroy());
+
+      const pump = () => {
+        while (!done && sent < bytes) {
+          sent += block.length;
+          if (!req.write(block)) return req.once("drain", pump);
+        }
+        if (!done) req.end();
+      };
+      pump();
+    });
+
+  const start = process.hrtime.bigint();
+  await Promise.all(
+    Array.from({ length: count }, (_, i) => one(i % 2 === 1)),
+  );
+  const ms = Number(process.hrtime.bigint() - start) / 1_000_000;
+  const probeMs = await probe();
+  const after = await serverMemory();
+
+  return {
+    statuses,
+    acceptedMb: accepted / count / MB,
+    after: memDelta(before, after),
+    ms,
+    probeMs,
+  };
+}
+
 const servers = {
   Vibe: `
 import vibe from "../vibe.js";
@@ -91,6 +261,8 @@ app.get("/users/:id", {
     }
   }
 }, (req) => ({ id: req.params.id, fw: "Vibe" }));
+app.get("/mem", () => process.memoryUsage());
+app.post("/ingest", (req) => ({ keys: Object.keys(req.body || {}).length }));
 app.listen(${PORT}, "127.0.0.1", () => console.log("READY"));
 `,
   Fastify: `
@@ -99,6 +271,8 @@ const app = Fastify({ logger: false });
 app.get("/", () => "Hello World");
 app.get("/json", () => ({ message: "Hello", framework: "Fastify" }));
 app.get("/users/:id", (req) => ({ id: req.params.id, fw: "Fastify" }));
+app.get("/mem", () => process.memoryUsage());
+app.post("/ingest", (req) => ({ keys: Object.keys(req.body || {}).length }));
 app.listen({ port: ${PORT}, host: "127.0.0.1" }).then(() => console.log("READY"));
 `,
   Express: `
@@ -107,6 +281,8 @@ const app = express();
 app.get("/", (req, res) => res.send("Hello World"));
 app.get("/json", (req, res) => res.json({ message: "Hello", framework: "Express" }));
 app.get("/users/:id", (req, res) => res.json({ id: req.params.id, fw: "Express" }));
+app.get("/mem", (req, res) => res.json(process.memoryUsage()));
+app.post("/ingest", express.json({ limit: "1mb" }), (req, res) => res.json({ keys: Object.keys(req.body || {}).length }));
 app.listen(${PORT}, "127.0.0.1", () => console.log("READY"));
 `,
   Hono: `
@@ -116,6 +292,8 @@ const app = new Hono();
 app.get("/", (c) => c.text("Hello World"));
 app.get("/json", (c) => c.json({ message: "Hello", framework: "Hono" }));
 app.get("/users/:id", (c) => c.json({ id: c.req.param("id"), fw: "Hono" }));
+app.get("/mem", (c) => c.json(process.memoryUsage()));
+app.post("/ingest", async (c) => c.json({ keys: Object.keys(await c.req.json()).length }));
 serve({ fetch: app.fetch, port: ${PORT}, hostname: "127.0.0.1" }, () => console.log("READY"));
 `,
 };
@@ -188,10 +366,22 @@ async function runBenchmarks() {
       );
       const paramRes = await benchmark("/users/123", REQUESTS, CONCURRENCY);
 
+      console.log(
+        `     Slow-loris (${LORIS_SOCKETS} sockets, ${LORIS_DURATION / 1000}s)...`,
+      );
+      const loris = await slowLoris(LORIS_SOCKETS, LORIS_DURATION);
+
+      console.log(
+        `     Oversized bodies (${OVERSIZED_REQUESTS} × ${OVERSIZED_BYTES / MB} MB)...`,
+      );
+      const huge = await oversized(OVERSIZED_REQUESTS, OVERSIZED_BYTES);
+
       results[name] = {
         static: calcStats(staticRes),
         json: calcStats(jsonRes),
         params: calcStats(paramRes),
+        loris,
+        huge,
       };
 
       console.log(`     ✅ Done\n`);
@@ -239,6 +429,43 @@ async function runBenchmarks() {
   printTable("📦 JSON Response (GET /json)", "json");
   printTable("🔗 Parameterized (GET /users/:id)", "params");
 
+  const fmt = (n, digits = 1) => (Number.isNaN(n) ? "n/a" : n.toFixed(digits));
+
+  console.log(
+    `\n  🐌 Slow-loris (${LORIS_SOCKETS} sockets dribbling bodies for ${LORIS_DURATION / 1000}s)`,
+  );
+  console.log("  " + "─".repeat(W - 4));
+  console.log(
+    `  ${"Framework".padEnd(12)} │ ${"Δheap during".padEnd(13)} │ ${"Δrss during".padEnd(12)} │ ${"Δheap after".padEnd(12)} │ ${"Closed by srv".padEnd(13)} │ ${"Probe (ms)".padEnd(10)}`,
+  );
+  console.log("  " + "─".repeat(W - 4));
+  for (const [name, data] of Object.entries(results)) {
+    if (!data) continue;
+    const l = data.loris;
+    console.log(
+      `  ${name.padEnd(12)} │ ${(fmt(l.during.heap) + " MB").padEnd(13)} │ ${(fmt(l.during.rss) + " MB").padEnd(12)} │ ${(fmt(l.after.heap) + " MB").padEnd(12)} │ ${String(l.closedByServer).padEnd(13)} │ ${fmt(l.probeMs, 2)}`,
+    );
+  }
+
+  console.log(
+    `\n  🐘 Oversized bodies (${OVERSIZED_REQUESTS} × ${OVERSIZED_BYTES / MB} MB, half declared, half chunked)`,
+  );
+  console.log("  " + "─".repeat(W - 4));
+  console.log(
+    `  ${"Framework".padEnd(12)} │ ${"Responses".padEnd(24)} │ ${"MB sent/req".padEnd(11)} │ ${"Δrss after".padEnd(11)} │ ${"Total (ms)".padEnd(10)} │ ${"Probe (ms)".padEnd(10)}`,
+  );
+  console.log("  " + "─".repeat(W - 4));
+  for (const [name, data] of Object.entries(results)) {
+    if (!data) continue;
+    const h = data.huge;
+    const statuses = Object.entries(h.statuses)
+      .map(([status, n]) => `${status}×${n}`)
+      .join(" ");
+    console.log(
+      `  ${name.padEnd(12)} │ ${statuses.padEnd(24)} │ ${fmt(h.acceptedMb, 2).padEnd(11)} │ ${(fmt(h.after.rss) + " MB").padEnd(11)} │ ${fmt(h.ms, 0).padEnd(10)} │ ${fmt(h.probeMs, 2)}`,
+    );
+  }
+
   console.log("\n" + "═".repeat(W));
   console.log("  📈 COMPARISON SUMMARY (JSON route RPS)");
   console.log("═".repeat(W));
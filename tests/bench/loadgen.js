@@ -0,0 +1,126 @@
+/**
+ * Constant-arrival-rate load generator, forked by run.js.
+ *
+ * Requests go out on a fixed schedule (`rate` per second) whether or not
+ * earlier ones have been answered, and each latency is measured from the
+ * time the request was *due*, not from when a socket was free to send it.
+ * A stalled server therefore shows up as the queueing delay real users
+ * would see, instead of silently slowing the client down (coordinated
+ * omission). Requests beyond `connections` wait in the agent's queue.
+ *
+ * Latencies go into a high-precision Histogram (~0.4%), sent back to the
+ * parent in sparse form so several generators can be merged.
+ */
+import http from "http";
+import { Histogram } from "../../utils/helpers/histogram.js";
+
+// Histogram sub-bucket bits (~0.4% precision)
+const PRECISION = 7;
+
+// Scheduler tick: due requests are sent in a burst every TICK_MS
+const TICK_MS = 1;
+
+/**
+ * @param {Object} config
+ * @param {number} config.port
+ * @param {{ method?: string, path: string, headers?: Object, body?: string }} config.request
+ * @param {number} config.rate - Requests per second
+ * @param {number} config.duration - Measured time (ms)
+ * @param {number} config.warmup - Unmeasured time before it (ms)
+ * @param {number} config.connections - Max open sockets
+ * @param {number} config.timeout - Per-request timeout (ms)
+ */
+function generate(config) {
+  const { port, request, rate, duration, warmup, connections, timeout } =
+    config;
+  const agent = new http.Agent({ keepAlive: true, maxSockets: connections });
+  const payload = request.body === undefined ? null : Buffer.from(request.body);
+  const options = {
+    host: "127.0.0.1",
+    port,
+    method: request.method || "GET",
+    path: request.path,
+    headers: payload
+      ? { ...request.headers, "content-length": payload.length }
+      : request.headers || {},
+    agent,
+  };
+
+  const histogram = new Histogram(PRECISION);
+  const statuses = {};
+  let errors = 0;
+  let inflight = 0;
+  let scheduled = 0;
+  // Worst lag between a request's due time and the tick that sent it
+  let maxLag = 0;
+
+  const interval = 1000 / rate;
+  const start = performance.now();
+  const measureFrom = start + warmup;
+  const total = Math.floor(((warmup + duration) * rate) / 1000);
+
+  return new Promise((resolve) => {
+    const finish = () => {
+      agent.destroy();
+      resolve({
+        scheduled: total - Math.floor((warmup * rate) / 1000),
+        completed: histogram.count,
+        errors,
+        statuses,
+        maxLag: Math.round(maxLag * 1000) / 1000,
+        precision: PRECISION,
+        histogram: histogram.sparse(),
+      });
+    };
+
+    const settle = (due, status) => {
+      inflight--;
+      if (due >= measureFrom) {
+        if (status === 0) {
+          errors++;
+        } else {
+          histogram.record(performance.now() - due);
+          statuses[status] = (statuses[status] || 0) + 1;
+        }
+      }
+      if (scheduled === total && inflight === 0) finish();
+    };
+
+    const send = (due) => {
+      inflight++;
+      let settled = false;
+      const once = (status) => {
+        if (settled) return;
+        settled = true;
+        settle(due, status);
+      };
+      const req = http.request(options, (res) => {
+        res.on("data", () => {});
+        res.on("end", () => once(res.statusCode));
+        res.on("error", () => once(0));
+      });
+      req.on("error", () => once(0));
+      req.setTimeout(timeout, () => req.destroy());
+      req.end(payload);
+    };
+
+    const tick = () => {
+      const now = performance.now();
+      while (scheduled < total) {
+        const due = start + scheduled * interval;
+        if (due > now) break;
+        if (now - due > maxLag) maxLag = now - due;
+        scheduled++;
+        send(due);
+      }
+      if (scheduled < total) setTimeout(tick, TICK_MS);
+      else if (inflight === 0) finish();
+    };
+    tick();
+  });
+}
+
+process.once("message", async (config) => {
+  const result = await generate(config);
+  process.send(result, () => process.exit(0));
+});
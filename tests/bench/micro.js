@@ -0,0 +1,519 @@
+/**
+ * In-process microbenchmarks of the hot-path internals: route matching
+ * (trie, linear, compiled), compiled serializers vs JSON.stringify,
+ * escapeString, parseQuery and compiled query parsers, and LRUCache
+ * get/set.
+ *
+ * Inputs follow realistic distributions (Zipf-skewed route and key
+ * popularity, a share of misses, mixed string lengths) from a seeded
+ * PRNG, so runs are comparable. Each benchmark warms up until its rate
+ * settles, then reports ops/sec as the mean of timed samples with a 95%
+ * confidence interval, and bytes allocated per op (heap delta after a
+ * forced GC) plus the GCs seen while timing.
+ *
+ * The router section also prints the param-route count where the trie
+ * starts beating linear matching: the source of TRIE_THRESHOLD in vibe.js.
+ *
+ * Usage:
+ *   node tests/bench/micro.js [--filter router,cache] [--time 0.5] [--out micro.json]
+ */
+import fs from "fs";
+import v8 from "v8";
+import vm from "vm";
+import { PerformanceObserver } from "perf_hooks";
+import { RouteTrie } from "../../utils/core/trie.js";
+import { PathToRegex } from "../../utils/core/handler.js";
+import { linearMatch } from "../../utils/core/matching.js";
+import {
+  compileSerializer,
+  escapeString,
+} from "../../utils/core/compile-serializer.js";
+import { parseQuery } from "../../utils/native.js";
+import { compileQuery } from "../../utils/core/compile-query.js";
+import { LRUCache } from "../../utils/scaling/cache.js";
+
+function parseArgs(argv) {
+  const args = {};
+  for (let i = 0; i < argv.length; i++) {
+    const arg = argv[i];
+    if (!arg.startsWith("--")) continue;
+    const eq = arg.indexOf("=");
+    if (eq > 0) args[arg.slice(2, eq)] = arg.slice(eq + 1);
+    else args[arg.slice(2)] = argv[++i];
+  }
+  return args;
+}
+
+const args = parseArgs(process.argv.slice(2));
+const filter = args.filter ? args.filter.split(",") : null;
+// Timed seconds per benchmark (after warmup)
+const TIME_MS = (Number(args.time) || 0.5) * 1000;
+const SAMPLES = 20;
+const WARMUP_MIN_MS = 100;
+const WARMUP_MAX_MS = 1000;
+
+// ==========================================
+// Measurement
+// ==========================================
+
+v8.setFlagsFromString("--expose-gc");
+const gc = vm.runInNewContext("gc");
+
+let gcCount = 0;
+new PerformanceObserver((list) => {
+  gcCount += list.getEntries().length;
+}).observe({ entryTypes: ["gc"] });
+
+// Two-sided 95% Student t for df = 1..30
+const T95 = [
+  12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+  2.201, 2.179, 2.16, 2.145, 2.131, 2.12, 2.11, 2.101, 2.093, 2.086, 2.08,
+  2.074, 2.069, 2.064, 2.06, 2.056, 2.052, 2.048, 2.045, 2.042,
+];
+
+// Observed values the optimizer cannot prove unused
+let sink;
+
+/**
+ * A fresh loop per benchmark, so the call to `fn` stays monomorphic
+ * (one shared loop would see every benchmark's function and deopt)
+ */
+function makeLoop() {
+  return new Function(
+    "fn",
+    "n",
+    "let r; for (let i = 0; i < n; i++) r = fn(i); return r;",
+  );
+}
+
+const tick = () => new Promise((r) => setImmediate(r));
+
+/**
+ * @param {(i: number) => any} fn - One operation; `i` picks the input
+ * @returns {Promise<{ ops: number, margin: number, bytes: number, gcs: number }>}
+ */
+async function measure(fn) {
+  const loop = makeLoop();
+
+  // Grow the batch until it takes ~1/SAMPLES of the time budget
+  const target = TIME_MS / SAMPLES;
+  let batch = 16;
+  for (;;) {
+    const start = performance.now();
+    sink = loop(fn, batch);
+    const ms = performance.now() - start;
+    if (ms >= target / 4 || batch >= 1 << 28) {
+      batch = Math.max(1, Math.round((batch * target) / Math.max(ms, 1e-3)));
+      break;
+    }
+    batch *= 4;
+  }
+
+  // Warm up until three consecutive batches agree within 5%
+  const warmStart = performance.now();
+  const recent = [];
+  while (performance.now() - warmStart < WARMUP_MAX_MS) {
+    const start = performance.now();
+    sink = loop(fn, batch);
+    recent.push(performance.now() - start);
+    if (recent.length > 3) recent.shift();
+    if (
+      recent.length === 3 &&
+      performance.now() - warmStart >= WARMUP_MIN_MS &&
+      Math.max(...recent) / Math.min(...recent) < 1.05
+    ) {
+      break;
+    }
+  }
+
+  // Timed samples
+  await tick();
+  const gcsBefore = gcCount;
+  const rates = [];
+  for (let s = 0; s < SAMPLES; s++) {
+    const start = performance.now();
+    sink = loop(fn, batch);
+    rates.push(batch / ((performance.now() - start) / 1000));
+  }
+  await tick(); // deliver GC entries
+  const gcs = gcCount - gcsBefore;
+
+  const mean = rates.reduce((a, b) => a + b, 0) / rates.length;
+  const variance =
+    rates.reduce((a, b) => a + (b - mean) ** 2, 0) / (rates.length - 1);
+  const t = T95[Math.min(rates.length - 1, T95.length) - 1];
+  const margin = (t * Math.sqrt(variance / rates.length)) / mean;
+
+  return { ops: mean, margin, bytes: allocation(loop, fn), gcs };
+}
+
+// Young-generation budget for one allocation probe
+const PROBE_BYTES = 4 * 1024 * 1024;
+
+function heapDelta(loop, fn, n) {
+  gc();
+  const before = v8.getHeapStatistics().used_heap_size;
+  sink = loop(fn, n);
+  return v8.getHeapStatistics().used_heap_size - before;
+}
+
+/**
+ * Bytes allocated per op: heap growth after a forced GC, over a run sized
+ * to stay within the young generation. A collection during the run
+ * shrinks the heap, so a negative delta is retried with a shorter run.
+ * Runs on the already warmed-up loop, so it measures optimized code.
+ */
+function allocation(loop, fn) {
+  const perOp = Math.max(heapDelta(loop, fn, 100) / 100, 1);
+  let n = Math.max(10, Math.min(100000, Math.floor(PROBE_BYTES / perOp)));
+  while (n >= 10) {
+    const delta = heapDelta(loop, fn, n);
+    if (delta >= 0) return Math.round(delta / n);
+    n = Math.floor(n / 4);
+  }
+  return NaN;
+}
+
+// ==========================================
+// Inputs
+// ==========================================
+
+// mulberry32: small seeded PRNG
+function prng(seed) {
+  return () => {
+    seed = (seed + 0x6d2b79f5) | 0;
+    let t = Math.imul(seed ^ (seed >>> 15), 1 | seed);
+    t = (t + Math.imul(t ^ (t >>> 7), 61 | t)) ^ t;
+    return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+  };
+}
+
+/**
+ * `count` indices in [0, n) with Zipf(s) popularity; which index is
+ * popular is shuffled, so it does not follow registration order
+ */
+function zipf(n, count, s = 1.1, seed = 1) {
+  const random = prng(seed);
+  const order = Array.from({ length: n }, (_, i) => i);
+  for (let i = n - 1; i > 0; i--) {
+    const j = Math.floor(random() * (i + 1));
+    [order[i], order[j]] = [order[j], order[i]];
+  }
+  const cdf = new Float64Array(n);
+  let sum = 0;
+  for (let k = 0; k < n; k++) cdf[k] = sum += 1 / (k + 1) ** s;
+  const out = new Array(count);
+  for (let i = 0; i < count; i++) {
+    const x = random() * sum;
+    let lo = 0;
+    let hi = n - 1;
+    while (lo < hi) {
+      const mid = (lo + hi) >> 1;
+      if (cdf[mid] < x) lo = mid + 1;
+      else hi = mid;
+    }
+    out[i] = order[lo];
+  }
+  return out;
+}
+
+// Inputs per benchmark; a power of two so `i & MASK` picks one
+const INPUTS = 4096;
+const MASK = INPUTS - 1;
+
+const RESOURCES = [
+  "users",
+  "posts",
+  "comments",
+  "articles",
+  "products",
+  "orders",
+  "customers",
+  "reviews",
+];
+
+// Param routes shaped like a real API (as in router-benchmark.js)
+function apiRoutes(count) {
+  const routes = [];
+  const seen = new Set();
+  for (let i = 0; routes.length < count; i++) {
+    const version = `v${(i % 4) + 1}`;
+    const a = RESOURCES[i % RESOURCES.length];
+    const b = RESOURCES[Math.floor(i / RESOURCES.length) % RESOURCES.length];
+    const variant = Math.floor(i / 64);
+    let path = `/api/${version}/${a}/:${a}Id/${b}`;
+    if (variant % 2 === 1) path += `/:${b}Key`;
+    if (variant > 1) path += `/x${variant}`;
+    if (seen.has(path)) continue;
+    seen.add(path);
+    routes.push({
+      method: "GET",
+      path,
+      pathRegex: PathToRegex(path).pathRegex,
+      isStatic: false,
+    });
+  }
+  return routes;
+}
+
+// Request paths: Zipf over the routes, 5% misses
+function routePaths(routes) {
+  const random = prng(7);
+  return zipf(routes.length, INPUTS).map((i) =>
+    random() < 0.05
+      ? `/api/v9/unknown/${i}/x`
+      : routes[i].path.replace(/:\w+/g, () => String(1 + (i % 9000))),
+  );
+}
+
+function words(random, min, max) {
+  const len = min + Math.floor(random() * (max - min + 1));
+  let s = "";
+  while (s.length < len) s += Math.floor(random() * 36 ** 6).toString(36);
+  return s.slice(0, len);
+}
+
+// ==========================================
+// Benchmarks
+// ==========================================
+
+const ROUTE_COUNTS = [4, 8, 12, 16, 24, 32, 48, 64, 100, 200];
+
+const suites = {
+  async router() {
+    const results = [];
+    let crossover = null;
+    for (const count of ROUTE_COUNTS) {
+      const routes = apiRoutes(count);
+      const trie = new RouteTrie();
+      for (const route of routes) trie.insert("GET", route.path, route);
+      const compiled = trie.compile();
+      const paths = routePaths(routes);
+
+      const linear = await measure((i) =>
+        linearMatch(routes, "GET", paths[i & MASK]),
+      );
+      const tree = await measure((i) => trie.match("GET", paths[i & MASK]));
+      const gen = await measure((i) => compiled("GET", paths[i & MASK]));
+      results.push(
+        [`linear   ${count} routes`, linear],
+        [`trie     ${count} routes`, tree],
+        [`compiled ${count} routes`, gen],
+      );
+      // First count where the trie is faster beyond both margins
+      if (
+        crossover === null &&
+        tree.ops * (1 - tree.margin) > linear.ops * (1 + linear.margin)
+      ) {
+        crossover = count;
+      }
+    }
+    return { results, crossover };
+  },
+
+  async serializer() {
+    const random = prng(3);
+    const row = (i) => ({
+      id: i,
+      name: words(random, 4, 16),
+      email: `${words(random, 4, 10)}@example.com`,
+      active: random() < 0.5,
+      score: Math.round(random() * 10000) / 100,
+      tags: [words(random, 3, 8), words(random, 3, 8)],
+    });
+    const rowSchema = {
+      type: "object",
+      properties: {
+        id: { type: "integer" },
+        name: { type: "string" },
+        email: { type: "string" },
+        active: { type: "boolean" },
+        score: { type: "number" },
+        tags: { type: "array", items: { type: "string" } },
+      },
+    };
+    const small = Array.from({ length: INPUTS }, (_, i) => row(i));
+    const lists = Array.from({ length: 64 }, (_, i) =>
+      Array.from({ length: 100 }, (_, j) => row(i * 100 + j)),
+    );
+    const one = compileSerializer(rowSchema);
+    const many = compileSerializer({ type: "array", items: rowSchema });
+    return {
+      results: [
+        ["compiled       1 row", await measure((i) => one(small[i & MASK]))],
+        [
+          "JSON.stringify 1 row",
+          await measure((i) => JSON.stringify(small[i & MASK])),
+        ],
+        ["compiled       100 rows", await measure((i) => many(lists[i & 63]))],
+        [
+          "JSON.stringify 100 rows",
+          await measure((i) => JSON.stringify(lists[i & 63])),
+        ],
+      ],
+    };
+  },
+
+  async escape() {
+    const random = prng(5);
+    const dirty = (s) =>
+      s.slice(0, s.length >> 1) + '"\n\\' + s.slice(s.length >> 1);
+    const clean = Array.from({ length: INPUTS }, () =>
+      words(random, 3, random() < 0.9 ? 24 : 400),
+    );
+    const mixed = clean.map((s, i) => (i % 10 === 0 ? dirty(s) : s));
+    return {
+      results: [
+        [
+          "escapeString   clean",
+          await measure((i) => escapeString(clean[i & MASK])),
+        ],
+        [
+          "JSON.stringify clean",
+          await measure((i) => JSON.stringify(clean[i & MASK])),
+        ],
+        [
+          "escapeString   10% escapes",
+          await measure((i) => escapeString(mixed[i & MASK])),
+        ],
+        [
+          "JSON.stringify 10% escapes",
+          await measure((i) => JSON.stringify(mixed[i & MASK])),
+        ],
+      ],
+    };
+  },
+
+  async query() {
+    const random = prng(9);
+    const short = Array.from(
+      { length: INPUTS },
+      (_, i) => `page=${i % 50}&limit=20`,
+    );
+    // Search endpoints: ~20 params, some encoded, a repeated key, a flag
+    const search = Array.from({ length: INPUTS }, (_, i) => {
+      const parts = [`q=${encodeURIComponent(words(random, 3, 12) + " x")}`];
+      for (let k = 0; k < 18; k++) parts.push(`f${k}=${words(random, 1, 8)}`);
+      parts.push(`tag=a&tag=b&debug&sort=-created_at&cursor=${i}`);
+      return parts.join("&");
+    });
+    const typedShort = compileQuery({
+      type: "object",
+      properties: {
+        page: { type: "integer" },
+        limit: { type: "integer" },
+      },
+    });
+    const typedSearch = compileQuery({
+      type: "object",
+      additionalProperties: false,
+      properties: {
+        q: { type: "string" },
+        tag: { type: "array", items: { type: "string" } },
+        sort: { type: "string" },
+        cursor: { type: "integer" },
+      },
+    });
+    return {
+      results: [
+        [
+          "parseQuery 2 params",
+          await measure((i) => parseQuery(short[i & MASK])),
+        ],
+        [
+          "parseQuery 20+ params",
+          await measure((i) => parseQuery(search[i & MASK])),
+        ],
+        [
+          "compiled 2 params (integers)",
+          await measure((i) => typedShort(short[i & MASK])),
+        ],
+        [
+          "compiled 20+ params, 4 kept",
+          await measure((i) => typedSearch(search[i & MASK])),
+        ],
+      ],
+    };
+  },
+
+  async cache() {
+    // 10k distinct URLs with Zipf popularity, cache holding 1k of them
+    const keys = zipf(10000, INPUTS, 1.0, 11).map((k) => `/products/${k}`);
+    const payload = { id: 1, name: "widget", price: 9.99 };
+    const cache = new LRUCache({ max: 1000, ttl: 60_000 });
+    for (let i = 0; i < INPUTS; i++) cache.set(keys[i], payload);
+    let hits = 0;
+    for (let i = 0; i < INPUTS; i++) if (cache.get(keys[i])) hits++;
+    return {
+      results: [
+        ["LRUCache.get (Zipf keys)", await measure((i) => cache.get(keys[i & MASK]))],
+        [
+          "LRUCache.set (with eviction)",
+          await measure((i) => cache.set(keys[i & MASK], payload)),
+        ],
+      ],
+      note: `get hit ratio ${Math.round((hits / INPUTS) * 100)}%`,
+    };
+  },
+};
+
+// ==========================================
+// Report
+// ==========================================
+
+function fmtOps(ops) {
+  if (ops >= 1e6) return `${(ops / 1e6).toFixed(2)}M`;
+  if (ops >= 1e3) return `${(ops / 1e3).toFixed(1)}k`;
+  return ops.toFixed(0);
+}
+
+async function main() {
+  console.log(
+    `Vibe microbenchmarks (Node ${process.version}, ${TIME_MS / 1000}s per benchmark)\n`,
+  );
+  const report = { node: process.version, date: new Date().toISOString() };
+  for (const [name, suite] of Object.entries(suites)) {
+    if (filter && !filter.includes(name)) continue;
+    console.log(`📋 ${name}`);
+    const { results, crossover, note } = await suite();
+    for (const [label, r] of results) {
+      console.log(
+        `  ${label.padEnd(30)} ${fmtOps(r.ops).padStart(8)} ops/s ` +
+          `±${(r.margin * 100).toFixed(1).padStart(4)}%  ` +
+          `${String(r.bytes).padStart(6)} B/op  ${r.gcs} GCs`,
+      );
+    }
+    if (note) console.log(`  (${note})`);
+    if (name === "router") {
+      console.log(
+        crossover === null
+          ? `  Trie never clearly faster up to ${ROUTE_COUNTS.at(-1)} param routes`
+          : `  Trie clearly faster from ${crossover} param routes ` +
+              `(trieThreshold: linear up to the count below it)`,
+      );
+    }
+    console.log("");
+    report[name] = {
+      crossover,
+      note,
+      results: Object.fromEntries(
+        results.map(([label, r]) => [
+          label.replace(/\s+/g, " "),
+          {
+            ops: Math.round(r.ops),
+            margin: Math.round(r.margin * 10000) / 10000,
+            bytesPerOp: r.bytes,
+            gcs: r.gcs,
+          },
+        ]),
+      ),
+    };
+  }
+  if (args.out) {
+    fs.writeFileSync(args.out, JSON.stringify(report, null, 2) + "\n");
+    console.log(`Results written to ${args.out}`);
+  }
+  sink = undefined;
+}
+
+main();
@@ -0,0 +1,274 @@
+/**
+ * Benchmark suite: each scenario (scenarios.js) runs in its own server
+ * process, loaded at a constant arrival rate by separate load generator
+ * processes (loadgen.js), so client overhead never runs on the server's
+ * event loop.
+ *
+ * Usage:
+ *   node tests/bench/run.js [options]
+ *
+ *   --scenario a,b     Only these scenarios (default: all)
+ *   --rate 2000        Requests per second, per scenario
+ *   --duration 10      Measured seconds
+ *   --warmup 2         Unmeasured seconds before that
+ *   --connections 64   Max sockets across all generators
+ *   --clients 1        Load generator processes (share the rate)
+ *   --out file.json    Write results as JSON
+ *   --baseline file    Compare with earlier results; exit 1 on regression
+ *   --threshold 0.15   Allowed p50/p99 growth over the baseline (fraction)
+ *
+ * Compare results from the same machine and settings only: the baseline
+ * records both, and scenarios run at a different rate are not compared.
+ */
+import fs from "fs";
+import os from "os";
+import path from "path";
+import http from "http";
+import { fork } from "child_process";
+import { fileURLToPath } from "url";
+import { Histogram } from "../../utils/helpers/histogram.js";
+import { scenarios } from "./scenarios.js";
+
+const __dirname = path.dirname(fileURLToPath(import.meta.url));
+const ROOT = path.resolve(__dirname, "../..");
+const PORT = 4100;
+
+// Latency growth below this (ms) is never a regression: noise at this scale
+const MIN_DELTA_MS = 0.1;
+// Share of scheduled requests that must complete for the rate to count
+// as sustained
+const SUSTAINED = 0.99;
+
+function parseArgs(argv) {
+  const args = {};
+  for (let i = 0; i < argv.length; i++) {
+    const arg = argv[i];
+    if (!arg.startsWith("--")) continue;
+    const eq = arg.indexOf("=");
+    if (eq > 0) args[arg.slice(2, eq)] = arg.slice(eq + 1);
+    else args[arg.slice(2)] = argv[++i];
+  }
+  return args;
+}
+
+const args = parseArgs(process.argv.slice(2));
+const config = {
+  rate: Number(args.rate) || 2000,
+  duration: (Number(args.duration) || 10) * 1000,
+  warmup: (args.warmup === undefined ? 2 : Number(args.warmup)) * 1000,
+  connections: Number(args.connections) || 64,
+  clients: Number(args.clients) || 1,
+  timeout: 10000,
+};
+const threshold = Number(args.threshold) || 0.15;
+const selected = args.scenario
+  ? args.scenario.split(",")
+  : Object.keys(scenarios);
+
+const wait = (ms) => new Promise((r) => setTimeout(r, ms));
+
+// Any response on the scenario's path means the server is up
+async function waitReady(server, request, deadline = 15000) {
+  const start = Date.now();
+  while (Date.now() - start < deadline) {
+    if (server.exitCode !== null) throw new Error("Server exited");
+    const ok = await new Promise((resolve) => {
+      http
+        .get({ host: "127.0.0.1", port: PORT, path: request.path }, (res) => {
+          res.resume();
+          res.on("end", () => resolve(true));
+        })
+        .on("error", () => resolve(false));
+    });
+    if (ok) return;
+    await wait(100);
+  }
+  throw new Error("Server did not start");
+}
+
+async function stop(child) {
+  if (child.exitCode !== null) return;
+  const exited = new Promise((r) => child.once("exit", r));
+  child.kill("SIGTERM");
+  const timer = setTimeout(() => child.kill("SIGKILL"), 5000);
+  await exited;
+  clearTimeout(timer);
+}
+
+function loadgen(request) {
+  const child = fork(path.join(__dirname, "loadgen.js"));
+  return new Promise((resolve, reject) => {
+    child.once("message", resolve);
+    child.once("error", reject);
+    child.once("exit", (code) => {
+      if (code !== 0) reject(new Error(`Load generator exited with ${code}`));
+    });
+    child.send({
+      port: PORT,
+      request,
+      rate: config.rate / config.clients,
+      duration: config.duration,
+      warmup: config.warmup,
+      connections: Math.max(1, Math.floor(config.connections / config.clients)),
+      timeout: config.timeout,
+    });
+  });
+}
+
+async function runScenario(name) {
+  const scenario = scenarios[name];
+  const server = fork(path.join(__dirname, "server.js"), [name, PORT], {
+    cwd: ROOT,
+    stdio: ["ignore", "ignore", "inherit", "ipc"],
+  });
+  try {
+    await waitReady(server, scenario.request);
+    const parts = await Promise.all(
+      Array.from({ length: config.clients }, () => loadgen(scenario.request)),
+    );
+
+    const histogram = new Histogram(parts[0].precision);
+    const statuses = {};
+    let scheduled = 0;
+    let errors = 0;
+    let maxLag = 0;
+    for (const part of parts) {
+      histogram.mergeSparse(part.histogram);
+      scheduled += part.scheduled;
+      errors += part.errors;
+      maxLag = Math.max(maxLag, part.maxLag);
+      for (const [status, n] of Object.entries(part.statuses)) {
+        statuses[status] = (statuses[status] || 0) + n;
+      }
+    }
+
+    const r = (v) => Math.round(v * 1000) / 1000;
+    return {
+      description: scenario.description,
+      rate: config.rate,
+      scheduled,
+      completed: histogram.count,
+      errors,
+      statuses,
+      achievedRate: Math.round(histogram.count / (config.duration / 1000)),
+      sustained: histogram.count >= scheduled * SUSTAINED,
+      // Client-side scheduling delay; large values mean the generator,
+      // not the server, was the bottleneck (add --clients)
+      maxLag,
+      latency: {
+        mean: r(histogram.mean),
+        p50: r(histogram.percentile(50)),
+        p90: r(histogram.percentile(90)),
+        p99: r(histogram.percentile(99)),
+        p999: r(histogram.percentile(99.9)),
+        max: r(histogram.max),
+      },
+    };
+  } finally {
+    await stop(server);
+  }
+}
+
+/**
+ * Regressions of `current` against `baseline`
+ * @returns {string[]}
+ */
+function compare(current, baseline) {
+  const problems = [];
+  for (const [name, result] of Object.entries(current.scenarios)) {
+    const base = baseline.scenarios[name];
+    if (!base) continue;
+    if (base.rate !== result.rate) {
+      console.log(`  ${name}: rate differs from baseline, not compared`);
+      continue;
+    }
+    if (base.sustained && !result.sustained) {
+      problems.push(`${name}: ${result.rate} req/s no longer sustained`);
+    }
+    if (result.errors > base.errors) {
+      problems.push(`${name}: ${result.errors} errors (was ${base.errors})`);
+    }
+    for (const key of ["p50", "p99"]) {
+      const now = result.latency[key];
+      const was = base.latency[key];
+      if (now > was * (1 + threshold) && now - was > MIN_DELTA_MS) {
+        const pct = Math.round((now / was - 1) * 100);
+        problems.push(`${name}: ${key} ${was}ms -> ${now}ms (+${pct}%)`);
+      }
+    }
+  }
+  return problems;
+}
+
+function printTable(results) {
+  const cols = ["scenario", "req/s", "p50", "p99", "p99.9", "max", "errors"];
+  const rows = Object.entries(results).map(([name, r]) => [
+    r.sustained ? name : `${name} (!)`,
+    String(r.achievedRate),
+    r.latency.p50.toFixed(3),
+    r.latency.p99.toFixed(3),
+    r.latency.p999.toFixed(3),
+    r.latency.max.toFixed(3),
+    String(r.errors),
+  ]);
+  const widths = cols.map((c, i) =>
+    Math.max(c.length, ...rows.map((row) => row[i].length)),
+  );
+  const line = (cells) =>
+    cells
+      .map((c, i) => (i === 0 ? c.padEnd(widths[i]) : c.padStart(widths[i])))
+      .join("  ");
+  console.log(`\n${line(cols)}`);
+  for (const row of rows) console.log(line(row));
+  console.log("\nLatency in ms. (!): rate not sustained.");
+}
+
+async function main() {
+  for (const name of selected) {
+    if (!scenarios[name]) throw new Error(`Unknown scenario "${name}"`);
+  }
+  console.log(
+    `Vibe benchmark: ${config.rate} req/s for ${config.duration / 1000}s ` +
+      `(+${config.warmup / 1000}s warmup), ${config.connections} connections, ` +
+      `${config.clients} client process(es)`,
+  );
+
+  const results = {};
+  for (const name of selected) {
+    process.stdout.write(`  ${name}... `);
+    results[name] = await runScenario(name);
+    console.log(`p99 ${results[name].latency.p99}ms`);
+  }
+  printTable(results);
+
+  const report = {
+    version: 1,
+    date: new Date().toISOString(),
+    node: process.version,
+    platform: `${process.platform}-${process.arch}`,
+    cpus: os.cpus().length,
+    cpuModel: os.cpus()[0]?.model,
+    config,
+    scenarios: results,
+  };
+  if (args.out) {
+    fs.writeFileSync(args.out, JSON.stringify(report, null, 2) + "\n");
+    console.log(`\nResults written to ${args.out}`);
+  }
+
+  if (args.baseline) {
+    const baseline = JSON.parse(fs.readFileSync(args.baseline, "utf8"));
+    console.log(`\nCompared with ${args.baseline} (${baseline.date}):`);
+    const problems = compare(report, baseline);
+    if (problems.length > 0) {
+      for (const p of problems) console.log(`  ❌ ${p}`);
+      process.exit(1);
+    }
+    console.log(`  ✅ No regressions (threshold ${threshold * 100}%)`);
+  }
+}
+
+main().catch((err) => {
+  console.error(err);
+  process.exit(1);
+});
@@ -0,0 +1,150 @@
+/**
+ * Benchmark scenarios, one per subsystem.
+ * Each scenario builds its own app (in the server process, see server.js)
+ * and names the request the load generator sends (see loadgen.js).
+ */
+import { LRUCache, cacheMiddleware } from "../../vibe.js";
+
+// Param routes registered ahead of the target so matching has to search
+function padRoutes(app, count) {
+  for (let i = 0; i < count; i++) {
+    app.get(`/pad${i}/:id`, (req) => ({ id: req.params.id }));
+  }
+}
+
+const rows = Array.from({ length: 100 }, (_, i) => ({
+  id: i,
+  name: `user-${i}`,
+  email: `user${i}@example.com`,
+  active: i % 2 === 0,
+  score: i * 1.5,
+}));
+
+const rowSchema = {
+  type: "array",
+  items: {
+    type: "object",
+    properties: {
+      id: { type: "integer" },
+      name: { type: "string" },
+      email: { type: "string" },
+      active: { type: "boolean" },
+      score: { type: "number" },
+    },
+  },
+};
+
+// ~1 KB JSON body
+const order = JSON.stringify({
+  customer: "c-1042",
+  items: Array.from({ length: 12 }, (_, i) => ({
+    sku: `sku-${i}`,
+    qty: i + 1,
+    price: 9.99,
+  })),
+  note: "leave at the door",
+});
+
+/**
+ * @typedef {Object} Scenario
+ * @property {string} description
+ * @property {(app: import("../../vibe.js").VibeApp) => void} setup
+ * @property {{ method?: string, path: string, headers?: Object, body?: string }} request
+ * @property {number} [workers] - Run the app under clusterize() with this many workers
+ */
+
+/** @type {Record<string, Scenario>} */
+export const scenarios = {
+  "static-route": {
+    description: "Parameterless route (O(1) map lookup), JSON handler",
+    setup(app) {
+      app.get("/hello", () => ({ hello: "world" }));
+    },
+    request: { path: "/hello" },
+  },
+
+  prebuilt: {
+    description: "Static value route (body, headers and ETag prebuilt)",
+    setup(app) {
+      app.get("/prebuilt", { hello: "world" });
+    },
+    request: { path: "/prebuilt" },
+  },
+
+  "linear-route": {
+    description: "Param route behind 12 others (linear matching)",
+    setup(app) {
+      padRoutes(app, 12);
+      app.get("/users/:id", (req) => ({ id: req.params.id }));
+    },
+    request: { path: "/users/42" },
+  },
+
+  "trie-route": {
+    description: "Param route behind 400 others (trie matching)",
+    setup(app) {
+      padRoutes(app, 400);
+      app.get("/users/:id", (req) => ({ id: req.params.id }));
+    },
+    request: { path: "/users/42" },
+  },
+
+  serializer: {
+    description: "100-row array through a compiled response schema",
+    setup(app) {
+      app.get("/rows", { schema: { response: rowSchema } }, () => rows);
+    },
+    request: { path: "/rows" },
+  },
+
+  "json-stringify": {
+    description: "Same 100 rows through JSON.stringify (serializer baseline)",
+    setup(app) {
+      app.get("/rows", () => rows);
+    },
+    request: { path: "/rows" },
+  },
+
+  "body-parser": {
+    description: "POST of a ~1 KB JSON body",
+    setup(app) {
+      app.post("/orders", (req) => ({ items: req.body.items.length }));
+    },
+    request: {
+      method: "POST",
+      path: "/orders",
+      headers: { "content-type": "application/json" },
+      body: order,
+    },
+  },
+
+  cache: {
+    description: "cacheMiddleware hit on a parameterized route",
+    setup(app) {
+      const cache = new LRUCache({ max: 1000, ttl: 60_000 });
+      app.get(
+        "/products/:id",
+        { intercept: cacheMiddleware(cache) },
+        (req) => ({ id: req.params.id, rows }),
+      );
+    },
+    request: { path: "/products/7" },
+  },
+
+  "static-file": {
+    description: "File from the public folder (in-memory manifest)",
+    setup() {},
+    request: { path: "/public/index.html" },
+  },
+
+  cluster: {
+    description: "Param route on 2 cluster workers",
+    setup(app) {
+      app.get("/users/:id", (req) => ({ id: req.params.id }));
+    },
+    request: { path: "/users/42" },
+    workers: 2,
+  },
+};
+
+export default scenarios;
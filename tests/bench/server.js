@@ -0,0 +1,25 @@
+/**
+ * Benchmark server: runs one scenario's app in its own process.
+ * Usage: node tests/bench/server.js <scenario> <port>
+ */
+import vibe, { clusterize } from "../../vibe.js";
+import { scenarios } from "./scenarios.js";
+
+const [name, port] = process.argv.slice(2);
+const scenario = scenarios[name];
+if (!scenario) {
+  console.error(`Unknown scenario "${name}"`);
+  process.exit(1);
+}
+
+function start() {
+  const app = vibe({ logger: false });
+  scenario.setup(app);
+  app.listen(Number(port), "127.0.0.1");
+}
+
+if (scenario.workers) {
+  clusterize(start, { workers: scenario.workers, restart: false });
+} else {
+  start();
+}
@@ -4,6 +4,8 @@
  */
 import { RouteTrie } from "../utils/core/trie.js";
 import { PathToRegex, matchPath } from "../utils/core/handler.js";
+import { Logger } from "../utils/core/logger.js";
+import crypto from "crypto";
 
 // Configuration
 const ROUTE_COUNTS = [10, 50, 100, 500, 1000, 5000];
@@ -133,6 +135,47 @@ const memUsed = (memAfter - memBefore) / 1024 / 1024;
 
 console.log(`Trie memory for 5000 routes: ${memUsed.toFixed(2)} MB`);
 
+// Per-request context setup benchmark
+console.log("\n⏱️  Per-Request Context Setup");
+console.log("-".repeat(40));
+
+const SETUP_ITERATIONS = 200000;
+const LEVELS = { trace: 10, debug: 20, info: 30, warn: 40, error: 50, fatal: 60 };
+
+function benchmarkSetup(label, setup) {
+  const logger = new Logger({ level: "info", stream: { write() {} } });
+  for (let i = 0; i < 10000; i++) setup(logger, {});
+  const start = process.hrtime.bigint();
+  for (let i = 0; i < SETUP_ITERATIONS; i++) setup(logger, {});
+  const ns = Number(process.hrtime.bigint() - start) / SETUP_ITERATIONS;
+  console.log(`${label.padEnd(34)} ${ns.toFixed(1).padStart(8)} ns/req`);
+}
+
+// Eager UUID + child logger per request (old approach)
+benchmarkSetup("Eager randomUUID + child()", (logger, req) => {
+  req.id = crypto.randomUUID();
+  req.log = new Logger({
+    level: Object.keys(LEVELS).find((key) => LEVELS[key] === logger.level),
+    stream: logger.stream,
+    bindings: { ...logger.bindings, reqId: req.id },
+  });
+});
+
+// Lazy counter ID + lazy logger (what reqListener does now)
+let seq = 0;
+benchmarkSetup("Lazy counter (handler never logs)", (logger, req) => {
+  req._seq = ++seq;
+  req._id = undefined;
+  req._log = undefined;
+  req._vibeLogger = logger;
+});
+
+benchmarkSetup("Lazy counter (handler reads req.log)", (logger, req) => {
+  req._seq = ++seq;
+  req._id = "a1b2c3d4-" + req._seq.toString(36);
+  req._log = logger.child({ reqId: req._id });
+});
+
 // Theoretical analysis
 console.log("\n📈 Scalability Analysis");
 console.log("-".repeat(40));
@@ -2,11 +2,15 @@
  * Vibe Framework Live Server Test
  * Starts server and makes actual HTTP requests
  */
-import vibe from "../vibe.js";
+import vibe, { createPool, multipartSink } from "../vibe.js";
+import crypto from "crypto";
 import http from "http";
+import net from "net";
+import { Readable, Writable } from "stream";
+import { streamJson } from "../utils/core/stream-json.js";
 
 const PORT = 3456;
-const app = vibe();
+const app = vibe({ metrics: true });
 
 // Setup routes
 app.get("/", "Hello Vibe!");
@@ -27,6 +31,121 @@ app.get(
   (req, res) => ({ secret: "data" }),
 );
 
+// Streamed responses
+const rowSchema = {
+  type: "array",
+  items: {
+    type: "object",
+    properties: { id: { type: "number" }, name: { type: "string" } },
+  },
+};
+app.get("/rows", { schema: { response: rowSchema } }, () =>
+  Array.from({ length: 5000 }, (_, i) => ({ id: i, name: "row " + i })),
+);
+app.get("/ticks", async function* () {
+  for (let i = 0; i < 3; i++) yield { tick: i };
+});
+app.get("/objects", () => Readable.from([{ a: 1 }, { a: 2 }]));
+
+// Schema-validated body
+app.post(
+  "/signup",
+  {
+    schema: {
+      coerce: true,
+      body: {
+        type: "object",
+        required: ["email"],
+        properties: {
+          email: { type: "string", minLength: 3 },
+          age: { type: "integer", minimum: 0 },
+          plan: { enum: ["free", "pro"], default: "free" },
+        },
+      },
+    },
+  },
+  (req) => ({ user: req.body }),
+);
+
+// Upload sinks
+const sunk = { active: 0, maxActive: 0, bytes: 0 };
+app.post(
+  "/sink",
+  {
+    media: {
+      hash: "sha256",
+      concurrency: 1,
+      sink: () => {
+        sunk.maxActive = Math.max(sunk.maxActive, ++sunk.active);
+        return new Writable({
+          write(chunk, encoding, callback) {
+            sunk.bytes += chunk.length;
+            setTimeout(callback, 20); // slow storage
+          },
+          final(callback) {
+            sunk.active--;
+            callback();
+          },
+        });
+      },
+    },
+  },
+  (req) => ({ files: req.files }),
+);
+const objects = new Map();
+app.post(
+  "/s3",
+  {
+    media: {
+      sink: multipartSink(
+        {
+          create: async (info) => ({ key: info.filename, parts: [] }),
+          uploadPart: async (upload, partNumber, body) => {
+            upload.parts[partNumber - 1] = Buffer.from(body);
+            return `etag-${partNumber}`;
+          },
+          complete: async (upload, parts) => {
+            objects.set(upload.key, Buffer.concat(upload.parts));
+            return { key: upload.key, parts: parts.length };
+          },
+        },
+        { partSize: 1024 },
+      ),
+    },
+  },
+  (req) => ({ files: req.files }),
+);
+
+// Worker thread offload
+app.post("/offload/:kind", { offload: true }, (req) => ({
+  kind: req.params.kind,
+  sum: req.body.numbers.reduce((a, b) => a + b, 0),
+}));
+const double = app.task("double", (n) => n * 2);
+app.get("/double/:n", async (req) => ({ value: await double(+req.params.n) }));
+
+// Load shedding
+const pause = (ms) => new Promise((r) => setTimeout(r, ms));
+app.get(
+  "/limited",
+  { admission: { limit: { initialLimit: 1, maxLimit: 1 }, retryAfter: 2 } },
+  async () => {
+    await pause(50);
+    return { ok: true };
+  },
+);
+const dbPool = createPool({
+  create: async () => ({}),
+  destroy: async () => {},
+  max: 1,
+});
+app.get("/db", { admission: dbPool }, () =>
+  dbPool.use(async () => {
+    await pause(50);
+    return { ok: true };
+  }),
+);
+
 // Plugin with prefix
 await app.register(
   async (app) => {
@@ -59,10 +178,11 @@ function request(method, path, body = null, headers = {}) {
       let data = "";
       res.on("data", (chunk) => (data += chunk));
       res.on("end", () => {
+        const { statusCode: status, headers } = res;
         try {
-          resolve({ status: res.statusCode, body: JSON.parse(data) });
+          resolve({ status, headers, body: JSON.parse(data) });
         } catch {
-          resolve({ status: res.statusCode, body: data });
+          resolve({ status, headers, body: data });
         }
       });
     });
@@ -138,6 +258,213 @@ async function runTests() {
   res = await request("GET", "/nonexistent");
   assert(res.status === 404, "Status 404", `got ${res.status}`);
 
+  // Test 9: Streamed JSON
+  console.log("\n📋 Test 9: Streamed JSON responses");
+  res = await request("GET", "/rows");
+  assert(
+    res.headers["transfer-encoding"] === "chunked" &&
+      res.body.length === 5000 &&
+      res.body[4999].name === "row 4999",
+    "Large schema array streamed in chunks",
+  );
+  res = await request("GET", "/ticks");
+  assert(
+    JSON.stringify(res.body) === '[{"tick":0},{"tick":1},{"tick":2}]',
+    "Async generator serialized incrementally",
+  );
+  res = await request("GET", "/objects");
+  assert(res.body[1]?.a === 2, "Object-mode Readable serialized");
+
+  // Backpressure: no write while the destination is full
+  let overrun = false;
+  const slow = new Writable({
+    highWaterMark: 16,
+    write(chunk, enc, cb) {
+      setTimeout(cb, 1);
+    },
+  });
+  const write = slow.write.bind(slow);
+  slow.write = (chunk) => {
+    if (slow.writableNeedDrain) overrun = true;
+    return write(chunk);
+  };
+  slow.writeHead = () => {};
+  await streamJson(slow, Array.from({ length: 200 }, (_, i) => i), null, 32);
+  assert(!overrun, "Writer waits for drain when the socket is full");
+
+  // Test 10: Body validation
+  console.log("\n📋 Test 10: Schema-validated body POST /signup");
+  res = await request("POST", "/signup", { email: "a@b.c", age: "30" });
+  assert(
+    res.status === 200 &&
+      res.body.user.age === 30 &&
+      res.body.user.plan === "free",
+    "Valid body coerced and defaults filled",
+  );
+  res = await request("POST", "/signup", { age: 3 });
+  assert(
+    res.status === 400 && res.body.message === "body.email is required",
+    "Missing required property rejected with 400",
+  );
+  res = await request("POST", "/signup", { email: "a@b.c", plan: "gold" });
+  assert(res.status === 400, "Value outside enum rejected with 400");
+  res = await new Promise((resolve, reject) => {
+    const req = http.request(
+      {
+        hostname: "127.0.0.1",
+        port: PORT,
+        path: "/signup",
+        method: "POST",
+        headers: { "Content-Type": "application/json" },
+      },
+      (r) => {
+        r.resume();
+        r.on("end", () => resolve({ status: r.statusCode }));
+      },
+    );
+    req.on("error", reject);
+    req.end("{not json");
+  });
+  assert(res.status === 400, "Malformed JSON rejected with 400");
+
+  // Test 11: Body size limits
+  console.log("\n📋 Test 11: Body size limits POST /echo");
+  // Raw socket: write the head (and maybe part of a body), read the reply
+  const rawPost = (head, body = "") =>
+    new Promise((resolve) => {
+      const socket = net.connect(PORT, "127.0.0.1", () =>
+        socket.write(head + body),
+      );
+      let data = "";
+      socket.on("data", (chunk) => (data += chunk));
+      socket.on("error", () => {});
+      socket.on("close", () => resolve(data));
+      setTimeout(() => socket.destroy(), 1000);
+    });
+  let reply = await rawPost(
+    "POST /echo HTTP/1.1\r\nHost: x\r\nContent-Type: application/json\r\n" +
+      "Content-Length: 5000000\r\n\r\n",
+  );
+  assert(
+    reply.startsWith("HTTP/1.1 413"),
+    "Oversized Content-Length rejected before the body is read",
+  );
+  const chunk = "2710\r\n" + " ".repeat(10000) + "\r\n"; // 10000 bytes
+  reply = await rawPost(
+    "POST /echo HTTP/1.1\r\nHost: x\r\nContent-Type: application/json\r\n" +
+      "Transfer-Encoding: chunked\r\n\r\n",
+    chunk.repeat(120),
+  );
+  assert(
+    reply.startsWith("HTTP/1.1 413"),
+    "Chunked body over the byte limit rejected with 413",
+  );
+  res = await request("POST", "/echo", { text: "é".repeat(1000) });
+  assert(
+    res.status === 200 && res.body.received.text.length === 1000,
+    "Multi-byte body under the limit decoded intact",
+  );
+
+  // Test 12: Upload sinks
+  console.log("\n📋 Test 12: Upload sinks POST /sink, /s3");
+  const upload = (path, name, content) => {
+    const form = new FormData();
+    form.append("file", new Blob([content], { type: "text/plain" }), name);
+    return fetch(`http://127.0.0.1:${PORT}${path}`, {
+      method: "POST",
+      body: form,
+    }).then((r) => r.json());
+  };
+  const payload = "sink-data ".repeat(50);
+  const sinkReplies = await Promise.all(
+    ["a.txt", "b.txt", "c.txt"].map((name) => upload("/sink", name, payload)),
+  );
+  const [first] = sinkReplies[0].files;
+  assert(
+    first.size === payload.length &&
+      first.hash ===
+        crypto.createHash("sha256").update(payload).digest("hex"),
+    "Writable sink reports inline size and sha256",
+  );
+  assert(
+    sunk.bytes === payload.length * 3 && sunk.maxActive === 1,
+    "concurrency: 1 writes one file at a time across requests",
+  );
+  const big = "0123456789".repeat(300);
+  const s3Reply = await upload("/s3", "big.txt", big);
+  assert(
+    s3Reply.files[0].parts === 3 &&
+      objects.get("big.txt")?.toString() === big,
+    "Multipart sink uploads fixed-size parts and completes",
+  );
+
+  // Test 13: Worker thread offload
+  console.log("\n📋 Test 13: Offloaded handlers POST /offload/:kind");
+  res = await request("POST", "/offload/total", { numbers: [1, 2, 3] });
+  assert(
+    res.status === 200 && res.body.kind === "total" && res.body.sum === 6,
+    "Offloaded handler gets params and body, returns the response",
+  );
+  res = await request("GET", "/double/21");
+  assert(res.body.value === 42, "app.task() runner resolves on a worker");
+  assert(app.tasks.stats.completed === 2, "Pool stats count offloaded work");
+
+  // Test 14: Load shedding
+  console.log("\n📋 Test 14: Load shedding GET /limited, /db");
+  let results = await Promise.all(
+    [1, 2, 3].map(() => request("GET", "/limited")),
+  );
+  let statuses = results.map((r) => r.status).sort();
+  assert(
+    statuses.join() === "200,503,503",
+    "Requests over the concurrency limit get a 503",
+  );
+  assert(
+    results.find((r) => r.status === 503).headers["retry-after"] === "2",
+    "Shed responses carry Retry-After",
+  );
+  res = await request("GET", "/limited");
+  assert(res.status === 200, "Slots are returned when responses finish");
+
+  results = await Promise.all([1, 2, 3].map(() => request("GET", "/db")));
+  statuses = results.map((r) => r.status).sort();
+  assert(
+    statuses.join() === "200,200,503",
+    "Routes tied to a pool shed while it has callers queued",
+  );
+
+  // Test 15: Metrics
+  console.log("\n📋 Test 15: Metrics GET /metrics");
+  await request("GET", "/no-such-route");
+  res = await request("GET", "/metrics");
+  assert(
+    res.status === 200 && res.headers["content-type"].startsWith("text/plain"),
+    "Metrics served in the Prometheus text format",
+  );
+  assert(
+    res.body.includes(
+      'vibe_http_requests_total{route="GET /users/:id",status="2xx"} 1\n',
+    ),
+    "Requests counted per route pattern and status class",
+  );
+  assert(
+    /vibe_http_requests_total\{route="unmatched",status="4xx"\} [1-9]/.test(
+      res.body,
+    ) &&
+      res.body.includes(
+        'vibe_http_request_duration_seconds_count{route="GET /json"} 1\n',
+      ),
+    "Unmatched requests and latency histograms are recorded",
+  );
+  res = await request("GET", "/metrics", null, {
+    Accept: "application/openmetrics-text",
+  });
+  assert(
+    res.headers["content-type"].startsWith("application/openmetrics-text") &&
+      res.body.endsWith("# EOF\n"),
+    "OpenMetrics format on request",
+  );
+
   // Summary
   console.log("\n" + "=".repeat(50));
   console.log(`📊 Live Test Results: ${passed} passed, ${failed} failed`);
@@ -1,6 +1,9 @@
 import vibe from "../vibe.js";
 import { Logger, createLogger } from "../utils/core/logger.js";
 import http from "http";
+import fs from "fs";
+import os from "os";
+import path from "path";
 
 let passed = 0;
 let failed = 0;
@@ -88,7 +91,94 @@ async function runTests() {
     assertEqual(parsed.reqId, "123");
   });
 
-  console.log("\n📋 2. Server Integration\n");
+  await test("Rebound keys appear once per line", async () => {
+    stream.clear();
+    const parent = createLogger({ bindings: { app: "vibe" }, stream });
+    parent.child({ reqId: "1" }).child({ reqId: "2" }).info("nested");
+    parent.child({ reqId: "3" }).info({ app: "record" }, "collision");
+    const [nested, collision] = stream.getLines();
+    assertEqual(nested.split('"reqId"').length, 2, "Nested child:");
+    assertEqual(JSON.parse(nested).reqId, "2");
+    assertEqual(collision.split('"app"').length, 2, "Record key:");
+    assertEqual(JSON.parse(collision).app, "record");
+  });
+
+  console.log("\n📋 2. Buffered Destinations\n");
+
+  await test("Buffered logger batches records until flush()", async () => {
+    stream.clear();
+    const logger = createLogger({ stream, buffer: { size: 4096, interval: 10000 } });
+    logger.info("one");
+    logger.child({ reqId: "r1" }).info({ n: 2 }, "two");
+    assertEqual(stream.buffer.length, 0, "No write before flush.");
+
+    logger.flush();
+    assertEqual(stream.buffer.length, 1, "One batched write.");
+    const lines = stream.getLines().map((l) => JSON.parse(l));
+    assertEqual(lines.length, 2);
+    assertEqual(lines[1].reqId, "r1");
+    assertEqual(lines[1].n, 2);
+    assertEqual(lines[1].msg, "two");
+  });
+
+  await test("Buffered logger flushes on size and time thresholds", async () => {
+    stream.clear();
+    const logger = createLogger({ stream, buffer: { size: 512, interval: 30 } });
+    for (let i = 0; i < 20; i++) logger.info({ i }, "filler line for size threshold");
+    if (stream.buffer.length === 0) throw new Error("Size threshold did not flush");
+
+    logger.flush();
+    stream.clear();
+    logger.info("late");
+    await new Promise((r) => setTimeout(r, 80));
+    assertEqual(JSON.parse(stream.getLines()[0]).msg, "late");
+  });
+
+  await test("Worker sink writes batches to a file descriptor", async () => {
+    const file = path.join(os.tmpdir(), `vibe-log-${process.pid}.ndjson`);
+    const fd = fs.openSync(file, "w");
+    const logger = createLogger({ stream: { fd }, buffer: { size: 256, worker: true } });
+    for (let i = 0; i < 50; i++) logger.info({ i }, "worker line");
+    logger.flush();
+
+    const lines = fs.readFileSync(file, "utf8").split("\n").filter(Boolean);
+    fs.closeSync(fd);
+    fs.unlinkSync(file);
+    assertEqual(lines.length, 50);
+    assertEqual(JSON.parse(lines[49]).i, 49);
+  });
+
+  await test("Sink with an fd writes every batch through it, in order", async () => {
+    const file = path.join(os.tmpdir(), `vibe-log-fd-${process.pid}.ndjson`);
+    const fd = fs.openSync(file, "w");
+    let streamWrites = 0;
+    const target = { fd, write: () => streamWrites++ };
+    const logger = createLogger({ stream: target, buffer: { size: 256 } });
+    for (let i = 0; i < 20; i++) logger.info({ i }, "fd line");
+    logger.info({ i: 20, pad: "x".repeat(300) }, "oversized");
+    logger.info({ i: 21 }, "tail");
+    logger.flush();
+
+    const lines = fs.readFileSync(file, "utf8").split("\n").filter(Boolean);
+    fs.closeSync(fd);
+    fs.unlinkSync(file);
+    assertEqual(streamWrites, 0, "Stream write() calls:");
+    assertEqual(lines.map((l) => JSON.parse(l).i).join(), [...Array(22).keys()].join());
+  });
+
+  await test("Buffered records are flushed on process.exit", async () => {
+    const { execFileSync } = await import("child_process");
+    const script = `
+      import { createLogger } from ${JSON.stringify(new URL("../utils/core/logger.js", import.meta.url).href)};
+      const logger = createLogger({ buffer: { interval: 60000 } });
+      logger.info("before exit");
+      process.exit(0);
+    `;
+    const out = execFileSync(process.execPath, ["--input-type=module", "-e", script]);
+    assertEqual(JSON.parse(out.toString().trim()).msg, "before exit");
+  });
+
+  console.log("\n📋 3. Server Integration\n");
 
   await test("Lifecycle requests generate fastify json styling natively", async () => {
     stream.clear();
@@ -134,6 +224,34 @@ async function runTests() {
     assertEqual(l4.statusCode, 500);
   });
 
+  await test("Request IDs are unique and bound into req.log lines", async () => {
+    stream.clear();
+    const app = vibe({ logger: { stream } });
+
+    app.get("/id", (req) => {
+      req.log.info("with id");
+      return { id: req.id };
+    });
+
+    await new Promise((resolve) => app.listen(8766, "127.0.0.1", resolve));
+
+    const a = await (await fetch("http://127.0.0.1:8766/id")).json();
+    const b = await (await fetch("http://127.0.0.1:8766/id")).json();
+    if (!a.id || a.id === b.id) throw new Error("IDs must be unique");
+
+    const lines = stream.getLines().map((l) => JSON.parse(l));
+    assertEqual(lines[0].reqId, a.id);
+    assertEqual(lines[1].reqId, b.id);
+  });
+
+  await test("Silent logger is its own child (no per-request allocation)", async () => {
+    const silent = createLogger({ level: "silent", stream });
+    stream.clear();
+    assertEqual(silent.child({ reqId: "x" }), silent);
+    silent.error("never written");
+    assertEqual(stream.getLines().length, 0);
+  });
+
   console.log("\n" + "=".repeat(50));
   console.log(`📊 Results: ${passed} passed, ${failed} failed`);
   console.log("=".repeat(50));
@@ -5,11 +5,18 @@
 
 import vibe, { LRUCache, cacheMiddleware } from "../vibe.js";
 import fs from "fs";
+import os from "os";
 import path from "path";
+import http2 from "http2";
+import https from "https";
+import { spawnSync } from "child_process";
 
 const PORT = 4567;
 const BASE = `http://localhost:${PORT}`;
 let server;
+// Stale-while-revalidate route: handler calls / interceptor runs
+let swrVersion = 0;
+let swrTagged = 0;
 
 // Test results
 let passed = 0;
@@ -63,6 +70,14 @@ async function setup() {
   app.decorate("version", "2.0.0");
   app.decorateRequest("startTime", () => Date.now());
 
+  // Lazy factory, assignable decorator, reply method
+  let sessionsMade = 0;
+  app.decorateRequest("session", () => ({ n: ++sessionsMade }));
+  app.decorateRequest("user", null);
+  app.decorateReply("wrapped", function (data) {
+    this.json({ wrapped: data });
+  });
+
   // ============================================
   // ROUTES FOR TESTING
   // ============================================
@@ -72,6 +87,10 @@ async function setup() {
   app.get("/json", { message: "Hello JSON" });
   app.get("/number", 42);
   app.get("/array", [1, 2, 3]);
+  // Returned strings are text on every kind of route, sync or async
+  app.get("/greet/:name", (req) => `hi ${req.params.name}`);
+  app.get("/greet-async", async () => "hi async");
+  app.post("/greet", () => "hi post");
 
   // Route parameters
   app.get("/users/:id", (req) => ({ id: req.params.id }));
@@ -92,6 +111,25 @@ async function setup() {
     path: req.query.path || "",
   }));
 
+  // Schema-typed query
+  app.get(
+    "/typed-search",
+    {
+      schema: {
+        querystring: {
+          type: "object",
+          required: ["q"],
+          properties: {
+            q: { type: "string" },
+            page: { type: "integer", minimum: 1, default: 1 },
+            tag: { type: "array", items: { type: "string" } },
+          },
+        },
+      },
+    },
+    (req) => req.query,
+  );
+
   // POST with body
   app.post("/echo", (req) => ({ received: req.body }));
 
@@ -153,11 +191,49 @@ async function setup() {
     log2: req.log2,
   }));
 
+  // Global interceptors (sync and Express-style) and per-route opt-outs
+  const stamp = (req, res) => {
+    res.setHeader("x-stamp", "1");
+  };
+  const viaNext = (req, res, next) => {
+    req.viaNext = true;
+    next();
+  };
+  app.plugin(stamp);
+  app.plugin(viaNext);
+
+  app.get("/skip-stamp", { skipInterceptors: stamp }, (req) => ({
+    viaNext: req.viaNext === true,
+  }));
+  app.get("/skip-globals", { skipInterceptors: true }, (req) => ({
+    viaNext: req.viaNext === true,
+  }));
+  app.get(
+    "/deferred-next",
+    { intercept: (req, res, next) => setTimeout(next, 5) },
+    (req) => ({ viaNext: req.viaNext === true }),
+  );
+  app.get(
+    "/next-error",
+    { intercept: (req, res, next) => next(new Error("Rejected")) },
+    () => "unreachable",
+  );
+
   // Error handling
   app.get("/error", () => {
     throw new Error("Test error");
   });
 
+  app.get("/session", (req) => {
+    const first = req.session;
+    return { same: req.session === first, made: sessionsMade };
+  });
+  app.get("/no-session", () => ({ made: sessionsMade }));
+  app.get("/user", { intercept: (req) => (req.user = { id: 7 }) }, (req) => ({
+    id: req.user.id,
+  }));
+  app.get("/wrapped", (req, res) => res.wrapped(req.user));
+
   // Decorator access
   app.get("/decorated", (req) => ({
     version: app.decorators.version,
@@ -169,6 +245,12 @@ async function setup() {
     res.sendHtml("test.html");
   });
 
+  // Written after the static scan: sendFile has to find it on disk
+  app.get("/fresh-file", (req, res) => {
+    fs.writeFileSync("public/test-fresh.txt", "fresh");
+    res.sendFile("test-fresh.txt");
+  });
+
   app.get("/redirect", (req, res) => {
     res.redirect("/json", 302);
   });
@@ -183,6 +265,7 @@ async function setup() {
     async (api) => {
       api.get("/status", { status: "ok" });
       api.get("/health", { healthy: true });
+      api.get("/version", "v1.2.3");
     },
     { prefix: "/api" },
   );
@@ -209,6 +292,23 @@ async function setup() {
     random: Math.random(),
   }));
 
+  // Caching - stale-while-revalidate refresh through the route pipeline
+  const cacheSwr = new LRUCache({ max: 100, ttl: 200 });
+  app.get(
+    "/swr/:id",
+    {
+      intercept: [
+        cacheMiddleware(cacheSwr, { staleWhileRevalidate: 60000 }),
+        // Interceptor after the cache: must run for refreshes too
+        (req, res) => {
+          swrTagged++;
+          res.setHeader("x-tagged", "1");
+        },
+      ],
+    },
+    () => `v${++swrVersion}`,
+  );
+
   return new Promise((resolve) => {
     server = app.listen(PORT, "127.0.0.1", () => {
       console.log(`\n🧪 Test server running on port ${PORT}\n`);
@@ -244,6 +344,18 @@ async function runTests() {
     assertEqual(json, 42);
   });
 
+  await test("Returned strings are text, sync or async", async () => {
+    for (const [path, method, body] of [
+      ["/greet/ann", "GET", "hi ann"],
+      ["/greet-async", "GET", "hi async"],
+      ["/greet", "POST", "hi post"],
+    ]) {
+      const res = await fetch(`${BASE}${path}`, { method });
+      assertEqual(res.headers.get("content-type"), "text/plain");
+      assertEqual(await res.text(), body);
+    }
+  });
+
   await test("GET /array returns array", async () => {
     const res = await fetch(`${BASE}/array`);
     const json = await res.json();
@@ -290,6 +402,24 @@ async function runTests() {
     assertEqual(json.page, 1);
   });
 
+  await test("Typed query with schema.querystring", async () => {
+    const res = await fetch(`${BASE}/typed-search?q=a+b&page=3&tag=x&tag=y`);
+    const json = await res.json();
+    assertEqual(json.q, "a b");
+    assertEqual(json.page, 3);
+    assertEqual(json.tag.join(","), "x,y");
+    const defaults = await (await fetch(`${BASE}/typed-search?q=z`)).json();
+    assertEqual(defaults.page, 1);
+  });
+
+  await test("Invalid typed query gets 400", async () => {
+    const missing = await fetch(`${BASE}/typed-search?page=2`);
+    assertEqual(missing.status, 400);
+    assertEqual((await missing.json()).message, "query.q is required");
+    const bad = await fetch(`${BASE}/typed-search?q=z&page=0`);
+    assertEqual(bad.status, 400);
+  });
+
   console.log("\n📋 4. POST & BODY PARSING\n");
 
   await test("POST with JSON body", async () => {
@@ -336,6 +466,40 @@ async function runTests() {
     assertEqual(json.log2, true);
   });
 
+  await test("Global interceptors run on every route", async () => {
+    const res = await fetch(`${BASE}/multi-intercept`);
+    assertEqual(res.headers.get("x-stamp"), "1");
+    const missing = await fetch(`${BASE}/no-such-route`);
+    assertEqual(missing.status, 404);
+    assertEqual(missing.headers.get("x-stamp"), "1", "404:");
+  });
+
+  await test("Route skips one global interceptor", async () => {
+    const res = await fetch(`${BASE}/skip-stamp`);
+    assertEqual(res.headers.get("x-stamp"), null);
+    const json = await res.json();
+    assertEqual(json.viaNext, true);
+  });
+
+  await test("Route skips all global interceptors", async () => {
+    const res = await fetch(`${BASE}/skip-globals`);
+    assertEqual(res.headers.get("x-stamp"), null);
+    const json = await res.json();
+    assertEqual(json.viaNext, false);
+  });
+
+  await test("Express-style next() called later", async () => {
+    const res = await fetch(`${BASE}/deferred-next`);
+    assertEqual(res.status, 200);
+    const json = await res.json();
+    assertEqual(json.viaNext, true);
+  });
+
+  await test("Express-style next(err) stops the chain", async () => {
+    const res = await fetch(`${BASE}/next-error`);
+    assertEqual(res.status, 500);
+  });
+
   console.log("\n📋 6. FILE UPLOADS\n");
 
   await test("File upload success (small file)", async () => {
@@ -402,6 +566,31 @@ async function runTests() {
     assertEqual(json.status, "ok");
   });
 
+  await test("Prebuilt route sends length, type and ETag", async () => {
+    const res = await fetch(`${BASE}/api/status`);
+    assertEqual(res.headers.get("content-type"), "application/json");
+    assertEqual(res.headers.get("content-length"), "15");
+    assertIncludes(res.headers.get("etag") || "", '"');
+    const text = await fetch(`${BASE}/api/version`);
+    assertEqual(text.headers.get("content-type"), "text/plain");
+    assertEqual(await text.text(), "v1.2.3");
+  });
+
+  await test("Prebuilt route answers If-None-Match with 304", async () => {
+    const first = await fetch(`${BASE}/api/health`);
+    const etag = first.headers.get("etag");
+    const res = await fetch(`${BASE}/api/health`, {
+      headers: { "If-None-Match": etag },
+    });
+    assertEqual(res.status, 304);
+    assertEqual(res.headers.get("etag"), etag);
+    assertEqual(await res.text(), "");
+    const other = await fetch(`${BASE}/api/status`, {
+      headers: { "If-None-Match": etag },
+    });
+    assertEqual(other.status, 200, "Other route's ETag:");
+  });
+
   await test("Nested plugin prefix", async () => {
     const res = await fetch(`${BASE}/api/v1/info`);
     assertEqual(res.status, 200);
@@ -423,6 +612,37 @@ async function runTests() {
     assertEqual(json.hasStartTime, true);
   });
 
+  await test("Factory decorator runs once, on first read", async () => {
+    const before = (await (await fetch(`${BASE}/no-session`)).json()).made;
+    const after = (await (await fetch(`${BASE}/no-session`)).json()).made;
+    assertEqual(after, before, "unread factory ran:");
+    const json = await (await fetch(`${BASE}/session`)).json();
+    assertEqual(json.same, true);
+    assertEqual(json.made, before + 1);
+  });
+
+  await test("Request decorator is assignable per request", async () => {
+    const json = await (await fetch(`${BASE}/user`)).json();
+    assertEqual(json.id, 7);
+    const res = await fetch(`${BASE}/wrapped`);
+    assertEqual((await res.json()).wrapped, null, "default restored:");
+  });
+
+  await test("Reply decorator function is a method", async () => {
+    const res = await fetch(`${BASE}/wrapped`);
+    assertEqual(res.headers.get("content-type"), "application/json");
+  });
+
+  await test("Decorator clashing with a built-in throws", async () => {
+    let threw = false;
+    try {
+      vibe().decorateReply("json", () => {});
+    } catch {
+      threw = true;
+    }
+    assertEqual(threw, true);
+  });
+
   console.log("\n📋 9. RESPONSE METHODS\n");
 
   await test("sendHtml sends HTML file", async () => {
@@ -432,6 +652,16 @@ async function runTests() {
     assertIncludes(text, "<h1>Test</h1>");
   });
 
+  await test("sendFile serves a file written after the scan", async () => {
+    try {
+      const res = await fetch(`${BASE}/fresh-file`);
+      assertEqual(res.status, 200);
+      assertEqual(await res.text(), "fresh");
+    } finally {
+      fs.rmSync("public/test-fresh.txt", { force: true });
+    }
+  });
+
   await test("redirect sends 302", async () => {
     const res = await fetch(`${BASE}/redirect`, { redirect: "manual" });
     assertEqual(res.status, 302);
@@ -480,6 +710,24 @@ async function runTests() {
     }
   });
 
+  await test("Stale refresh keeps the route's content-type and body", async () => {
+    const get = async () => {
+      const res = await fetch(`${BASE}/swr/1`);
+      return [
+        res.headers.get("x-cache"),
+        res.headers.get("content-type"),
+        await res.text(),
+      ].join(" ");
+    };
+    assertEqual(await get(), "MISS text/plain v1");
+    assertEqual(await get(), "HIT text/plain v1");
+    await new Promise((r) => setTimeout(r, 250));
+    assertEqual(await get(), "STALE text/plain v1");
+    await new Promise((r) => setTimeout(r, 10));
+    assertEqual(await get(), "HIT text/plain v2");
+    assertEqual(swrTagged, 2, "Later interceptors run for the refresh");
+  });
+
   await test("Same query string returns cached response", async () => {
     const res1 = await fetch(`${BASE}/cached-query?page=42`);
     const json1 = await res1.json();
@@ -505,6 +753,266 @@ async function runTests() {
     const allOk = responses.every((r) => r.status === 200);
     if (!allOk) throw new Error("Some requests failed");
   });
+
+  console.log("\n📋 13. HTTPS & HTTP/2\n");
+  await protocolTests();
+
+  console.log("\n📋 14. TRACING\n");
+  await tracingTests();
+}
+
+// One request over an HTTP/2 session: [status, headers, body]
+function h2Request(session, path, method = "GET", body) {
+  return new Promise((resolve, reject) => {
+    const headers = { ":path": path, ":method": method };
+    if (body !== undefined) headers["content-type"] = "application/json";
+    const stream = session.request(headers);
+    let data = "";
+    let head;
+    stream.setEncoding("utf8");
+    stream.on("response", (h) => (head = h));
+    stream.on("data", (chunk) => (data += chunk));
+    stream.on("end", () => resolve([head[":status"], head, data]));
+    stream.on("error", reject);
+    stream.end(body);
+  });
+}
+
+// Self-signed certificate for 127.0.0.1 (null when openssl is missing)
+function selfSignedCert() {
+  const dir = fs.mkdtempSync(path.join(os.tmpdir(), "vibe-tls-"));
+  const key = path.join(dir, "key.pem");
+  const cert = path.join(dir, "cert.pem");
+  const result = spawnSync(
+    "openssl",
+    [
+      "req",
+      "-x509",
+      "-newkey",
+      "ec",
+      "-pkeyopt",
+      "ec_paramgen_curve:prime256v1",
+      "-nodes",
+      "-keyout",
+      key,
+      "-out",
+      cert,
+      "-days",
+      "1",
+      "-subj",
+      "/CN=localhost",
+    ],
+    { stdio: "ignore" },
+  );
+  const tls =
+    result.status === 0
+      ? { key: fs.readFileSync(key), cert: fs.readFileSync(cert) }
+      : null;
+  fs.rmSync(dir, { recursive: true, force: true });
+  return tls;
+}
+
+function protocolApp(config) {
+  const app = vibe({ logger: false, maxJsonSize: 100, ...config });
+  app.decorateRequest("lazy", () => "decorated");
+  app.plugin((req, res) => {
+    res.setHeader("x-global", "1");
+  });
+  app.get("/info", (req) => ({
+    version: req.httpVersion,
+    q: req.query.q,
+    lazy: req.lazy,
+  }));
+  app.get("/text", () => "plain");
+  app.get("/items/:id", (req, res) => res.json({ id: req.params.id }));
+  app.post("/echo", (req) => req.body);
+  return app;
+}
+
+const listening = (app, port) =>
+  new Promise((resolve) => app.listen(port, "127.0.0.1", resolve));
+
+async function protocolTests() {
+  // Cleartext HTTP/2 (h2c, prior knowledge)
+  await listening(protocolApp({ http2: true }), PORT + 1);
+  const h2c = http2.connect(`http://127.0.0.1:${PORT + 1}`);
+
+  await test("h2c: JSON, query and decorators", async () => {
+    const [status, head, body] = await h2Request(h2c, "/info?q=1");
+    assertEqual(status, 200);
+    assertEqual(head["content-type"], "application/json");
+    assertEqual(head["x-global"], "1");
+    const json = JSON.parse(body);
+    assertEqual(json.version, "2.0");
+    assertEqual(json.q, "1");
+    assertEqual(json.lazy, "decorated");
+  });
+
+  await test("h2c: params, text and response helpers", async () => {
+    const [, head, text] = await h2Request(h2c, "/text");
+    assertEqual(head["content-type"], "text/plain");
+    assertEqual(text, "plain");
+    const [status, , body] = await h2Request(h2c, "/items/9");
+    assertEqual(status, 200);
+    assertEqual(JSON.parse(body).id, "9");
+    const [missing] = await h2Request(h2c, "/nope");
+    assertEqual(missing, 404);
+  });
+
+  await test("h2c: body parsing and 413", async () => {
+    const [status, , body] = await h2Request(h2c, "/echo", "POST", '{"a":1}');
+    assertEqual(status, 200);
+    assertEqual(JSON.parse(body).a, 1);
+    const big = JSON.stringify({ pad: "x".repeat(200) });
+    const [tooLarge] = await h2Request(h2c, "/echo", "POST", big);
+    assertEqual(tooLarge, 413);
+  });
+  h2c.close();
+
+  const tls = selfSignedCert();
+  if (!tls) {
+    console.log("  ⏭️  openssl not found, skipping TLS tests");
+    return;
+  }
+  const agent = new https.Agent({ rejectUnauthorized: false });
+  const httpsGet = (port, p) =>
+    new Promise((resolve, reject) => {
+      https
+        .get({ host: "127.0.0.1", port, path: p, agent }, (res) => {
+          let data = "";
+          res.on("data", (c) => (data += c));
+          res.on("end", () => resolve([res.statusCode, data]));
+        })
+        .on("error", reject);
+    });
+
+  await listening(protocolApp({ https: tls }), PORT + 2);
+  await test("HTTPS serves HTTP/1.1", async () => {
+    const [status, body] = await httpsGet(PORT + 2, "/info?q=tls");
+    assertEqual(status, 200);
+    assertEqual(JSON.parse(body).version, "1.1");
+    assertEqual(JSON.parse(body).q, "tls");
+  });
+
+  await listening(protocolApp({ https: tls, http2: true }), PORT + 3);
+  await test("HTTP/2 over TLS", async () => {
+    const session = http2.connect(`https://127.0.0.1:${PORT + 3}`, {
+      rejectUnauthorized: false,
+    });
+    const [status, , body] = await h2Request(session, "/info");
+    session.close();
+    assertEqual(status, 200);
+    assertEqual(JSON.parse(body).version, "2.0");
+  });
+
+  await test("HTTP/2 server falls back to HTTP/1.1", async () => {
+    const [status, body] = await httpsGet(PORT + 3, "/info");
+    assertEqual(status, 200);
+    assertEqual(JSON.parse(body).version, "1.1");
+  });
+  agent.destroy();
+}
+
+async function tracingTests() {
+  const spans = [];
+  const hooks = [];
+  const hook = (name) => (req, ms) => {
+    if (typeof ms === "number" && req.url) hooks.push(name);
+  };
+  const app = vibe({
+    logger: false,
+    trace: {
+      onSpan: (span) => spans.push(span),
+      onRoute: hook("onRoute"),
+      onBodyParsed: hook("onBodyParsed"),
+      onHandler: hook("onHandler"),
+      onSerialize: hook("onSerialize"),
+    },
+  });
+  app.plugin(() => {});
+  app.post(
+    "/traced/:id",
+    {
+      schema: {
+        body: { type: "object", properties: { n: { type: "number" } } },
+      },
+    },
+    async (req) => ({ id: req.params.id, n: req.body.n }),
+  );
+  await listening(app, PORT + 4);
+  const url = `http://127.0.0.1:${PORT + 4}`;
+  // Spans are reported once the response has closed
+  const settled = () => new Promise((r) => setTimeout(r, 20));
+  const post = (headers = {}) =>
+    fetch(`${url}/traced/7`, {
+      method: "POST",
+      headers: { "content-type": "application/json", ...headers },
+      body: '{"n":1}',
+    });
+
+  await test("Tracing is off unless configured", async () => {
+    assertEqual(vibe({ logger: false }).tracer, null);
+  });
+
+  await test("Phase hooks run for a traced request", async () => {
+    const res = await post();
+    assertEqual((await res.json()).n, 1);
+    await settled();
+    assertEqual(
+      hooks.join(),
+      "onRoute,onBodyParsed,onHandler,onSerialize",
+      "Hooks:",
+    );
+  });
+
+  await test("Spans: server span with one child per phase", async () => {
+    const server = spans.find((s) => s.kind === 2);
+    if (!server) throw new Error("No server span");
+    assertEqual(server.name, "POST /traced/:id");
+    assertEqual(server.parentSpanId, "");
+    if (!/^[0-9a-f]{32}$/.test(server.traceId)) throw new Error("traceId");
+    const attrs = Object.fromEntries(
+      server.attributes.map((a) => [a.key, Object.values(a.value)[0]]),
+    );
+    assertEqual(attrs["http.route"], "/traced/:id");
+    assertEqual(attrs["http.response.status_code"], "200");
+    const children = spans.filter((s) => s.parentSpanId === server.spanId);
+    assertEqual(
+      children.map((s) => s.name).join(),
+      "routing,interceptors,body,validation,handler,serialize",
+    );
+    if (BigInt(server.endTimeUnixNano) < BigInt(server.startTimeUnixNano)) {
+      throw new Error("Span ends before it starts");
+    }
+  });
+
+  await test("Spans continue an incoming traceparent", async () => {
+    spans.length = 0;
+    const traceId = "4bf92f3577b34da6a3ce929d0e0e4736";
+    await post({ traceparent: `00-${traceId}-00f067aa0ba902b7-01` });
+    await settled();
+    const server = spans.find((s) => s.kind === 2);
+    assertEqual(server.traceId, traceId);
+    assertEqual(server.parentSpanId, "00f067aa0ba902b7");
+
+    spans.length = 0;
+    await post({ traceparent: `00-${traceId}-00f067aa0ba902b7-00` });
+    await settled();
+    assertEqual(spans.length, 0, "Unsampled parent should not be traced");
+  });
+
+  await test("Per-route summary and folded flame output", async () => {
+    await fetch(`${url}/missing`);
+    await settled();
+    const summary = app.tracer.summary();
+    // The request with an unsampled parent is not counted
+    assertEqual(summary["POST /traced/:id"].count, 2);
+    assertEqual(summary.unmatched.count, 1);
+    const folded = app.tracer.folded();
+    if (!/^POST \/traced\/:id;handler \d+$/m.test(folded)) {
+      throw new Error(`Unexpected folded output: ${folded}`);
+    }
+  });
 }
 
 // ============================================
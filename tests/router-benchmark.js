@@ -0,0 +1,120 @@
+/**
+ * Vibe Router Benchmark
+ * Compiled matcher vs RouteTrie.match() vs linear regex matching
+ */
+import { RouteTrie } from "../utils/core/trie.js";
+import { PathToRegex } from "../utils/core/handler.js";
+
+// Configuration
+const ROUTE_COUNTS = [50, 100, 400, 1000];
+const ITERATIONS = 100000;
+const LINEAR_ITERATIONS = 5000; // regex scan is orders of magnitude slower
+const WARMUP = 20000;
+
+const RESOURCES = [
+  "users",
+  "posts",
+  "comments",
+  "articles",
+  "products",
+  "orders",
+  "customers",
+  "reviews",
+];
+
+// Generate parameterized routes shaped like a real API (/api/vN/...)
+function generateRoutes(count) {
+  const routes = [];
+  const seen = new Set();
+  for (let i = 0; routes.length < count; i++) {
+    const version = `v${(i % 4) + 1}`;
+    const a = RESOURCES[i % RESOURCES.length];
+    const b = RESOURCES[Math.floor(i / RESOURCES.length) % RESOURCES.length];
+    const variant = Math.floor(i / 64);
+    let path = `/api/${version}/${a}/:${a}Id/${b}`;
+    if (variant % 2 === 1) path += `/:${b}Key`;
+    if (variant > 1) path += `/x${variant}`;
+    if (seen.has(path)) continue;
+    seen.add(path);
+    routes.push({
+      method: "GET",
+      path,
+      handler: () => {},
+      pathRegex: PathToRegex(path).pathRegex,
+    });
+  }
+  return routes;
+}
+
+// Mirrors linearMatch() in server.js
+function linearMatch(routes, method, url) {
+  for (let i = 0, len = routes.length; i < len; i++) {
+    const route = routes[i];
+    if (route.method !== method) continue;
+    const result = route.pathRegex.exec(url);
+    if (result) return { route, params: result.groups || {} };
+  }
+  return null;
+}
+
+// Each variant gets its own loop so the call site stays monomorphic.
+// All timings are reported as nanoseconds per match.
+function timeCompiled(compiled, testPaths) {
+  const n = testPaths.length;
+  for (let i = 0; i < WARMUP * n; i++) compiled("GET", testPaths[i % n]);
+  const start = process.hrtime.bigint();
+  for (let i = 0; i < ITERATIONS * n; i++) compiled("GET", testPaths[i % n]);
+  return Number(process.hrtime.bigint() - start) / (ITERATIONS * n);
+}
+
+function timeTrie(trie, testPaths) {
+  const n = testPaths.length;
+  for (let i = 0; i < WARMUP * n; i++) trie.match("GET", testPaths[i % n]);
+  const start = process.hrtime.bigint();
+  for (let i = 0; i < ITERATIONS * n; i++) trie.match("GET", testPaths[i % n]);
+  return Number(process.hrtime.bigint() - start) / (ITERATIONS * n);
+}
+
+function timeLinear(routes, testPaths) {
+  const n = testPaths.length;
+  for (let i = 0; i < 500 * n; i++) linearMatch(routes, "GET", testPaths[i % n]);
+  const start = process.hrtime.bigint();
+  for (let i = 0; i < LINEAR_ITERATIONS * n; i++) {
+    linearMatch(routes, "GET", testPaths[i % n]);
+  }
+  return Number(process.hrtime.bigint() - start) / (LINEAR_ITERATIONS * n);
+}
+
+console.log("🔬 Vibe Router Benchmark\n");
+console.log("=".repeat(80));
+console.log(
+  `| ${"Routes".padEnd(8)} | ${"Compiled (ns)".padEnd(14)} | ${"Trie (ns)".padEnd(10)} | ${"Linear (ns)".padEnd(12)} | ${"vs Trie".padEnd(8)} | ${"vs Linear".padEnd(10)} |`,
+);
+console.log("=".repeat(80));
+
+for (const count of ROUTE_COUNTS) {
+  const routes = generateRoutes(count);
+  const trie = new RouteTrie();
+  for (const route of routes) trie.insert(route.method, route.path, route);
+  const compiled = trie.compile();
+
+  const testPaths = [
+    routes[0].path,
+    routes[Math.floor(routes.length / 2)].path,
+    routes[routes.length - 1].path,
+    "/api/v1/nonexistent/path",
+  ].map((p) => p.replace(/:\w+/g, "12345"));
+
+  const compiledNs = timeCompiled(compiled, testPaths);
+  const trieNs = timeTrie(trie, testPaths);
+  const linearNs = timeLinear(routes, testPaths);
+
+  console.log(
+    `| ${count.toString().padEnd(8)} | ${compiledNs.toFixed(1).padEnd(14)} | ${trieNs.toFixed(1).padEnd(10)} | ${linearNs.toFixed(1).padEnd(12)} | ${((trieNs / compiledNs).toFixed(2) + "x").padEnd(8)} | ${((linearNs / compiledNs).toFixed(1) + "x").padEnd(10)} |`,
+  );
+}
+
+console.log("=".repeat(80));
+console.log(
+  `\n📊 Benchmark: ${ITERATIONS.toLocaleString()} iterations × 4 paths per route count (linear: ${LINEAR_ITERATIONS.toLocaleString()})\n`,
+);
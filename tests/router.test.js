@@ -0,0 +1,303 @@
+/**
+ * Route Matcher Test
+ * Verifies the radix trie and the compiled router keep the matching
+ * priority of the original segment-per-node trie
+ */
+import { RouteTrie } from "../utils/core/trie.js";
+import { PathToRegex } from "../utils/core/handler.js";
+import {
+  countDynamic,
+  linearMatch,
+  trieIsFaster,
+} from "../utils/core/matching.js";
+
+// Reference: the original segment trie (static > param > wildcard)
+class SegmentTrie {
+  constructor() {
+    this.methods = new Map();
+  }
+  node() {
+    return { children: new Map(), paramChild: null, wildcardChild: null, paramName: null, route: null };
+  }
+  insert(method, path, route) {
+    if (!this.methods.has(method)) this.methods.set(method, this.node());
+    let current = this.methods.get(method);
+    for (const segment of path.split("/").filter(Boolean)) {
+      if (segment.startsWith(":")) {
+        current.paramChild ||= { ...this.node(), paramName: segment.slice(1) };
+        current = current.paramChild;
+      } else if (segment === "*") {
+        current.wildcardChild ||= this.node();
+        current = current.wildcardChild;
+        break;
+      } else {
+        if (!current.children.has(segment)) current.children.set(segment, this.node());
+        current = current.children.get(segment);
+      }
+    }
+    current.route = route;
+  }
+  match(method, path) {
+    const root = this.methods.get(method);
+    if (!root) return null;
+    return this.rec(root, path.split("/").filter(Boolean), 0, {});
+  }
+  rec(node, segments, index, params) {
+    if (index === segments.length) {
+      return node.route ? { route: node.route, params: { ...params } } : null;
+    }
+    const segment = segments[index];
+    if (node.children.has(segment)) {
+      const r = this.rec(node.children.get(segment), segments, index + 1, params);
+      if (r) return r;
+    }
+    if (node.paramChild) {
+      const r = this.rec(node.paramChild, segments, index + 1, {
+        ...params,
+        [node.paramChild.paramName]: segment,
+      });
+      if (r) return r;
+    }
+    if (node.wildcardChild && node.wildcardChild.route) {
+      return {
+        route: node.wildcardChild.route,
+        params: { ...params, wildcard: segments.slice(index).join("/") },
+      };
+    }
+    return null;
+  }
+}
+
+let passed = 0;
+let failed = 0;
+
+function assert(condition, message) {
+  if (condition) {
+    console.log(`  ✅ ${message}`);
+    passed++;
+  } else {
+    console.log(`  ❌ ${message}`);
+    failed++;
+  }
+}
+
+function same(a, b) {
+  if (a === null || b === null) return a === b;
+  return a.route === b.route && JSON.stringify(a.params) === JSON.stringify(b.params);
+}
+
+console.log("\n🔬 Route Matcher Test\n");
+
+const trie = new RouteTrie();
+const reference = new SegmentTrie();
+const paths = [
+  "/",
+  "/users",
+  "/users/me",
+  "/users/:id",
+  "/users/:id/posts",
+  "/users/:id/posts/:postId",
+  "/users/:id/settings",
+  "/user-groups/:group",
+  "/users-archive",
+  "/api/v2/tenants/:t/items/:item",
+  "/api/v2/tenants/:t/items/export",
+  "/api/v2/health",
+  "/files/*",
+  "/files/static/logo",
+  "/a/:x/c",
+  "/a/b/d",
+  "/public/*",
+];
+for (const p of paths) {
+  const route = { method: "GET", path: p };
+  trie.insert("GET", p, route);
+  reference.insert("GET", p, route);
+}
+trie.insert("POST", "/users/:id", { method: "POST", path: "/users/:id" });
+
+const compiled = trie.compile();
+
+// ==========================================
+// Test 1: Parity with recursive matcher
+// ==========================================
+console.log("📋 Test 1: Parity with the segment trie");
+
+const requests = [
+  "/",
+  "//",
+  "/users",
+  "/users/",
+  "/users/me",
+  "/users/42",
+  "/users//42",
+  "/users/42/posts",
+  "/users/42/posts/7",
+  "/users/42/settings",
+  "/users/42/unknown",
+  "/user-groups/admins",
+  "/user-groups",
+  "/users-archive",
+  "/users-archive/x",
+  "users/42",
+  "/api/v2/tenants/acme/items/9",
+  "/api/v2/tenants/acme/items/export",
+  "/api/v2/health",
+  "/api/v2",
+  "/files/a/b/c.txt",
+  "/files/a//b/",
+  "/files/static/logo",
+  "/files/static/logo/big",
+  "/files",
+  "/a/b/c",
+  "/a/b/d",
+  "/a/z/c",
+  "/public/css/site.css",
+  "/nope",
+];
+
+let mismatches = 0;
+for (const url of requests) {
+  const expected = reference.match("GET", url);
+  if (!same(expected, trie.match("GET", url)) || !same(expected, compiled("GET", url))) {
+    console.log(`     mismatch for ${url}`);
+    mismatches++;
+  }
+}
+assert(mismatches === 0, `${requests.length} paths match identically`);
+
+// ==========================================
+// Test 2: Priority and params
+// ==========================================
+console.log("\n📋 Test 2: Priority and params");
+
+assert(compiled("GET", "/users/me").route.path === "/users/me", "Static beats param");
+assert(
+  compiled("GET", "/a/b/c").route.path === "/a/:x/c",
+  "Backtracks from static to param",
+);
+assert(
+  compiled("GET", "/users/9/posts/3").params.postId === "3",
+  "Multiple params extracted",
+);
+assert(
+  compiled("GET", "/files/x/y").params.wildcard === "x/y",
+  "Wildcard captures rest of path",
+);
+assert(compiled("POST", "/users/1").route.method === "POST", "Per-method matcher");
+assert(compiled("DELETE", "/users/1") === null, "Unknown method returns null");
+
+const late = new RouteTrie();
+late.insert("GET", "/a/:id", { path: "/a/:id" });
+assert(late.matchCompiled("GET", "/b/1") === null, "matchCompiled builds on first use");
+late.insert("GET", "/b/:id", { path: "/b/:id" });
+assert(
+  late.matchCompiled("GET", "/b/1").route.path === "/b/:id",
+  "Insert after compiling rebuilds the matcher",
+);
+
+// ==========================================
+// Test 3: Radix structure and param shapes
+// ==========================================
+console.log("\n📋 Test 3: Radix structure and param shapes");
+
+const root = trie.methods.get("GET");
+assert(
+  root.children.length === 1 && root.children[0].prefix === "/",
+  "Shared leading slash is one edge",
+);
+const tenants = new RouteTrie();
+tenants.insert("GET", "/api/v2/tenants/:t/items", {});
+tenants.insert("GET", "/api/v2/tenants/:t/users", {});
+assert(
+  tenants.methods.get("GET").children[0].prefix === "/api/v2/tenants/",
+  "Static prefix compressed into a single edge",
+);
+
+const a = trie.match("GET", "/users/1/posts/2").params;
+const b = trie.match("GET", "/users/3/posts/4").params;
+assert(
+  a.constructor === b.constructor && a.constructor !== Object,
+  "Params share a per-route constructor",
+);
+assert(
+  compiled("GET", "/users/1/posts/2").params.constructor === a.constructor,
+  "Compiled matcher uses the same constructor",
+);
+
+const names = new RouteTrie();
+names.insert("GET", "/u/:id/a", {});
+names.insert("GET", "/u/:uid/b", {});
+assert(names.match("GET", "/u/7/b").params.uid === "7", "Param names are per route");
+assert(
+  JSON.stringify(names.getAllRoutes().map((r) => r.path)) === '["/u/:id/a","/u/:uid/b"]',
+  "getAllRoutes lists original paths",
+);
+
+// ==========================================
+// Test 4: Large tries (hoisted subtrees)
+// ==========================================
+console.log("\n📋 Test 4: Large tries");
+
+const big = new RouteTrie();
+const bigReference = new SegmentTrie();
+const resources = ["users", "orders", "items", "tenants", "reports"];
+const bigRequests = [];
+for (let i = 0; i < 400; i++) {
+  const a = resources[i % 5];
+  const b = resources[Math.floor(i / 5) % 5];
+  const path = `/api/v${i % 7}/${a}/:${a}Id/${b}/x${Math.floor(i / 25)}`;
+  const route = { method: "GET", path };
+  big.insert("GET", path, route);
+  bigReference.insert("GET", path, route);
+  bigRequests.push(path.replace(/:\w+/g, String(i)));
+  bigRequests.push(path.replace(/:\w+/g, String(i)) + "/missing");
+}
+const bigCompiled = big.compile();
+
+mismatches = 0;
+for (const url of bigRequests) {
+  const expected = bigReference.match("GET", url);
+  if (!same(expected, big.match("GET", url)) || !same(expected, bigCompiled("GET", url))) {
+    mismatches++;
+  }
+}
+assert(mismatches === 0, `${bigRequests.length} paths match on a 400-route trie`);
+
+// ==========================================
+// Test 5: Linear matching and the linear/trie choice
+// ==========================================
+console.log("\n📋 Test 5: Linear matching");
+
+const linearRoutes = ["/users", "/users/:id", "/files/*"].map((p) => ({
+  method: "GET",
+  path: p,
+  pathRegex: PathToRegex(p).pathRegex,
+  isStatic: !p.includes(":") && !p.includes("*"),
+}));
+assert(
+  linearMatch(linearRoutes, "GET", "/users/7")?.params.id === "7",
+  "Linear matching finds param routes",
+);
+assert(
+  linearMatch(linearRoutes, "GET", "/users") === null &&
+    countDynamic(linearRoutes) === 2,
+  "Static routes are left to the static map",
+);
+
+const bigRoutes = big.getAllRoutes().map(({ path }) => ({
+  method: "GET",
+  path,
+  pathRegex: PathToRegex(path).pathRegex,
+  isStatic: false,
+}));
+assert(
+  trieIsFaster(bigRoutes, big) === true,
+  "auto picks the trie for 400 param routes",
+);
+
+console.log("\n" + "=".repeat(50));
+console.log(`📊 Results: ${passed} passed, ${failed} failed`);
+console.log("=".repeat(50));
+
+process.exit(failed > 0 ? 1 : 0);
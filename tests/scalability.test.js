@@ -8,7 +8,17 @@ import vibe, {
   createPool,
   clusterize,
   isPrimary,
+  SharedCache,
+  TaskPool,
+  AdmissionController,
+  supportsReusePort,
 } from "../vibe.js";
+import { Histogram } from "../utils/helpers/histogram.js";
+import { spawn } from "child_process";
+import fs from "fs";
+import http from "http";
+import os from "os";
+import path from "path";
 
 let passed = 0;
 let failed = 0;
@@ -52,6 +62,49 @@ assert(etag.startsWith('"') && etag.endsWith('"'), "ETag is quoted");
 const key = LRUCache.key("GET", "/api/users");
 assert(key === "GET:/api/users", "Cache key format correct");
 
+// Byte budget: sizes come from the stored bytes, not the entry count
+const byteCache = new LRUCache({ max: 100, maxBytes: 100 });
+byteCache.set("small1", Buffer.alloc(30));
+byteCache.set("small2", Buffer.alloc(30));
+byteCache.set("big", Buffer.alloc(60));
+assert(
+  byteCache.get("small1") === null && byteCache.bytes === 90,
+  "maxBytes evicts oldest until the new value fits",
+);
+byteCache.set("huge", Buffer.alloc(500));
+assert(
+  byteCache.get("huge") === null && byteCache.size === 2,
+  "Value larger than maxBytes is not stored",
+);
+byteCache.set("big", "x".repeat(10));
+assert(byteCache.bytes === 40, "Overwrite replaces the old size");
+
+// Expired entries are reclaimed without being read
+const sweepCache = new LRUCache({ ttl: 5, sweepInterval: 5 });
+for (let i = 0; i < 50; i++) sweepCache.set("dead" + i, i);
+sweepCache.set("alive", 1, 60000);
+await new Promise((r) => setTimeout(r, 20));
+sweepCache.prune();
+assert(
+  sweepCache.size === 1 && sweepCache.get("alive") !== null,
+  "Sweep reclaims expired entries untouched",
+);
+sweepCache.clear();
+
+// TinyLFU admission: a scan of one-hit keys keeps the hot set
+const lfuCache = new LRUCache({ max: 10, admission: "tinylfu" });
+for (let round = 0; round < 5; round++) {
+  for (let i = 0; i < 10; i++) {
+    if (!lfuCache.get("hot" + i)) lfuCache.set("hot" + i, i);
+  }
+}
+for (let i = 0; i < 100; i++) {
+  if (!lfuCache.get("scan" + i)) lfuCache.set("scan" + i, i);
+}
+let hotKept = 0;
+for (let i = 0; i < 10; i++) if (lfuCache.get("hot" + i)) hotKept++;
+assert(hotKept === 10, "TinyLFU keeps hot keys through a scan");
+
 // ==========================================
 // Test 2: Connection Pool
 // ==========================================
@@ -89,6 +142,69 @@ assert(result > 0, "pool.use() auto-releases");
 await pool.close();
 assert(pool.stats.available === 0, "Pool closes cleanly");
 
+// Waiters: FIFO hand-off, timeouts skipped, wait histogram
+const single = createPool({
+  create: async () => ({ id: ++connectionId }),
+  destroy: async () => {},
+  max: 1,
+  acquireTimeout: 30,
+});
+const held = await single.acquire();
+const expired = Array.from({ length: 100 }, () =>
+  single.acquire().then(
+    () => "ok",
+    (err) => err.message,
+  ),
+);
+const timedOut = await Promise.all(expired);
+assert(
+  timedOut.every((r) => r === "Acquire timeout"),
+  "Waiters time out",
+);
+assert(single.stats.waiting === 0, "Timed-out waiters leave the count");
+const next = single.acquire();
+single.release(held);
+assert((await next) === held, "Release skips timed-out waiters");
+assert(single.stats.timeouts === 100, "Stats count timeouts");
+assert(single.stats.wait.count === 2, "Stats record acquire wait time");
+single.release(held);
+await single.close();
+
+// minIdle prewarm, background validation, teardown off the acquire path
+const broken = new Set();
+const warm = createPool({
+  create: async () => ({ id: ++connectionId }),
+  destroy: () => new Promise((r) => setTimeout(r, 500)),
+  validate: (conn) => !broken.has(conn),
+  minIdle: 2,
+  max: 4,
+  validateInterval: 20,
+});
+await new Promise((r) => setTimeout(r, 20));
+assert(warm.stats.available === 2, "minIdle prewarms resources");
+
+const warmConn = await warm.acquire();
+await new Promise((r) => setTimeout(r, 20));
+assert(warm.stats.available === 2, "minIdle refills after acquire");
+
+for (const pooled of warm.available) broken.add(pooled.resource);
+await new Promise((r) => setTimeout(r, 60));
+assert(
+  warm.stats.destroying === 2 && warm.stats.available === 0,
+  "Background validation retires broken idle resources",
+);
+
+broken.add(warmConn);
+warm.release(warmConn);
+const started = Date.now();
+const fresh = await warm.acquire();
+assert(
+  fresh !== warmConn && Date.now() - started < 200,
+  "Invalid resource is destroyed without blocking acquire",
+);
+warm.release(fresh);
+await warm.close();
+
 // ==========================================
 // Test 3: Cluster Utilities
 // ==========================================
@@ -108,6 +224,178 @@ const middleware = cacheMiddleware(testCache);
 
 assert(typeof middleware === "function", "cacheMiddleware returns function");
 
+// Minimal ServerResponse stand-in: records what reaches the wire
+function mockResponse() {
+  return {
+    statusCode: 200,
+    headers: {},
+    head: null,
+    body: undefined,
+    setHeader(name, value) {
+      this.headers[name.toLowerCase()] = value;
+    },
+    getHeader(name) {
+      return this.headers[name.toLowerCase()];
+    },
+    writeHead(code, headers) {
+      this.head = { code, headers: { ...this.headers, ...headers } };
+      return this;
+    },
+    write() {
+      return true;
+    },
+    end(body) {
+      this.body = body;
+    },
+    json() {
+      throw new Error("hits must not re-serialize");
+    },
+  };
+}
+
+const bytesCache = new LRUCache();
+const bytesMiddleware = cacheMiddleware(bytesCache);
+const missReq = { method: "GET", url: "/bytes", headers: {} };
+const missRes = mockResponse();
+assert(bytesMiddleware(missReq, missRes) === true, "Miss continues to handler");
+missRes.writeHead(200, { "content-type": "application/json" });
+missRes.end('{"n":1}');
+const stored = bytesCache.get(LRUCache.key("GET", "/bytes"));
+assert(
+  Buffer.isBuffer(stored.value) &&
+    stored.value.toString() === '{"n":1}' &&
+    stored.contentType === "application/json",
+  "Miss stores body bytes and content-type",
+);
+assert(
+  missRes.head.headers.etag === stored.etag &&
+    missRes.head.headers["x-cache"] === "MISS",
+  "Miss response carries ETag and X-Cache despite writeHead",
+);
+
+const hitRes = mockResponse();
+bytesMiddleware({ method: "GET", url: "/bytes", headers: {} }, hitRes);
+assert(
+  hitRes.body === stored.value &&
+    hitRes.head.headers["content-length"] === 7 &&
+    hitRes.head.headers["X-Cache"] === "HIT",
+  "Hit writes the stored Buffer directly",
+);
+
+const notModified = mockResponse();
+bytesMiddleware(
+  { method: "GET", url: "/bytes", headers: { "if-none-match": stored.etag } },
+  notModified,
+);
+assert(
+  notModified.head.code === 304 &&
+    notModified.head.headers.ETag === stored.etag &&
+    notModified.head.headers["X-Cache"] === "HIT",
+  "Matching If-None-Match returns 304 with ETag and X-Cache",
+);
+const listed = mockResponse();
+bytesMiddleware(
+  {
+    method: "GET",
+    url: "/bytes",
+    headers: { "if-none-match": `"other", ${stored.etag}` },
+  },
+  listed,
+);
+const star = mockResponse();
+bytesMiddleware(
+  { method: "GET", url: "/bytes", headers: { "if-none-match": "*" } },
+  star,
+);
+assert(
+  listed.head.code === 304 && star.head.code === 304,
+  "If-None-Match lists and * match too",
+);
+
+const errorRes = mockResponse();
+bytesMiddleware({ method: "GET", url: "/err", headers: {} }, errorRes);
+errorRes.writeHead(500, { "content-type": "application/json" });
+errorRes.end('{"error":"x"}');
+assert(
+  bytesCache.get(LRUCache.key("GET", "/err")) === null,
+  "Non-200 responses are not cached",
+);
+
+assert(
+  LRUCache.etag('{"n":1}') === LRUCache.etag(Buffer.from('{"n":1}')) &&
+    LRUCache.etag("a") !== LRUCache.etag("b"),
+  "ETag hashes bytes consistently",
+);
+
+// Single-flight: concurrent misses wait for the first handler
+const flightCache = new LRUCache();
+const flightMiddleware = cacheMiddleware(flightCache);
+const leaderRes = mockResponse();
+flightMiddleware({ method: "GET", url: "/flight", headers: {} }, leaderRes);
+const followerRes = mockResponse();
+const followerResult = flightMiddleware(
+  { method: "GET", url: "/flight", headers: {} },
+  followerRes,
+);
+assert(
+  typeof followerResult.then === "function",
+  "Concurrent miss waits on in-flight fill",
+);
+leaderRes.writeHead(200, { "content-type": "application/json" });
+leaderRes.end('{"once":true}');
+assert(
+  (await followerResult) === false &&
+    followerRes.body.toString() === '{"once":true}',
+  "Coalesced request is served the leader's bytes",
+);
+assert(
+  flightCache.stats.misses === 1 && flightCache.stats.coalesced === 1,
+  "Stats count misses and coalesced requests",
+);
+
+// Stale-while-revalidate: expired entry served, one background refresh
+const swrCache = new LRUCache({ ttl: 1 });
+const swrMiddleware = cacheMiddleware(swrCache, { staleWhileRevalidate: 60000 });
+swrCache.set(
+  LRUCache.key("GET", "/swr"),
+  Buffer.from('{"v":1}'),
+  1,
+  undefined,
+  "application/json",
+);
+await new Promise((r) => setTimeout(r, 5));
+let refreshes = 0;
+// The rest of the route's pipeline, as the server hands it over
+const swrRest = async (req, res) => {
+  refreshes++;
+  res.writeHead(200, { "content-type": "application/json" });
+  res.end('{"v":2}');
+};
+const staleResA = mockResponse();
+const staleResB = mockResponse();
+swrMiddleware(
+  { method: "GET", url: "/swr", headers: {}, _rest: swrRest },
+  staleResA,
+);
+swrMiddleware(
+  { method: "GET", url: "/swr", headers: {}, _rest: swrRest },
+  staleResB,
+);
+assert(
+  staleResA.body.toString() === '{"v":1}' &&
+    staleResA.head.headers["X-Cache"] === "STALE" &&
+    staleResB.head.headers["X-Cache"] === "STALE",
+  "Stale entry is served immediately",
+);
+await new Promise((r) => setTimeout(r, 10));
+assert(refreshes === 1, "Only one background refresh runs");
+assert(
+  swrCache.get(LRUCache.key("GET", "/swr"), 60000).value.toString() ===
+    '{"v":2}',
+  "Background refresh replaces the entry",
+);
+assert(swrCache.stats.stale === 2, "Stats count stale hits");
+
 // ==========================================
 // Test 5: Integration with App
 // ==========================================
@@ -131,6 +419,396 @@ app.post("/stream", { media: { streaming: true } }, () => {
 
 assert(true, "Streaming route registered");
 
+// ==========================================
+// Test 6: Shared Cache (cluster mode)
+// ==========================================
+console.log("\n📋 Test 6: Shared Cache");
+
+// Outside a worker it behaves like a local LRUCache
+const localShared = new SharedCache({ max: 10 });
+const localEntry = localShared.set("k", { a: 1 });
+assert(
+  Buffer.isBuffer(localEntry.value) && localEntry.value.toString() === '{"a":1}',
+  "SharedCache stores serialized bytes",
+);
+assert(
+  localShared.get("k").etag === LRUCache.etag('{"a":1}'),
+  "SharedCache local fallback get works",
+);
+
+// Two real workers: one writes, the other reads through the primary
+const clusterScript = path.join(
+  os.tmpdir(),
+  `vibe-shared-cache-${process.pid}.mjs`,
+);
+fs.writeFileSync(
+  clusterScript,
+  `
+import cluster from "node:cluster";
+import { SharedCache, hostSharedCache } from ${JSON.stringify(
+    new URL("../vibe.js", import.meta.url).href,
+  )};
+
+if (cluster.isPrimary) {
+  hostSharedCache();
+  const writer = cluster.fork({ ROLE: "writer" });
+  writer.on("message", (msg) => {
+    if (msg !== "written") return;
+    const reader = cluster.fork({ ROLE: "reader" });
+    reader.on("message", (result) => {
+      if (result && result.type === "vibe:cache") return;
+      console.log(JSON.stringify(result));
+      writer.kill();
+      reader.kill();
+    });
+  });
+} else {
+  const cache = new SharedCache({ name: "test" });
+  // Budget of exactly one non-ASCII body (charged by its real bytes)
+  const tight = new SharedCache({
+    name: "tight",
+    maxBytes: Buffer.byteLength('{"name":"Zoë Ångström"}'),
+  });
+  if (process.env.ROLE === "writer") {
+    cache.set("GET:/shared", { from: "writer" });
+    tight.set("GET:/utf8", { name: "Zoë Ångström" });
+    process.send("written");
+  } else {
+    const entry = await cache.get("GET:/shared");
+    const missing = await cache.get("GET:/missing");
+    const utf8 = await tight.get("GET:/utf8");
+    process.send({
+      value: entry && entry.value.toString(),
+      missing,
+      utf8: utf8 && utf8.value.toString(),
+    });
+  }
+}
+`,
+);
+
+const clusterOutput = await new Promise((resolve) => {
+  const child = spawn(process.execPath, [clusterScript]);
+  let out = "";
+  child.stdout.on("data", (d) => (out += d));
+  child.on("close", () => resolve(out.trim()));
+  setTimeout(() => child.kill(), 10000).unref();
+});
+fs.rmSync(clusterScript, { force: true });
+
+let clusterResult = null;
+try {
+  clusterResult = JSON.parse(clusterOutput);
+} catch {}
+assert(
+  clusterResult && clusterResult.value === '{"from":"writer"}',
+  "Entry set in one worker is visible in another",
+);
+assert(
+  clusterResult && clusterResult.missing === null,
+  "Unknown key is a miss across workers",
+);
+assert(
+  clusterResult && clusterResult.utf8 === '{"name":"Zoë Ångström"}',
+  "Non-ASCII bodies are charged their byte size on the primary",
+);
+
+// ==========================================
+// Test 7: Worker Thread Task Pool
+// ==========================================
+console.log("\n📋 Test 7: Worker Thread Task Pool");
+
+const tasks = new TaskPool({ size: 2 });
+tasks.define("spin", (ms) => {
+  const end = Date.now() + ms;
+  while (Date.now() < end);
+  return ms;
+});
+tasks.define("fill", (n) => new Uint8Array(n).fill(7));
+tasks.define("sum", (bytes) => bytes.reduce((a, b) => a + b, 0));
+tasks.define("fail", () => {
+  throw Object.assign(new RangeError("bad input"), { code: "E_INPUT" });
+});
+
+// Round-robin puts both slow jobs on worker 0; worker 1 must steal one
+const spins = await Promise.all(
+  [150, 5, 150, 5].map((ms) => tasks.run("spin", [ms])),
+);
+assert(spins.join() === "150,5,150,5", "Jobs resolve with their results");
+assert(tasks.stats.stolen >= 1, "Idle worker steals queued jobs");
+
+const filled = await tasks.run("fill", [1e6]);
+assert(
+  filled instanceof Uint8Array && filled.length === 1e6 && filled[9] === 7,
+  "Typed array results come back from the worker",
+);
+const input = new Uint8Array(1000).fill(2);
+assert(
+  (await tasks.run("sum", [input], { transfer: true })) === 2000 &&
+    input.byteLength === 0,
+  "transfer: true moves argument buffers instead of copying",
+);
+
+let taskError = null;
+try {
+  await tasks.run("fail");
+} catch (err) {
+  taskError = err;
+}
+assert(
+  taskError?.name === "RangeError" && taskError.code === "E_INPUT",
+  "Worker errors keep their name and code",
+);
+
+const taskStats = tasks.stats;
+assert(
+  taskStats.completed === 6 &&
+    taskStats.failed === 1 &&
+    taskStats.pending === 0 &&
+    taskStats.wait.count === 7 &&
+    taskStats.run.max >= 150,
+  "Stats report counts, queue depth and latency",
+);
+await tasks.close();
+
+// ==========================================
+// Test 8: Adaptive Admission Control
+// ==========================================
+console.log("\n📋 Test 8: Adaptive Admission Control");
+
+// Complete `n` requests that each took `rtt` ms, `concurrency` at a time
+function drive(controller, n, rtt, concurrency) {
+  for (let i = 0; i < n; i += concurrency) {
+    const starts = [];
+    for (let j = 0; j < concurrency; j++) {
+      const start = controller.acquire();
+      if (start >= 0) starts.push(start - rtt);
+    }
+    for (const start of starts) controller.release(start);
+  }
+}
+
+const aimd = new AdmissionController({
+  algorithm: "aimd",
+  initialLimit: 4,
+  timeout: 100,
+  maxEventLoopDelay: 0,
+});
+assert(aimd.acquire() >= 0, "Admits below the limit");
+aimd.release(performance.now());
+for (let i = 0; i < 4; i++) aimd.acquire();
+assert(aimd.acquire() === -1, "Sheds at the limit");
+assert(aimd.stats.shed === 1, "Stats count shed requests");
+for (let i = 0; i < 4; i++) aimd.release(performance.now());
+
+drive(aimd, 200, 5, 8);
+const grown = aimd.stats.limit;
+assert(grown > 4, "AIMD grows the limit while latency is fine");
+drive(aimd, 40, 500, 4);
+assert(aimd.stats.limit < grown, "AIMD backs off when latency passes timeout");
+
+const gradient = new AdmissionController({
+  initialLimit: 10,
+  maxEventLoopDelay: 0,
+});
+drive(gradient, 400, 10, 10);
+const steady = gradient.stats.limit;
+assert(steady > 10, "Gradient grows while latency stays at its average");
+drive(gradient, 100, 100, 40);
+assert(
+  gradient.stats.limit < steady,
+  "Gradient shrinks the limit as latency rises",
+);
+assert(
+  gradient.acquire() >= 0 && gradient.stats.inflight === 1,
+  "Tracks requests in flight",
+);
+
+// ==========================================
+// Test 9: Rolling Reload
+// ==========================================
+console.log("\n📋 Test 9: Rolling Reload");
+
+assert(typeof supportsReusePort() === "boolean", "supportsReusePort detects");
+
+const reloadPort = 3700 + (process.pid % 200);
+const reloadScript = path.join(os.tmpdir(), `vibe-reload-${process.pid}.mjs`);
+fs.writeFileSync(
+  reloadScript,
+  `
+import vibe, { clusterize } from ${JSON.stringify(
+    new URL("../vibe.js", import.meta.url).href,
+  )};
+clusterize(
+  () => {
+    const app = vibe({ logger: false });
+    app.get("/pid", async () => {
+      await new Promise((r) => setTimeout(r, 50));
+      return { pid: process.pid };
+    });
+    app.listen(${reloadPort}, "127.0.0.1");
+  },
+  { workers: 2, reusePort: true, drainTimeout: 2000 },
+);
+`,
+);
+
+const reloadChild = spawn(process.execPath, [reloadScript], {
+  stdio: ["ignore", "pipe", "pipe"],
+});
+let reloadOutput = "";
+reloadChild.stdout.on("data", (d) => (reloadOutput += d));
+const waitForOutput = async (text, ms = 10000) => {
+  const until = Date.now() + ms;
+  while (!reloadOutput.includes(text) && Date.now() < until) {
+    await new Promise((r) => setTimeout(r, 20));
+  }
+};
+const countListening = () => reloadOutput.split("Server listening").length - 1;
+
+const agent = new http.Agent({ keepAlive: true, maxSockets: 4 });
+const reloadTarget = { port: reloadPort, host: "127.0.0.1", path: "/pid" };
+// A keep-alive socket can be closed by a draining worker just as a request
+// is written to it; like browsers, retry that case (and only that case)
+const getPid = (retry = true) =>
+  new Promise((resolve) => {
+    const req = http
+      .get({ ...reloadTarget, agent }, (r) => {
+        let data = "";
+        r.on("data", (c) => (data += c));
+        r.on("end", () =>
+          resolve(r.statusCode === 200 ? JSON.parse(data).pid : 0),
+        );
+      })
+      .on("error", (err) => {
+        const stale = req.reusedSocket && err.code === "ECONNRESET";
+        resolve(stale && retry ? getPid(false) : 0);
+      });
+  });
+
+while (countListening() < 2 && reloadChild.exitCode === null) {
+  await new Promise((r) => setTimeout(r, 20));
+}
+const reloadPids = [];
+let keepLoading = true;
+const load = Array.from({ length: 4 }, async () => {
+  while (keepLoading) reloadPids.push(await getPid());
+});
+await new Promise((r) => setTimeout(r, 200));
+const firstPids = new Set(reloadPids);
+
+reloadChild.kill("SIGHUP");
+await waitForOutput("Reload complete");
+await new Promise((r) => setTimeout(r, 200));
+keepLoading = false;
+await Promise.all(load);
+
+assert(reloadOutput.includes("Reload complete"), "SIGHUP rolls every worker");
+assert(!reloadPids.includes(0), "No request fails during the reload");
+const lastPids = reloadPids.slice(-8);
+assert(
+  lastPids.length > 0 && lastPids.every((pid) => !firstPids.has(pid)),
+  "New workers serve after the reload",
+);
+
+// SIGTERM drains: the request in flight still gets its response
+const lastRequest = getPid();
+await new Promise((r) => setTimeout(r, 10));
+reloadChild.kill("SIGTERM");
+assert((await lastRequest) > 0, "In-flight request completes on shutdown");
+const reloadExit = await new Promise((resolve) => {
+  if (reloadChild.exitCode !== null) return resolve(reloadChild.exitCode);
+  reloadChild.on("exit", resolve);
+  setTimeout(() => reloadChild.kill("SIGKILL"), 10000).unref();
+});
+assert(reloadExit === 0, "Primary exits cleanly after workers drain");
+agent.destroy();
+fs.rmSync(reloadScript, { force: true });
+
+// ==========================================
+// Test 10: Cluster Metrics
+// ==========================================
+console.log("\n📋 Test 10: Cluster Metrics");
+
+const latency = new Histogram();
+for (const ms of [0.5, 2, 2, 40, 900]) latency.record(ms);
+assert(
+  latency.cumulative([1, 10, 100, 1000]).join() === "1,3,4,5",
+  "Histogram reports cumulative bucket counts",
+);
+const merged = new Histogram();
+merged.mergeSparse(JSON.parse(JSON.stringify(latency.sparse())));
+assert(
+  merged.count === 5 && merged.percentile(99) === latency.percentile(99),
+  "Sparse histogram survives IPC and merges",
+);
+const precise = new Histogram(7);
+for (let i = 1; i <= 10000; i++) precise.record(i / 100);
+assert(
+  Math.abs(precise.percentile(99.9) - 99.9) / 99.9 < 0.005,
+  "High-precision histogram keeps p99.9 within 0.5%",
+);
+
+const metricsPort = 3900 + (process.pid % 200);
+const metricsScript = path.join(os.tmpdir(), `vibe-metrics-${process.pid}.mjs`);
+fs.writeFileSync(
+  metricsScript,
+  `
+import vibe, { clusterize } from ${JSON.stringify(
+    new URL("../vibe.js", import.meta.url).href,
+  )};
+clusterize(
+  () => {
+    const app = vibe({ logger: false, metrics: { interval: 50 } });
+    app.get("/hit/:n", (req) => ({ pid: process.pid }));
+    app.listen(${metricsPort}, "127.0.0.1");
+  },
+  { workers: 2, metrics: { port: ${metricsPort + 1}, host: "127.0.0.1" } },
+);
+`,
+);
+const metricsChild = spawn(process.execPath, [metricsScript], {
+  stdio: ["ignore", "pipe", "pipe"],
+});
+let metricsOutput = "";
+metricsChild.stdout.on("data", (d) => (metricsOutput += d));
+const listening = Date.now() + 10000;
+while (
+  metricsOutput.split("Server listening").length < 3 &&
+  Date.now() < listening
+) {
+  await new Promise((r) => setTimeout(r, 20));
+}
+
+const servedBy = new Set();
+for (let i = 0; i < 20; i++) {
+  const r = await fetch(`http://127.0.0.1:${metricsPort}/hit/${i}`, {
+    headers: { connection: "close" },
+  });
+  servedBy.add((await r.json()).pid);
+}
+await new Promise((r) => setTimeout(r, 200));
+
+const fromWorker = await fetch(`http://127.0.0.1:${metricsPort}/metrics`)
+  .then((r) => r.text())
+  .catch(() => "");
+const fromPrimary = await fetch(`http://127.0.0.1:${metricsPort + 1}/metrics`)
+  .then((r) => r.text())
+  .catch(() => "");
+metricsChild.kill("SIGTERM");
+fs.rmSync(metricsScript, { force: true });
+
+const hitLine = 'vibe_http_requests_total{route="GET /hit/:n",status="2xx"} 20';
+assert(
+  servedBy.size === 2 && fromWorker.includes(hitLine),
+  "Any worker's /metrics merges every worker's counts",
+);
+assert(
+  fromPrimary.includes(hitLine) &&
+    (fromPrimary.match(/^vibe_worker_requests_total\{/gm) || []).length === 2,
+  "Primary serves merged metrics with per-worker series",
+);
+
 // ==========================================
 // Summary
 // ==========================================
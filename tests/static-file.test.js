@@ -3,7 +3,12 @@
  * Tests that files in the public folder are accessible via /public/* routes
  */
 import vibe from "../vibe.js";
+import { StaticFiles, parseRange } from "../utils/core/static.js";
 import http from "http";
+import fs from "fs";
+import os from "os";
+import path from "path";
+import zlib from "zlib";
 
 const app = vibe();
 const PORT = 3456;
@@ -21,10 +26,10 @@ function assert(condition, message) {
   }
 }
 
-function makeRequest(path) {
+function makeRequest(path, headers = {}, port = PORT) {
   return new Promise((resolve, reject) => {
     http
-      .get(`http://127.0.0.1:${PORT}${path}`, (res) => {
+      .get(`http://127.0.0.1:${port}${path}`, { headers }, (res) => {
         let data = "";
         res.on("data", (chunk) => (data += chunk));
         res.on("end", () =>
@@ -102,6 +107,220 @@ app.listen(PORT, async () => {
       "Path traversal blocked (403 or 404)",
     );
 
+    // ==========================================
+    // Test 7: Static engine (manifest, 304, Range, fd pool, watcher)
+    // ==========================================
+    console.log("\n📋 Test 7: Static Engine");
+    const root = fs.mkdtempSync(path.join(os.tmpdir(), "vibe-static-"));
+    fs.writeFileSync(path.join(root, "small.txt"), "Hello static");
+    fs.mkdirSync(path.join(root, "nested"));
+    fs.writeFileSync(
+      path.join(root, "nested", "big.bin"),
+      Buffer.alloc(5000, 1),
+    );
+
+    const files = new StaticFiles(root, { inlineSize: 1024, maxFds: 1 });
+    assert(
+      Buffer.isBuffer(files.lookup("small.txt").body) &&
+        files.lookup("nested/big.bin").body === null,
+      "Small files inlined, large files streamed",
+    );
+    assert(
+      files.lookup("../etc/passwd") === null,
+      "Traversal rejected by lookup",
+    );
+
+    const ENGINE_PORT = PORT + 1;
+    const engineServer = http
+      .createServer((req, res) => files.serve(req, res, req.url))
+      .listen(ENGINE_PORT);
+    await new Promise((r) => engineServer.once("listening", r));
+
+    const first = await makeRequest("/small.txt", {}, ENGINE_PORT);
+    assert(
+      first.data === "Hello static" &&
+        first.headers["content-length"] === "12" &&
+        first.headers.etag &&
+        first.headers["last-modified"],
+      "Inline file served with ETag, Last-Modified, Content-Length",
+    );
+
+    const notModified = await makeRequest(
+      "/small.txt",
+      { "if-none-match": first.headers.etag },
+      ENGINE_PORT,
+    );
+    assert(notModified.status === 304, "If-None-Match returns 304");
+
+    const sinceRes = await makeRequest(
+      "/small.txt",
+      { "if-modified-since": first.headers["last-modified"] },
+      ENGINE_PORT,
+    );
+    assert(sinceRes.status === 304, "If-Modified-Since returns 304");
+
+    const partial = await makeRequest(
+      "/small.txt",
+      { range: "bytes=6-" },
+      ENGINE_PORT,
+    );
+    assert(
+      partial.status === 206 &&
+        partial.data === "static" &&
+        partial.headers["content-range"] === "bytes 6-11/12",
+      "Range returns 206 with Content-Range",
+    );
+
+    const unsatisfiable = await makeRequest(
+      "/small.txt",
+      { range: "bytes=50-" },
+      ENGINE_PORT,
+    );
+    assert(unsatisfiable.status === 416, "Unsatisfiable range returns 416");
+
+    // Same large file twice: the pooled fd must survive the first stream
+    const big1 = await makeRequest("/nested/big.bin", {}, ENGINE_PORT);
+    const big2 = await makeRequest(
+      "/nested/big.bin",
+      { range: "bytes=-100" },
+      ENGINE_PORT,
+    );
+    assert(
+      big1.data.length === 5000 &&
+        big2.status === 206 &&
+        big2.data.length === 100,
+      "Large file streams from a reused pooled fd",
+    );
+
+    assert(
+      parseRange("bytes=0-0,5-6", 10) === undefined &&
+        parseRange("bytes=-3", 10).start === 7,
+      "Multi-range ignored, suffix range parsed",
+    );
+
+    fs.writeFileSync(path.join(root, "added.txt"), "watched");
+    let added = null;
+    for (let i = 0; i < 40 && !added; i++) {
+      await new Promise((r) => setTimeout(r, 50));
+      added = files.lookup("added.txt");
+    }
+    assert(
+      added && added.body.toString() === "watched",
+      "Watcher adds new files",
+    );
+
+    files.close();
+    engineServer.close();
+    fs.rmSync(root, { recursive: true, force: true });
+
+    // ==========================================
+    // Test 8: Precompressed variants (Accept-Encoding negotiation)
+    // ==========================================
+    console.log("\n📋 Test 8: Precompressed Variants");
+    const zroot = fs.mkdtempSync(path.join(os.tmpdir(), "vibe-static-z-"));
+    fs.writeFileSync(path.join(zroot, "app.js"), "console.log('identity');");
+    // Sibling contents are served as-is, so markers are enough here
+    fs.writeFileSync(path.join(zroot, "app.js.br"), "BR");
+    fs.writeFileSync(path.join(zroot, "app.js.gz"), "GZ");
+    const generated = "let x = 1;\n".repeat(500);
+    fs.writeFileSync(path.join(zroot, "gen.js"), generated);
+
+    const zfiles = new StaticFiles(zroot, { compress: true, watch: false });
+    const ZPORT = PORT + 2;
+    const zserver = http
+      .createServer((req, res) => zfiles.serve(req, res, req.url))
+      .listen(ZPORT);
+    await new Promise((r) => zserver.once("listening", r));
+
+    const brRes = await makeRequest(
+      "/app.js",
+      { "accept-encoding": "gzip, deflate, br" },
+      ZPORT,
+    );
+    assert(
+      brRes.data === "BR" &&
+        brRes.headers["content-encoding"] === "br" &&
+        brRes.headers.vary === "Accept-Encoding" &&
+        brRes.headers["content-type"].includes("javascript"),
+      "Brotli sibling preferred, with Vary and the original type",
+    );
+
+    const gzRes = await makeRequest(
+      "/app.js",
+      { "accept-encoding": "br;q=0, gzip" },
+      ZPORT,
+    );
+    assert(
+      gzRes.data === "GZ" && gzRes.headers["content-encoding"] === "gzip",
+      "q=0 refuses br, gzip sibling served",
+    );
+
+    const plainRes = await makeRequest("/app.js", {}, ZPORT);
+    assert(
+      plainRes.data === "console.log('identity');" &&
+        plainRes.headers["content-encoding"] === undefined &&
+        plainRes.headers.vary === "Accept-Encoding",
+      "Identity served without Accept-Encoding, still with Vary",
+    );
+
+    const brAgain = await makeRequest(
+      "/app.js",
+      { "accept-encoding": "br", "if-none-match": brRes.headers.etag },
+      ZPORT,
+    );
+    assert(
+      brAgain.status === 304 && brRes.headers.etag !== plainRes.headers.etag,
+      "Each variant has its own ETag for conditional GET",
+    );
+
+    const rangeRes = await makeRequest(
+      "/app.js",
+      { "accept-encoding": "br", range: "bytes=0-6" },
+      ZPORT,
+    );
+    assert(
+      rangeRes.status === 206 &&
+        rangeRes.data === "console" &&
+        rangeRes.headers["content-encoding"] === undefined,
+      "Range requests are served from identity bytes",
+    );
+
+    let genVariants = null;
+    for (let i = 0; i < 40; i++) {
+      genVariants = zfiles.lookup("gen.js").variants;
+      if (genVariants && genVariants.br && genVariants.gzip) break;
+      await new Promise((r) => setTimeout(r, 50));
+    }
+    assert(
+      genVariants &&
+        zlib.brotliDecompressSync(genVariants.br.body).toString() ===
+          generated &&
+        zlib.gunzipSync(genVariants.gzip.body).toString() === generated &&
+        genVariants.br.size < generated.length,
+      "Missing variants generated in the background",
+    );
+
+    zfiles.close();
+    zserver.close();
+    fs.rmSync(zroot, { recursive: true, force: true });
+
+    // ==========================================
+    // Test 9: Symlink cycles are walked once
+    // ==========================================
+    console.log("\n📋 Test 9: Symlink Cycles");
+    const lroot = fs.mkdtempSync(path.join(os.tmpdir(), "vibe-static-l-"));
+    fs.mkdirSync(path.join(lroot, "a"));
+    fs.writeFileSync(path.join(lroot, "a", "x.txt"), "x");
+    fs.symlinkSync("..", path.join(lroot, "a", "loop"));
+    fs.symlinkSync("..", path.join(lroot, "a", "loop2"));
+    const lfiles = new StaticFiles(lroot, { watch: false });
+    assert(
+      [...lfiles.files.keys()].join() === "a/x.txt",
+      "Directory reached through a symlink loop is not walked again",
+    );
+    lfiles.close();
+    fs.rmSync(lroot, { recursive: true, force: true });
+
     // ==========================================
     // Summary
     // ==========================================
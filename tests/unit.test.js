@@ -4,6 +4,16 @@
  */
 import vibe from "../vibe.js";
 import http from "http";
+import {
+  compileSerializer,
+  escapeString,
+} from "../utils/core/compile-serializer.js";
+import { JsonSelectParser } from "../utils/core/json-select.js";
+import { parseJsonStream } from "../utils/core/parser.js";
+import { compileQuery } from "../utils/core/compile-query.js";
+import { compileValidator } from "../utils/core/compile-validator.js";
+import { parseQuery } from "../utils/native.js";
+import { Readable } from "stream";
 
 const app = vibe();
 let testsPassed = 0;
@@ -230,6 +240,231 @@ assert(typeof app.head === "function", "HEAD method exists");
 console.log("\n📋 Test 12: Registered Routes");
 app.logRoutes();
 
+// ==========================================
+// Test 13: Compiled Serializer
+// ==========================================
+console.log("\n📋 Test 13: Compiled Serializer");
+
+const listSchema = {
+  type: "array",
+  items: {
+    type: "object",
+    properties: {
+      id: { type: "integer" },
+      name: { type: "string" },
+      tags: { type: "array", items: { type: "string" } },
+      owner: { type: "object", properties: { email: { type: "string" } } },
+    },
+  },
+};
+const list = [
+  { id: 1, name: 'say "hi"', tags: ["a"], owner: { email: "a@x.io" } },
+  { id: 2, name: "b", tags: [], owner: { email: "b@x.io" } },
+];
+assert(
+  compileSerializer(listSchema)(list) === JSON.stringify(list),
+  "Nested objects and arrays serialize like JSON.stringify",
+);
+assert(
+  compileSerializer(listSchema) === compileSerializer(listSchema),
+  "Serializers are cached by schema identity",
+);
+
+const strictSchema = {
+  type: "object",
+  required: ["id"],
+  properties: {
+    id: { type: "number" },
+    note: { type: "string" },
+    state: { enum: ["on", "off"] },
+    kind: { const: "user" },
+    flag: { type: ["boolean", "null"] },
+  },
+  additionalProperties: { type: "number" },
+};
+assert(
+  compileSerializer(strictSchema)({ id: 1, kind: 0, flag: null, extra: 5 }) ===
+    '{"id":1,"kind":"user","flag":null,"extra":5}',
+  "required, const, nullable and additionalProperties",
+);
+let requiredThrew = false;
+try {
+  compileSerializer(strictSchema)({ note: "x" });
+} catch {
+  requiredThrew = true;
+}
+assert(requiredThrew, "Missing required property throws");
+
+const treeSchema = {
+  $ref: "#/definitions/node",
+  definitions: {
+    node: {
+      type: "object",
+      properties: {
+        name: { type: "string" },
+        children: { type: "array", items: { $ref: "#/definitions/node" } },
+      },
+    },
+  },
+};
+const tree = { name: "root", children: [{ name: "leaf", children: [] }] };
+assert(
+  compileSerializer(treeSchema)(tree) === JSON.stringify(tree),
+  "Recursive $ref resolved",
+);
+
+const tricky = ["", "plain-slug", 'q"\\\n\u0001', "x".repeat(300) + "\t"];
+assert(
+  tricky.every((str) => escapeString(str) === JSON.stringify(str)),
+  "escapeString matches JSON.stringify (short, dirty, long)",
+);
+assert(
+  compileSerializer({
+    type: "object",
+    properties: { slug: { type: "string", format: "safe" } },
+  })({ slug: "abc-123" }) === '{"slug":"abc-123"}',
+  'format: "safe" strings written without escaping',
+);
+
+// ==========================================
+// Test 14: Incremental JSON Parser
+// ==========================================
+console.log("\n📋 Test 14: Incremental JSON Parser");
+
+const importDoc = {
+  meta: { 'q"uote\\': "x\\" },
+  items: [{ id: 1, name: "héllo 🌍", tags: ["a"] }, "s,]}\\", null, [], {}],
+};
+const importBytes = Buffer.from(JSON.stringify(importDoc, null, 1));
+
+// Split at every byte boundary: strings, escapes and UTF-8 across chunks
+function selectAll(path, bytes) {
+  const out = [];
+  for (let cut = 0; cut <= bytes.length; cut++) {
+    const found = [];
+    const parser = new JsonSelectParser(path, (v) => found.push(v));
+    parser.write(bytes.subarray(0, cut));
+    parser.write(bytes.subarray(cut));
+    parser.end();
+    out.push(JSON.stringify(found));
+  }
+  return out;
+}
+assert(
+  selectAll("$.items[*]", importBytes).every(
+    (r) => r === JSON.stringify(importDoc.items),
+  ),
+  "$.items[*] yields each element, whatever the chunk split",
+);
+assert(
+  selectAll(`$.meta['q"uote\\']`, importBytes).every(
+    (r) => r === JSON.stringify(["x\\"]),
+  ),
+  "Escaped keys and values are matched and decoded",
+);
+assert(
+  selectAll("$.items[0].tags[0]", importBytes).every((r) => r === '["a"]'),
+  "Nested index paths select a single value",
+);
+
+let truncatedThrew = false;
+try {
+  const parser = new JsonSelectParser("$.items[*]", () => {});
+  parser.write(Buffer.from('{"items":[1,'));
+  parser.end();
+} catch (err) {
+  truncatedThrew = err instanceof SyntaxError;
+}
+assert(truncatedThrew, "Truncated document throws SyntaxError");
+
+const streamed = [];
+for await (const item of parseJsonStream(
+  Readable.from([importBytes.subarray(0, 9), importBytes.subarray(9)]),
+  "$.items[*]",
+)) {
+  streamed.push(item);
+}
+assert(
+  JSON.stringify(streamed) === JSON.stringify(importDoc.items),
+  "parseJsonStream(stream, path) is an async iterator",
+);
+assert(
+  JSON.stringify(await parseJsonStream(Readable.from([importBytes]))) ===
+    JSON.stringify(importDoc),
+  "parseJsonStream(stream) resolves with the whole document",
+);
+
+// ==========================================
+// Test 15: Query Parsing
+// ==========================================
+console.log("\n📋 Test 15: Query Parsing");
+
+const plainQuery = parseQuery("?q=hello+world&path=%2Fhome&tag=a&tag=b&debug");
+assert(
+  JSON.stringify(plainQuery) ===
+    '{"q":"hello world","path":"/home","tag":["a","b"],"debug":""}',
+  "parseQuery decodes escapes, keeps repeated keys and flags",
+);
+const oddQuery = parseQuery("bad=%E0%A4%A&=x&&toString=1");
+assert(
+  JSON.stringify(oddQuery) === '{"bad":"%E0%A4%A","toString":"1"}',
+  "Malformed escapes stay raw, empty keys are skipped",
+);
+
+const querySchema = {
+  type: "object",
+  properties: {
+    page: { type: "integer", default: 1 },
+    price: { type: "number" },
+    debug: { type: "boolean" },
+    ids: { type: "array", items: { type: "integer" } },
+  },
+};
+const parseTyped = compileQuery(querySchema);
+assert(
+  JSON.stringify(parseTyped("ids=3&page=2&debug&ids=4&price=9.5&x=y")) ===
+    '{"page":2,"price":9.5,"debug":true,"ids":[3,4],"x":"y"}',
+  "Compiled query parser coerces types in declaration order",
+);
+assert(
+  JSON.stringify(parseTyped("")) === '{"page":1}' &&
+    parseTyped("page=two").page === "two",
+  "Defaults fill missing keys; unconvertible values stay strings",
+);
+assert(
+  JSON.stringify(
+    compileQuery({ additionalProperties: false, properties: { a: {} } })(
+      "b=1&a=%41",
+    ),
+  ) === '{"a":"A"}',
+  "additionalProperties: false drops undeclared keys",
+);
+
+// ==========================================
+// Test 16: Compiled Validator
+// ==========================================
+console.log("\n📋 Test 16: Compiled Validator");
+
+const refSchema = {
+  type: "object",
+  properties: {
+    a: { $ref: "#/$defs/n" },
+    list: { type: "array", items: { $ref: "#/$defs/n" } },
+  },
+  $defs: { n: { type: "integer" } },
+};
+const refBody = { a: "5", list: ["1", "2"] };
+assert(
+  compileValidator(refSchema, { coerce: true })(refBody) === null &&
+    refBody.a === 5 &&
+    refBody.list[1] === 2,
+  "coerce converts values behind $ref",
+);
+assert(
+  compileValidator(refSchema)({ a: "5" }) === "body.a must be integer",
+  "Without coerce a $ref string is still rejected",
+);
+
 // ==========================================
 // Summary
 // ==========================================
@@ -0,0 +1,141 @@
+/**
+ * Schema-based query string parser compiler.
+ *
+ * Like compile-serializer.js, uses `new Function()` to turn a route's
+ * `schema.querystring` into one specialized parser at registration. The
+ * generated function scans the raw query once with charCodeAt, switches
+ * on each key, and converts the value to the declared type right there:
+ * `?page=2&tag=a&tag=b` becomes `{ page: 2, tag: ["a", "b"] }` without an
+ * intermediate string map or a second coercion pass.
+ *
+ * The result always starts with every declared property, in declaration
+ * order (missing ones are their `default` or undefined), so all requests
+ * to a route share one object shape. A value is only decoded when its key
+ * is kept and the scan saw a `%` or `+` in it; with
+ * `additionalProperties: false` undeclared keys are dropped unread.
+ *
+ * Coercion per declared type: integer/number (numeric strings), boolean
+ * ("true", "false", and a bare flag `?debug` as true), string (as-is) and
+ * array (every occurrence of the key, items converted by `items.type`).
+ * A scalar given more than once keeps the last value. Values that don't
+ * convert are left as strings for the route's validator to reject.
+ *
+ * @module compile-query
+ */
+import { decodeComponent } from "../native.js";
+
+// Compiled parsers by schema identity
+const compiled = new WeakMap();
+
+/**
+ * Compiles a querystring schema into a parser.
+ *
+ * @param {Object} schema - JSON schema for the query object (subset)
+ * @returns {(qs: string) => Record<string, any>} Parses a raw query string (without "?")
+ */
+export function compileQuery(schema) {
+  let parse = compiled.get(schema);
+  if (parse === undefined) {
+    parse = compileRoot(schema);
+    compiled.set(schema, parse);
+  }
+  return parse;
+}
+
+// Scalar type a query value is converted to ("string": left as-is)
+function scalarOf(schema) {
+  if (!schema || typeof schema !== "object") return "string";
+  const types = Array.isArray(schema.type) ? schema.type : [schema.type];
+  for (const type of types) {
+    if (type === "integer" || type === "number" || type === "boolean") {
+      return type;
+    }
+  }
+  return "string";
+}
+
+// Statements converting the string in `v` to `type` (in place)
+function coerce(type, v) {
+  switch (type) {
+    case "integer":
+      return `{const n=+${v};if(Number.isInteger(n)&&${v}.trim()!=="")${v}=n;}`;
+    case "number":
+      return `{const n=+${v};if(Number.isFinite(n)&&${v}.trim()!=="")${v}=n;}`;
+    case "boolean":
+      return `if(${v}==="true"||${v}===""||${v}==="false")${v}=${v}!=="false";`;
+    default:
+      return "";
+  }
+}
+
+function isArray(schema) {
+  const type = schema && schema.type;
+  return type === "array" || (Array.isArray(type) && type.includes("array"));
+}
+
+function compileRoot(schema) {
+  const props = (schema && schema.properties) || {};
+  // An own "__proto__" key can't be declared on a plain object literal
+  const keys = Object.keys(props).filter((key) => key !== "__proto__");
+  const consts = [];
+
+  // Fixed shape: every declared key, default or undefined
+  const init = keys.map((key) => {
+    const def = props[key] && props[key].default;
+    let value = "undefined";
+    if (def !== undefined) {
+      if (def !== null && typeof def === "object") {
+        consts.push(def);
+        // Cloned so requests never share a default
+        value = `structuredClone(K[${consts.length - 1}])`;
+      } else {
+        value = JSON.stringify(def);
+      }
+    }
+    return `${JSON.stringify(key)}:${value}`;
+  });
+
+  // Per-array counters: the first occurrence replaces a default array
+  let seen = "";
+  let cases = "";
+  keys.forEach((key, i) => {
+    const prop = props[key];
+    const access = `o[${JSON.stringify(key)}]`;
+    cases += `case ${JSON.stringify(key)}:{let v=e<0?"":d(qs,e+1,i,ve);`;
+    if (isArray(prop)) {
+      seen += `let n${i}=0;`;
+      cases += coerce(scalarOf(prop.items), "v");
+      cases += `if(n${i}++===0)${access}=[v];else ${access}.push(v);`;
+    } else {
+      cases += coerce(scalarOf(prop), "v");
+      cases += `${access}=v;`;
+    }
+    cases += "break;}\n";
+  });
+
+  // Undeclared keys: dropped, or kept like parseQuery() keeps them
+  const extra =
+    schema && schema.additionalProperties === false
+      ? "break;"
+      : `{const v=e<0?"":d(qs,e+1,i,ve);const p=o[key];` +
+        `if(p===undefined||!Object.hasOwn(o,key))o[key]=v;` +
+        `else if(typeof p==="string")o[key]=[p,v];else p.push(v);}`;
+
+  const source =
+    `const d=D;\n` +
+    `return function parseQuery(qs){\n` +
+    `const o={${init.join(",")}};\n${seen}\n` +
+    `const len=qs.length;let s=0,e=-1,ke=0,ve=0;\n` +
+    `for(let i=0;i<=len;i++){const c=i<len?qs.charCodeAt(i):38;\n` +
+    `if(c===38){const end=e<0?i:e;if(end>s){const key=d(qs,s,end,ke);\n` +
+    `switch(key){\n${cases}default:${extra}}}\n` +
+    `s=i+1;e=-1;ke=0;ve=0;}\n` +
+    `else if(c===61){if(e<0)e=i;}\n` +
+    `else if(c===37){if(e<0)ke|=1;else ve|=1;}\n` +
+    `else if(c===43){if(e<0)ke|=2;else ve|=2;}}\n` +
+    `return o;};`;
+
+  return new Function("D", "K", source)(decodeComponent, consts);
+}
+
+export default compileQuery;
@@ -1,264 +1,416 @@
 /**
  * Schema-based JSON serializer compiler.
  *
- * Uses `new Function()` code generation to produce zero-loop,
- * straight-line serializer functions from JSON schemas.
- * Each generated function directly accesses known properties
- * by name — no loops, no dynamic dispatch, no Object.keys().
+ * Uses `new Function()` code generation to turn a JSON schema into one
+ * specialized function. Nested objects and arrays are inlined into it:
+ * known properties are read by name and appended as straight-line code,
+ * and arrays become a plain indexed loop — no closures per item, no
+ * dynamic dispatch, no Object.keys().
+ *
+ * Supported: type (incl. ["x", "null"]), properties, required, nullable,
+ * enum, const, items, additionalProperties, format: "safe" (string
+ * written without escaping) and local $ref
+ * (#/definitions/..., #/$defs/...). Anything else falls back to
+ * JSON.stringify for that value only.
  *
  * This is the same technique used by Fastify's fast-json-stringify.
  *
  * @module compile-serializer
  */
 
+// Characters JSON requires escaping (control chars, quote, backslash)
+const ESCAPE_TEST = /[\u0000-\u001f"\\]/;
+const ESCAPE_SCAN = /[\u0000-\u001f"\\]/g;
+
+// Below this length a clean/dirty regex test beats scanning with exec()
+// (see tests/bench-escape.js)
+const SHORT_STRING = 256;
+
 /**
  * Escapes a string for JSON output.
  * Handles: " \ \b \f \n \r \t and control chars.
  * This function is passed into generated serializers.
+ *
+ * Tiered: short strings are checked with one native regex test and
+ * returned as-is when clean (the common case for IDs and slugs), or handed
+ * to the native JSON.stringify when not. Long strings jump from one escape
+ * to the next with a global regex, copying the clean chunks in between
+ * with a single slice each.
  */
-function escapeString(str) {
-  if (str.length === 0) return '""';
+export function escapeString(str) {
+  if (str.length < SHORT_STRING) {
+    return ESCAPE_TEST.test(str) ? JSON.stringify(str) : '"' + str + '"';
+  }
+  return escapeChunks(str);
+}
+
+function escapeChunks(str) {
+  ESCAPE_SCAN.lastIndex = 0;
+  let match = ESCAPE_SCAN.exec(str);
+  if (match === null) return '"' + str + '"';
 
   let result = '"';
   let last = 0;
-
-  for (let i = 0; i < str.length; i++) {
+  do {
+    const i = match.index;
+    if (i > last) result += str.slice(last, i);
     const code = str.charCodeAt(i);
-    if (code < 32 || code === 34 || code === 92) {
-      if (i > last) result += str.slice(last, i);
-      switch (code) {
-        case 34:
-          result += '\\"';
-          break;
-        case 92:
-          result += "\\\\";
-          break;
-        case 8:
-          result += "\\b";
-          break;
-        case 12:
-          result += "\\f";
-          break;
-        case 10:
-          result += "\\n";
-          break;
-        case 13:
-          result += "\\r";
-          break;
-        case 9:
-          result += "\\t";
-          break;
-        default:
-          result += "\\u" + code.toString(16).padStart(4, "0");
-      }
-      last = i + 1;
+    switch (code) {
+      case 34:
+        result += '\\"';
+        break;
+      case 92:
+        result += "\\\\";
+        break;
+      case 8:
+        result += "\\b";
+        break;
+      case 12:
+        result += "\\f";
+        break;
+      case 10:
+        result += "\\n";
+        break;
+      case 13:
+        result += "\\r";
+        break;
+      case 9:
+        result += "\\t";
+        break;
+      default:
+        result += "\\u" + code.toString(16).padStart(4, "0");
     }
-  }
+    last = i + 1;
+    match = ESCAPE_SCAN.exec(str);
+  } while (match !== null);
 
-  if (last === 0) return '"' + str + '"';
   if (last < str.length) result += str.slice(last);
   return result + '"';
 }
 
+// Compiled serializers by schema identity (same schema object, same function)
+const compiled = new WeakMap();
+
 /**
  * Compiles a JSON schema into a specialized serializer function
  * using code generation for maximum V8 optimization.
  *
+ * Array schemas also expose `serializer.item`, the compiled item function,
+ * so large arrays can be streamed in chunks.
+ *
  * @param {Object} schema - JSON schema (subset)
- * @returns {(data: any) => string} Compiled serializer
+ * @returns {((data: any) => string) & { item?: (item: any) => string }} Compiled serializer
  */
 export function compileSerializer(schema) {
-  if (!schema || !schema.type) {
+  if (!schema || typeof schema !== "object" || !isTyped(schema)) {
     return JSON.stringify;
   }
 
-  return compileType(schema);
+  let serializer = compiled.get(schema);
+  if (serializer === undefined) {
+    serializer = compileRoot(schema);
+    compiled.set(schema, serializer);
+  }
+  return serializer;
 }
 
-/**
- * Generates a code-gen serializer for an object schema.
- * Produces a single straight-line function with no loops.
- */
-function compileObject(schema) {
-  const props = schema.properties;
-  if (!props) return JSON.stringify;
-
-  const keys = Object.keys(props);
-  if (keys.length === 0) return () => "{}";
-
-  // Build the function body as a single expression
-  const parts = [];
+// Anything the generator can specialize on
+function isTyped(schema) {
+  return (
+    schema.type !== undefined ||
+    schema.properties !== undefined ||
+    schema.items !== undefined ||
+    schema.$ref !== undefined ||
+    schema.enum !== undefined ||
+    schema.const !== undefined
+  );
+}
 
-  for (let i = 0; i < keys.length; i++) {
-    const key = keys[i];
-    const prop = props[key];
-    const comma = i > 0 ? "," : "";
-    const jsonKey = `${comma}"${key}":`;
+function serializeNumber(v) {
+  if (v === null || v === undefined) return "null";
+  const n = +v;
+  if (n !== n || n === Infinity || n === -Infinity) return "null";
+  return "" + n;
+}
 
-    // Generate inline serialization code per property type
-    parts.push({ key, jsonKey, type: prop.type || "unknown", schema: prop });
-  }
+function serializeAny(v) {
+  const json = JSON.stringify(v);
+  return json === undefined ? "null" : json;
+}
 
-  // Check if all string — ultra-fast codegen path
-  const allSimple = parts.every(
-    (p) =>
-      p.type === "string" ||
-      p.type === "number" ||
-      p.type === "integer" ||
-      p.type === "boolean",
-  );
+/**
+ * Generates the serializer source. `$ref` targets become named helper
+ * functions inside the same generated closure (compiled once each, so
+ * recursive schemas work); everything else is inlined.
+ */
+function compileRoot(root) {
+  const ctx = {
+    root,
+    ids: 0,
+    consts: [], // values handed to the generated closure (enum maps, key sets)
+    refs: new Map(), // $ref -> helper function name
+    helpers: [], // generated helper function sources
+  };
 
-  if (allSimple && keys.length <= 16) {
-    // Generate a straight-line function via new Function()
-    // This avoids all loops and dynamic dispatch
-    let body = 'if(o===null||o===undefined)return"null";\n';
-    body += "return '{' + ";
-
-    const segments = [];
-    for (let i = 0; i < parts.length; i++) {
-      const p = parts[i];
-      const accessor = `o[${JSON.stringify(p.key)}]`;
-      let valExpr;
-
-      switch (p.type) {
-        case "string":
-          valExpr = `(${accessor}===null||${accessor}===undefined?"null":e(""+${accessor}))`;
-          break;
-        case "number":
-        case "integer":
-          valExpr = `(${accessor}!=${accessor}||${accessor}===1/0||${accessor}===-1/0?"null":""+${accessor})`;
-          break;
-        case "boolean":
-          valExpr = `(${accessor}?"true":"false")`;
-          break;
-      }
+  const main = genValue(ctx, root, "o");
 
-      segments.push(`'${p.jsonKey}'+${valExpr}`);
-    }
+  // Arrays also get a per-item function for streaming (see stream-json.js)
+  const isArray = kindOf(root).type === "array";
+  const items = root.items;
+  const item =
+    isArray && items && typeof items === "object" && !Array.isArray(items)
+      ? genValue(ctx, items, "o")
+      : null;
 
-    body += segments.join("+") + "+'}';";
+  let source = "";
+  for (let i = 0; i < ctx.consts.length; i++) {
+    source += `const k${i}=K[${i}];\n`;
+  }
+  source += ctx.helpers.join("\n");
+  source += `\nconst serialize=function serialize(o){let r="";\n${main}return r;};`;
+  if (item) {
+    source += `\nserialize.item=function serializeItem(o){let r="";\n${item}return r;};`;
+  } else if (isArray) {
+    source += "\nserialize.item=J;";
+  }
+  source += "\nreturn serialize;";
 
-    try {
-      return new Function("e", "o", body).bind(null, escapeString);
-    } catch {
-      // Fallback if code-gen fails
-      return buildFallbackSerializer(parts);
-    }
+  try {
+    return new Function("e", "n", "J", "K", source)(
+      escapeString,
+      serializeNumber,
+      serializeAny,
+      ctx.consts,
+    );
+  } catch {
+    // Fallback if code-gen fails
+    return JSON.stringify;
   }
+}
 
-  // Complex types (nested objects, arrays) — use pre-compiled sub-serializers
-  return buildComplexSerializer(parts);
+function addConst(ctx, value) {
+  ctx.consts.push(value);
+  return `k${ctx.consts.length - 1}`;
 }
 
 /**
- * Builds a serializer for complex schemas with nested objects/arrays.
- * Uses pre-compiled child serializers (no code-gen).
+ * Resolves a local JSON pointer ("#", "#/definitions/x", "#/$defs/x").
+ * Shared with compile-validator.js.
+ * @param {Object} root - Schema the pointer is relative to
+ * @param {string} ref
+ * @returns {Object | null} The target, or null when it doesn't resolve
  */
-function buildComplexSerializer(parts) {
-  // Pre-compile child serializers
-  const entries = parts.map((p) => ({
-    key: p.key,
-    jsonKey: p.jsonKey,
-    serializer: compileType(p.schema),
-  }));
-
-  return function serializeComplex(obj) {
-    if (obj === null || obj === undefined) return "null";
-    let result = "{";
-    for (let i = 0; i < entries.length; i++) {
-      const e = entries[i];
-      const v = obj[e.key];
-      result += e.jsonKey;
-      if (v === null || v === undefined) {
-        result += "null";
-      } else {
-        result += e.serializer(v);
-      }
+export function resolveRef(root, ref) {
+  if (ref === "#") return root;
+  if (!ref.startsWith("#/")) return null;
+  let node = root;
+  for (const raw of ref.slice(2).split("/")) {
+    const part = decodeURIComponent(raw).replace(/~1/g, "/").replace(/~0/g, "~");
+    if (node === null || typeof node !== "object" || !(part in node)) {
+      return null;
     }
-    return result + "}";
-  };
+    node = node[part];
+  }
+  return node;
 }
 
 /**
- * Fallback serializer when code-gen fails.
+ * Normalizes a schema to { type, nullable }. `type` is one of the
+ * generator's cases; "any" means JSON.stringify for this value.
  */
-function buildFallbackSerializer(parts) {
-  const entries = parts.map((p) => ({
-    key: p.key,
-    jsonKey: p.jsonKey,
-    type: p.type,
-  }));
-
-  return function serializeFallback(obj) {
-    if (obj === null || obj === undefined) return "null";
-    let result = "{";
-    for (let i = 0; i < entries.length; i++) {
-      const e = entries[i];
-      const v = obj[e.key];
-      result += e.jsonKey;
-      if (v === null || v === undefined) {
-        result += "null";
-      } else if (e.type === "string") {
-        result += escapeString("" + v);
-      } else {
-        result += "" + v;
-      }
-    }
-    return result + "}";
-  };
+function kindOf(schema) {
+  let type = schema.type;
+  let nullable = schema.nullable === true;
+
+  if (Array.isArray(type)) {
+    const rest = type.filter((t) => t !== "null");
+    nullable = nullable || rest.length < type.length;
+    type = rest.length === 0 ? "null" : rest.length === 1 ? rest[0] : "any";
+  }
+
+  if (type === undefined) {
+    if (schema.properties || schema.additionalProperties) type = "object";
+    else if (schema.items) type = "array";
+    else if (Array.isArray(schema.enum)) type = enumType(schema.enum);
+    else type = "any";
+  }
+
+  return { type, nullable };
+}
+
+function enumType(values) {
+  if (values.every((v) => typeof v === "string")) return "string";
+  if (values.every((v) => typeof v === "number")) return "number";
+  if (values.every((v) => typeof v === "boolean")) return "boolean";
+  return "any";
 }
 
 /**
- * Compiles a type-specific serializer from schema.
+ * Returns statements that append the JSON for the value held in the
+ * local `v` to `r`.
  */
-function compileType(schema) {
-  switch (schema.type) {
-    case "object":
-      return compileObject(schema);
-    case "array":
-      return compileArray(schema);
+function genValue(ctx, schema, v) {
+  if (!schema || typeof schema !== "object") return `r+=J(${v});\n`;
+
+  if (schema.$ref !== undefined) return genRef(ctx, schema.$ref, v);
+
+  // const: the value is known, emit it as a literal
+  if (schema.const !== undefined) {
+    return `r+=${JSON.stringify(JSON.stringify(schema.const))};\n`;
+  }
+
+  const { type, nullable } = kindOf(schema);
+  const typed = genType(ctx, schema, type, nullable, v);
+
+  // enum: members map straight to their precomputed JSON
+  if (Array.isArray(schema.enum) && schema.enum.length > 0) {
+    const map = addConst(
+      ctx,
+      new Map(schema.enum.map((m) => [m, JSON.stringify(m)])),
+    );
+    const id = ++ctx.ids;
+    return `{const s${id}=${map}.get(${v});if(s${id}!==undefined)r+=s${id};else{\n${typed}}}\n`;
+  }
+
+  return typed;
+}
+
+function genType(ctx, schema, type, nullable, v) {
+  switch (type) {
     case "string":
-      return escapeString;
+      // format: "safe" — the schema guarantees nothing needs escaping
+      if (schema.format === "safe") {
+        return `r+=typeof ${v}==="string"?'"'+${v}+'"':${v}===null||${v}===undefined?"null":e(""+${v});\n`;
+      }
+      return `r+=typeof ${v}==="string"?e(${v}):${v}===null||${v}===undefined?"null":e(""+${v});\n`;
     case "number":
     case "integer":
-      return serializeNumber;
+      return `r+=Number.isFinite(${v})?""+${v}:n(${v});\n`;
     case "boolean":
-      return serializeBoolean;
+      if (nullable) {
+        return `r+=${v}===null||${v}===undefined?"null":${v}?"true":"false";\n`;
+      }
+      return `r+=${v}?"true":"false";\n`;
     case "null":
-      return () => "null";
+      return `r+="null";\n`;
+    case "object":
+      return genObject(ctx, schema, v);
+    case "array":
+      return genArray(ctx, schema, v);
     default:
-      return JSON.stringify;
+      return `r+=J(${v});\n`;
   }
 }
 
-function serializeNumber(v) {
-  if (v !== v || v === Infinity || v === -Infinity) return "null";
-  return "" + v;
+function genRef(ctx, ref, v) {
+  let name = ctx.refs.get(ref);
+  if (name === undefined) {
+    const target = resolveRef(ctx.root, ref);
+    if (!target) return `r+=J(${v});\n`;
+    name = `f${ctx.refs.size}`;
+    // Register before generating, so a recursive $ref calls itself
+    ctx.refs.set(ref, name);
+    const body = genValue(ctx, target, "o");
+    ctx.helpers.push(`function ${name}(o){let r="";\n${body}return r;}`);
+  }
+  return `r+=${name}(${v});\n`;
 }
 
-function serializeBoolean(v) {
-  return v ? "true" : "false";
-}
+function genObject(ctx, schema, v) {
+  const props = schema.properties || {};
+  const keys = Object.keys(props);
+  const extra = schema.additionalProperties;
+  const hasExtra = extra !== undefined && extra !== false;
 
-/**
- * Compiles an array serializer from schema.items.
- */
-function compileArray(schema) {
-  const itemSerializer = schema.items
-    ? compileType(schema.items)
-    : JSON.stringify;
-
-  return function serializeArray(arr) {
-    if (!Array.isArray(arr)) return "null";
-    const len = arr.length;
-    if (len === 0) return "[]";
-
-    let result = "[" + itemSerializer(arr[0]);
-    for (let i = 1; i < len; i++) {
-      result += "," + itemSerializer(arr[i]);
+  // Without a `required` list every property is written (missing -> null);
+  // with one, missing optional properties are left out
+  const required = Array.isArray(schema.required)
+    ? new Set(schema.required)
+    : null;
+
+  const id = ++ctx.ids;
+  const comma = `c${id}`;
+  let code = `if(${v}===null||${v}===undefined)r+="null";else{r+="{";\n`;
+
+  // Commas are static while we know whether something was written already
+  let known = true;
+  let written = false;
+  const optional = required !== null && keys.some((k) => !required.has(k));
+  if (optional || hasExtra) code += `let ${comma}=false;\n`;
+
+  // "," / "" when known statically, null when the flag decides at runtime
+  const sep = () => (known ? (written ? "," : "") : null);
+
+  for (let i = 0; i < keys.length; i++) {
+    const key = keys[i];
+    const local = `p${id}_${i}`;
+    const label = JSON.stringify(key) + ":";
+    code += `const ${local}=${v}[${JSON.stringify(key)}];\n`;
+
+    const s = sep();
+    const write =
+      (s === null
+        ? `r+=${comma}?${JSON.stringify("," + label)}:${JSON.stringify(label)};\n`
+        : `r+=${JSON.stringify(s + label)};\n`) +
+      genValue(ctx, props[key], local) +
+      (optional || hasExtra ? `${comma}=true;\n` : "");
+
+    if (required === null) {
+      code += write;
+      known = true;
+      written = true;
+    } else if (required.has(key)) {
+      code += `if(${local}===undefined)throw new Error(${JSON.stringify(`"${key}" is required!`)});\n`;
+      code += write;
+      known = true;
+      written = true;
+    } else {
+      code += `if(${local}!==undefined){\n${write}}\n`;
+      if (!(known && written)) known = false;
     }
-    return result + "]";
-  };
+  }
+
+  if (hasExtra) {
+    const k = `a${id}`;
+    const x = `x${id}`;
+    let skip = "false";
+    if (keys.length > 0 && keys.length <= 16) {
+      skip = keys.map((key) => `${k}===${JSON.stringify(key)}`).join("||");
+    } else if (keys.length > 16) {
+      skip = `${addConst(ctx, new Set(keys))}.has(${k})`;
+    }
+    const s = sep();
+    code += `for(const ${k} in ${v}){if(${skip})continue;const ${x}=${v}[${k}];if(${x}===undefined)continue;\n`;
+    code += s === "," ? `r+=",";` : `if(${comma})r+=",";`;
+    code += `r+=e(${k})+":";\n`;
+    code +=
+      extra === true || typeof extra !== "object"
+        ? `r+=J(${x});\n`
+        : genValue(ctx, extra, x);
+    code += `${comma}=true;}\n`;
+  }
+
+  return code + `r+="}";}\n`;
+}
+
+function genArray(ctx, schema, v) {
+  const items = schema.items;
+  const id = ++ctx.ids;
+  const i = `i${id}`;
+  const x = `x${id}`;
+
+  // Tuple schemas (items as an array) are left to JSON.stringify
+  const item =
+    items && typeof items === "object" && !Array.isArray(items)
+      ? genValue(ctx, items, x)
+      : `r+=J(${x});\n`;
+
+  return (
+    `if(!Array.isArray(${v}))r+="null";else{r+="[";\n` +
+    `for(let ${i}=0;${i}<${v}.length;${i}++){if(${i}!==0)r+=",";const ${x}=${v}[${i}];\n` +
+    item +
+    `}r+="]";}\n`
+  );
 }
 
 export default compileSerializer;
@@ -0,0 +1,95 @@
+import { installResponseMethods } from "./response.js";
+import { REQUEST_CLASSES, RESPONSE_CLASSES } from "./protocols.js";
+
+/**
+ * Request and reply decorators as prototype accessors.
+ *
+ * A decorator is installed once per name on the request / response
+ * prototypes of every protocol, the same way `req.query` is. Nothing is
+ * copied onto requests: the accessor looks the value up in the app's own
+ * decorator table (via `_vibeOptions`), runs factories on first read, and
+ * keeps per-request values (factory results, assignments) in one lazily
+ * created `_decorations` object. Every request keeps the same shape no
+ * matter which decorators exist or are used.
+ */
+
+// Names installed by decorate*(), per prototype
+const INSTALLED = Symbol("vibe.decorators");
+
+// Own fields Vibe sets on every request; a decorator would be shadowed
+const REQUEST_FIELDS = new Set([
+  "params",
+  "route",
+  "body",
+  "files",
+  "query",
+  "id",
+  "log",
+  "ip",
+]);
+
+function storage(target) {
+  return (target._decorations ??= Object.create(null));
+}
+
+/**
+ * @param {string} name
+ * @param {"requestDecorators" | "replyDecorators"} kind - Table in the app options
+ * @param {boolean} factories - Functions are factories (request) rather than methods (reply)
+ */
+function accessor(name, kind, factories) {
+  return {
+    get() {
+      const own = this._decorations;
+      if (own != null && name in own) return own[name];
+      const table = this._vibeOptions?.[kind];
+      if (table === undefined || !(name in table)) return undefined;
+      const value = table[name];
+      if (!factories || typeof value !== "function") return value;
+      // Factory: runs on first read, once per request
+      return (storage(this)[name] = value());
+    },
+    set(value) {
+      storage(this)[name] = value;
+    },
+    configurable: true,
+  };
+}
+
+function install(classes, name, kind, factories, label) {
+  const pending = classes
+    .map((Class) => Class.prototype)
+    .filter((proto) => !proto[INSTALLED]?.has(name));
+  // Check every protocol first so a clash installs nothing
+  for (const proto of pending) {
+    if (name in proto || (factories && REQUEST_FIELDS.has(name))) {
+      throw new Error(
+        `${label} decorator '${name}' conflicts with a built-in property`,
+      );
+    }
+  }
+  for (const proto of pending) {
+    Object.defineProperty(proto, name, accessor(name, kind, factories));
+    (proto[INSTALLED] ??= new Set()).add(name);
+  }
+}
+
+/**
+ * Make `req[name]` read the app's request decorator.
+ * A function value is a factory, called once per request on first read.
+ * @param {string} name
+ */
+export function installRequestDecorator(name) {
+  install(REQUEST_CLASSES, name, "requestDecorators", true, "Request");
+}
+
+/**
+ * Make `res[name]` read the app's reply decorator.
+ * A function value is a method (`this` is the response).
+ * @param {string} name
+ */
+export function installReplyDecorator(name) {
+  // Built-in response helpers must be in place to detect clashes
+  for (const Response of RESPONSE_CLASSES) installResponseMethods(Response);
+  install(RESPONSE_CLASSES, name, "replyDecorators", false, "Reply");
+}
@@ -182,9 +182,10 @@ export function handleError(error, req, res) {
  * Finds the local network IP address (IPv4)
  * @param {string} host
  * @param {number} port
+ * @param {string} [scheme="http"]
  * @returns {void}
  */
-export function getNetworkIP(host, port) {
+export function getNetworkIP(host, port, scheme = "http") {
   const interfaces = os.networkInterfaces();
   const addresses = [];
 
@@ -204,16 +205,22 @@ export function getNetworkIP(host, port) {
     if (host === "0.0.0.0") {
       // => listens on all ipv4 hosts
       if (addrs.fam === "IPv4")
-        log(`Server listening at - \x1b[4mhttp://${addrs.address}:${port}`);
+        log(
+          `Server listening at - \x1b[4m${scheme}://${addrs.address}:${port}`,
+        );
     }
 
     if (host === "::") {
       // => listens on all ipv6/ipv4 hosts
-      log(`Server listening at - \x1b[4mhttp://${addrs.address}:${port}`);
+      log(
+        `Server listening at - \x1b[4m${scheme}://${addrs.address}:${port}`,
+      );
     }
 
     if (addrs.address === host) {
-      log(`Server listening at - \x1b[4mhttp://${addrs.address}:${port}`);
+      log(
+        `Server listening at - \x1b[4m${scheme}://${addrs.address}:${port}`,
+      );
     }
   }
 }
@@ -0,0 +1,388 @@
+/**
+ * Incremental JSON parsing for request bodies.
+ *
+ * A byte-level scanner follows the document structure as chunks arrive
+ * and cuts out only the values matched by a path such as `$.items[*]`.
+ * Each matched value is handed to JSON.parse on its own, so memory is
+ * bounded by the largest selected value rather than the whole document.
+ * Everything outside the selection is skipped without being decoded.
+ *
+ * @module json-select
+ */
+
+// Scanner states
+const VALUE = 0; // expecting a value
+const ARRAY_FIRST = 1; // after "[": value or "]"
+const OBJECT_FIRST = 2; // after "{": key or "}"
+const KEY = 3; // after "," in an object: key
+const COLON = 4; // after a key
+const AFTER = 5; // after a value: "," or a closing bracket
+const STRING = 6; // inside a value string
+const KEY_STRING = 7; // inside a key string
+const ATOM = 8; // inside a number, true, false or null
+const DONE = 9; // root value finished, only whitespace may follow
+
+/** Matches any key or index (`*`) */
+const ANY = Symbol("any");
+
+/**
+ * Parse a JSONPath subset: `$`, `.key`, `.*`, `[*]`, `[0]`, `['key']`.
+ * @param {string} path
+ * @returns {Array<string | number | symbol>}
+ */
+export function parsePath(path) {
+  if (typeof path !== "string" || path[0] !== "$") {
+    throw new TypeError(`Invalid JSON path "${path}": must start with "$"`);
+  }
+  const re = /\.([A-Za-z_$][\w$]*|\*)|\[(\*|\d+|'[^']*'|"[^"]*")\]/y;
+  const segments = [];
+  re.lastIndex = 1;
+  while (re.lastIndex < path.length) {
+    const at = re.lastIndex;
+    const m = re.exec(path);
+    if (!m) {
+      throw new TypeError(`Invalid JSON path "${path}" at offset ${at}`);
+    }
+    const seg = m[1] ?? m[2];
+    if (seg === "*") segments.push(ANY);
+    else if (m[2] && /^\d/.test(seg)) segments.push(Number(seg));
+    else if (m[2]) segments.push(seg.slice(1, -1));
+    else segments.push(seg);
+  }
+  return segments;
+}
+
+function isSpace(c) {
+  return c === 0x20 || c === 0x0a || c === 0x0d || c === 0x09;
+}
+
+function unexpected(c, offset) {
+  return new SyntaxError(
+    `Unexpected ${c === undefined ? "end of JSON input" : `token ${JSON.stringify(String.fromCharCode(c))}`} at byte ${offset}`,
+  );
+}
+
+/**
+ * Push parser: feed Buffers with write(), call end() once the input is
+ * exhausted. onValue runs synchronously for every selected value, in
+ * document order.
+ */
+export class JsonSelectParser {
+  /**
+   * @param {string} [path="$"] - Values to emit; "$" emits the whole document
+   * @param {(value: any) => void} onValue
+   * @param {{ maxItemSize?: number }} [options]
+   */
+  constructor(path = "$", onValue, options = {}) {
+    this.segments = parsePath(path);
+    this.onValue = onValue;
+    this.maxItemSize = options.maxItemSize || Infinity;
+
+    this.state = VALUE;
+    this.stack = []; // { array, key, track } per open container
+    this.offset = 0; // bytes consumed before the current chunk
+    this.escaped = false; // string state carried across chunks
+
+    // Selected value being cut out (-1 = not capturing)
+    this.capDepth = -1;
+    this.capParts = [];
+    this.capSize = 0;
+
+    // Object key being decoded (only on the selected path)
+    this.keyWanted = false;
+    this.keyParts = [];
+  }
+
+  /**
+   * Whether a value starting now sits on the selected path at depth n
+   */
+  _here(n) {
+    if (n === 0) return true;
+    const top = this.stack[n - 1];
+    if (!top.track) return false;
+    const seg = this.segments[n - 1];
+    return seg === ANY || seg === top.key;
+  }
+
+  /**
+   * A value starts at index i: begin capturing if it is selected
+   */
+  _start(n, i) {
+    if (this.capDepth < 0 && n === this.segments.length && this._here(n)) {
+      this.capDepth = n;
+      this.capStart = i;
+      this.capSize = 0;
+    }
+  }
+
+  _push(array, n) {
+    this.stack.push({
+      array,
+      key: array ? 0 : null,
+      track: this.capDepth < 0 && n < this.segments.length && this._here(n),
+    });
+  }
+
+  /**
+   * The captured value ended just before index end of chunk
+   */
+  _emit(chunk, end) {
+    const parts = this.capParts;
+    const tail = chunk.subarray(this.capStart, end);
+    this.capSize += tail.length;
+    this.capDepth = -1;
+    if (this.capSize > this.maxItemSize) {
+      throw new RangeError(`Selected value exceeds ${this.maxItemSize} bytes`);
+    }
+    let text;
+    if (parts.length === 0) {
+      text = tail.toString();
+    } else {
+      parts.push(tail);
+      text = Buffer.concat(parts, this.capSize).toString();
+      this.capParts = [];
+    }
+    this.onValue(JSON.parse(text));
+  }
+
+  /**
+   * Index of the quote closing the string that continues at from, or -1
+   * when it runs past this chunk. Jumps between quotes with indexOf and
+   * only looks at the backslashes right before each one.
+   */
+  _stringEnd(chunk, from) {
+    let start = from;
+    let escaped = this.escaped; // last chunk ended on an unpaired backslash
+    for (;;) {
+      const q = chunk.indexOf(0x22, start);
+      const stop = q < 0 ? chunk.length : q;
+      let j = stop - 1;
+      while (j >= start && chunk[j] === 0x5c) j--;
+      let run = stop - 1 - j;
+      if (j < start && escaped) run++;
+      if (q < 0) {
+        this.escaped = (run & 1) === 1;
+        return -1;
+      }
+      if ((run & 1) === 0) {
+        this.escaped = false;
+        return q;
+      }
+      start = q + 1;
+      escaped = false;
+    }
+  }
+
+  _key(chunk, end) {
+    const tail = chunk.subarray(this.keyStart, end);
+    let raw;
+    if (this.keyParts.length === 0) {
+      raw = tail.toString();
+    } else {
+      this.keyParts.push(tail);
+      raw = Buffer.concat(this.keyParts).toString();
+      this.keyParts = [];
+    }
+    this.stack[this.stack.length - 1].key = raw.includes("\\")
+      ? JSON.parse(`"${raw}"`)
+      : raw;
+  }
+
+  /**
+   * Feed the next chunk of the document
+   * @param {Buffer} chunk
+   */
+  write(chunk) {
+    const stack = this.stack;
+    const len = chunk.length;
+    let state = this.state;
+    let i = 0;
+
+    for (; i < len; i++) {
+      let c = chunk[i];
+
+      switch (state) {
+        case STRING: {
+          const q = this._stringEnd(chunk, i);
+          if (q < 0) {
+            i = len;
+            continue;
+          }
+          i = q;
+          if (this.capDepth === stack.length) this._emit(chunk, i + 1);
+          state = stack.length === 0 ? DONE : AFTER;
+          continue;
+        }
+
+        case KEY_STRING: {
+          const q = this._stringEnd(chunk, i);
+          if (q < 0) {
+            i = len;
+            continue;
+          }
+          i = q;
+          if (this.keyWanted) this._key(chunk, i);
+          state = COLON;
+          continue;
+        }
+
+        case ATOM:
+          while (
+            c !== 0x2c &&
+            c !== 0x5d &&
+            c !== 0x7d &&
+            !isSpace(c) &&
+            ++i < len
+          ) {
+            c = chunk[i];
+          }
+          if (i < len) {
+            if (this.capDepth === stack.length) this._emit(chunk, i);
+            state = stack.length === 0 ? DONE : AFTER;
+            i--; // the delimiter belongs to the parent
+          }
+          continue;
+      }
+
+      if (isSpace(c)) continue;
+
+      switch (state) {
+        case ARRAY_FIRST:
+          if (c === 0x5d) {
+            state = this._close(chunk, i, true);
+            continue;
+          }
+        // falls through
+        case VALUE: {
+          const n = stack.length;
+          this._start(n, i);
+          if (c === 0x22) {
+            state = STRING;
+          } else if (c === 0x7b) {
+            this._push(false, n);
+            state = OBJECT_FIRST;
+          } else if (c === 0x5b) {
+            this._push(true, n);
+            state = ARRAY_FIRST;
+          } else if (
+            c === 0x2d ||
+            (c >= 0x30 && c <= 0x39) ||
+            c === 0x74 ||
+            c === 0x66 ||
+            c === 0x6e
+          ) {
+            state = ATOM;
+          } else {
+            throw unexpected(c, this.offset + i);
+          }
+          continue;
+        }
+
+        case OBJECT_FIRST:
+          if (c === 0x7d) {
+            state = this._close(chunk, i, false);
+            continue;
+          }
+        // falls through
+        case KEY:
+          if (c !== 0x22) throw unexpected(c, this.offset + i);
+          this.keyWanted = stack[stack.length - 1].track;
+          this.keyStart = i + 1;
+          state = KEY_STRING;
+          continue;
+
+        case COLON:
+          if (c !== 0x3a) throw unexpected(c, this.offset + i);
+          state = VALUE;
+          continue;
+
+        case AFTER: {
+          const top = stack[stack.length - 1];
+          if (c === 0x2c) {
+            if (top.array) {
+              top.key++;
+              state = VALUE;
+            } else {
+              state = KEY;
+            }
+          } else if (c === (top.array ? 0x5d : 0x7d)) {
+            state = this._close(chunk, i, top.array);
+          } else {
+            throw unexpected(c, this.offset + i);
+          }
+          continue;
+        }
+
+        default: // DONE
+          throw unexpected(c, this.offset + i);
+      }
+    }
+
+    // Carry unfinished captures over to the next chunk
+    if (this.capDepth >= 0) {
+      const part = chunk.subarray(this.capStart);
+      this.capParts.push(part);
+      this.capSize += part.length;
+      this.capStart = 0;
+      if (this.capSize > this.maxItemSize) {
+        throw new RangeError(
+          `Selected value exceeds ${this.maxItemSize} bytes`,
+        );
+      }
+    }
+    if (state === KEY_STRING && this.keyWanted) {
+      this.keyParts.push(chunk.subarray(this.keyStart));
+      this.keyStart = 0;
+    }
+
+    this.state = state;
+    this.offset += len;
+  }
+
+  /**
+   * Closing bracket at index i; returns the next state
+   */
+  _close(chunk, i, array) {
+    const top = this.stack.pop();
+    if (top.array !== array) throw unexpected(chunk[i], this.offset + i);
+    if (this.capDepth === this.stack.length) this._emit(chunk, i + 1);
+    return this.stack.length === 0 ? DONE : AFTER;
+  }
+
+  /**
+   * Signal the end of input; throws if the document is incomplete
+   */
+  end() {
+    if (this.state === ATOM && this.stack.length === 0) {
+      // A bare number or literal at the root ends with the input
+      if (this.capDepth === 0) this._emit(Buffer.alloc(0), 0);
+      this.state = DONE;
+    }
+    if (this.state !== DONE) throw unexpected(undefined, this.offset);
+  }
+}
+
+/**
+ * Yield every value matched by path as the stream is read. The stream is
+ * consumed with backpressure: the next chunk is only read once the values
+ * of the previous one have been taken.
+ *
+ * @param {AsyncIterable<Buffer | string>} stream
+ * @param {string} path
+ * @param {{ maxItemSize?: number }} [options]
+ * @returns {AsyncGenerator<any>}
+ */
+export async function* selectJson(stream, path, options) {
+  let out = [];
+  const parser = new JsonSelectParser(path, (v) => out.push(v), options);
+
+  for await (const chunk of stream) {
+    parser.write(typeof chunk === "string" ? Buffer.from(chunk) : chunk);
+    if (out.length === 0) continue;
+    const ready = out;
+    out = [];
+    yield* ready;
+  }
+  parser.end();
+  yield* out;
+}
@@ -0,0 +1,215 @@
+/**
+ * Buffered log destinations for the structured Logger.
+ *
+ * Records arrive already serialized; they are appended to one reusable
+ * Buffer and written out in batches when the buffer fills or the flush
+ * interval fires. Optionally the actual write happens on a worker thread
+ * so the event loop never blocks on slow stdout/disk.
+ */
+import fs from "fs";
+import { Worker } from "worker_threads";
+
+/**
+ * Buffered sink options
+ * @typedef {Object} BufferOptions
+ * @property {number} [size=65536] - Buffer size in bytes (flushes when full)
+ * @property {number} [interval=1000] - Max time (ms) a record waits before flush
+ * @property {boolean} [worker=false] - Write batches from a worker_threads sink (needs a numeric fd)
+ */
+
+// Shared state slots between the main thread and the worker sink
+const BUSY = 0; // worker is inside a write
+const DONE = 1; // number of batches the worker has written
+const CLOSING = 2; // main thread took over writing (exit/shutdown)
+
+// Worker body: writes batches to the fd until the main thread takes over
+const WORKER_SOURCE = `
+const fs = require("fs");
+const { parentPort, workerData } = require("worker_threads");
+const state = new Int32Array(workerData.state);
+parentPort.on("message", (chunk) => {
+  if (Atomics.load(state, ${CLOSING}) === 1) return;
+  Atomics.store(state, ${BUSY}, 1);
+  if (Atomics.load(state, ${CLOSING}) === 0) {
+    let off = 0;
+    try {
+      while (off < chunk.length) off += fs.writeSync(workerData.fd, chunk, off);
+    } catch {}
+    Atomics.add(state, ${DONE}, 1);
+  }
+  Atomics.store(state, ${BUSY}, 0);
+  Atomics.notify(state, ${BUSY});
+});
+`;
+
+// Sinks flushed synchronously when the process exits
+const liveSinks = new Set();
+let exitHookInstalled = false;
+
+function installExitHook() {
+  if (exitHookInstalled) return;
+  exitHookInstalled = true;
+  process.on("exit", () => {
+    for (const sink of liveSinks) sink.flushSync();
+  });
+}
+
+/**
+ * Batches pre-serialized log lines into a reusable Buffer.
+ */
+export class BufferedSink {
+  /**
+   * @param {NodeJS.WritableStream | { fd: number }} target
+   * @param {BufferOptions} [options]
+   */
+  constructor(target, options = {}) {
+    this.target = target;
+    this.size = options.size || 64 * 1024;
+    this.interval = options.interval || 1000;
+    this.buffer = Buffer.allocUnsafe(this.size);
+    this.offset = 0;
+
+    // One write path for the sink's lifetime, so batches can't reorder:
+    // a numeric fd is written directly (sync), anything else via write()
+    this.fd = typeof target.fd === "number" ? target.fd : null;
+    this.worker = null;
+    this.state = null;
+    // Batches posted to the worker but not yet written (kept for takeover)
+    this.inflight = [];
+    this.acked = 0;
+
+    if (options.worker && this.fd !== null) {
+      const shared = new SharedArrayBuffer(12);
+      this.state = new Int32Array(shared);
+      this.worker = new Worker(WORKER_SOURCE, {
+        eval: true,
+        workerData: { fd: this.fd, state: shared },
+        // Don't inherit flags like --input-type=module into the CJS body
+        execArgv: [],
+      });
+      // A dead worker must not lose logs: take over on the main thread
+      this.worker.on("error", () => this.flushSync());
+      this.worker.unref();
+    }
+
+    this.timer = setInterval(() => this.flush(), this.interval);
+    this.timer.unref();
+
+    liveSinks.add(this);
+    installExitHook();
+  }
+
+  /**
+   * Appends one serialized record.
+   * @param {string} line
+   */
+  write(line) {
+    const bytes = Buffer.byteLength(line);
+
+    if (this.offset + bytes > this.size) this.flush();
+
+    // Oversized record: bypass the buffer
+    if (bytes > this.size) {
+      this._emit(Buffer.from(line));
+      return true;
+    }
+
+    this.offset += this.buffer.write(line, this.offset);
+    return true;
+  }
+
+  /**
+   * Hands the buffered bytes to the destination (asynchronously when a
+   * worker or stream is used). The reusable buffer is free again after.
+   */
+  flush() {
+    if (this.offset === 0) return;
+    const chunk = Buffer.allocUnsafe(this.offset);
+    this.buffer.copy(chunk, 0, 0, this.offset);
+    this.offset = 0;
+    this._emit(chunk);
+  }
+
+  /**
+   * Flushes everything and waits until it has reached the destination.
+   * Used on process exit and server shutdown. A worker sink is stopped and
+   * any batches it has not written yet are written here, in order; later
+   * records are written synchronously. A stream without an fd can't be
+   * waited on: the rest is queued behind its earlier writes (see close()).
+   */
+  flushSync() {
+    if (this.worker) {
+      Atomics.store(this.state, CLOSING, 1);
+      while (Atomics.load(this.state, BUSY) === 1) {
+        Atomics.wait(this.state, BUSY, 1, 50);
+      }
+      this._prune();
+      for (const chunk of this.inflight) this._writeFd(chunk);
+      this.inflight = [];
+      this.worker.terminate();
+      this.worker = null;
+    }
+    if (this.offset === 0) return;
+
+    const chunk = this.buffer.subarray(0, this.offset);
+    this.offset = 0;
+    if (this.fd !== null) {
+      this._writeFd(chunk);
+    } else {
+      this.target.write(Buffer.from(chunk));
+    }
+  }
+
+  /**
+   * Flushes and stops the timer/worker. A stream target is ended, so its
+   * queued writes drain before it finishes.
+   */
+  close() {
+    this.flushSync();
+    clearInterval(this.timer);
+    liveSinks.delete(this);
+    if (this.fd === null && typeof this.target.end === "function") {
+      this.target.end();
+    }
+  }
+
+  _emit(chunk) {
+    if (this.worker) {
+      this._prune();
+      this.inflight.push(chunk);
+      this.worker.postMessage(chunk);
+    } else if (this.fd !== null) {
+      this._writeFd(chunk);
+    } else {
+      this.target.write(chunk);
+    }
+  }
+
+  // Drops batches the worker has acknowledged
+  _prune() {
+    const done = Atomics.load(this.state, DONE);
+    if (done > this.acked) {
+      this.inflight.splice(0, done - this.acked);
+      this.acked = done;
+    }
+  }
+
+  _writeFd(chunk) {
+    try {
+      let off = 0;
+      while (off < chunk.length) off += fs.writeSync(this.fd, chunk, off);
+    } catch {}
+  }
+}
+
+/**
+ * Wraps a destination in a buffered sink.
+ * @param {NodeJS.WritableStream | { fd: number }} target
+ * @param {BufferOptions | boolean} options
+ * @returns {BufferedSink}
+ */
+export function createBufferedSink(target, options) {
+  return new BufferedSink(target, options === true ? {} : options);
+}
+
+export default createBufferedSink;
@@ -1,5 +1,6 @@
 import os from "os";
 import { color } from "../helpers/colors.js";
+import { createBufferedSink } from "./log-sink.js";
 
 const LOG_LEVELS = {
   trace: 10,
@@ -8,6 +9,7 @@ const LOG_LEVELS = {
   warn: 40,
   error: 50,
   fatal: 60,
+  silent: Infinity,
 };
 
 const LEVEL_NAMES = {
@@ -19,36 +21,71 @@ const LEVEL_NAMES = {
   60: "FATAL",
 };
 
+/**
+ * Serializes bindings into a JSON fragment (`,"k":v,...`) that is spliced
+ * into every line, so bindings are stringified once per logger.
+ * @param {Object} bindings
+ * @returns {string}
+ */
+function serializeBindings(bindings) {
+  let out = "";
+  for (const key of Object.keys(bindings)) {
+    const value = JSON.stringify(bindings[key]);
+    if (value !== undefined) out += `,${JSON.stringify(key)}:${value}`;
+  }
+  return out;
+}
+
 /**
  * High-performance structured JSON logger (Fastify/Pino style).
  */
 export class Logger {
   constructor(options = {}) {
-    this.level = LOG_LEVELS[options.level || "info"] || 30;
+    this.level =
+      typeof options.level === "number"
+        ? options.level
+        : LOG_LEVELS[options.level || "info"] || 30;
     this.prettyPrint = options.prettyPrint || false;
     this.lifecycle = options.lifecycle || false;
     this.stream = options.stream || process.stdout;
     this.bindings = options.bindings || {};
 
+    // Buffered destination: batch writes instead of one write per record
+    if (options.buffer) {
+      this.stream = createBufferedSink(this.stream, options.buffer);
+    }
+
     if (!this.bindings.pid) this.bindings.pid = process.pid;
     if (!this.bindings.hostname) this.bindings.hostname = os.hostname();
+
+    this._prefix = options._prefix ?? serializeBindings(this.bindings);
   }
 
   /**
    * Creates a sub-logger with scoped bindings (e.g. reqId).
+   * A silent logger can never write, so it is its own child.
    */
   child(bindings) {
+    if (this.level === Infinity) return this;
+    // Prefix from the merged bindings: a rebound key appears once
+    const merged = { ...this.bindings, ...bindings };
     return new Logger({
-      level: Object.keys(LOG_LEVELS).find(
-        (key) => LOG_LEVELS[key] === this.level,
-      ),
+      level: this.level,
       prettyPrint: this.prettyPrint,
       lifecycle: this.lifecycle,
       stream: this.stream,
-      bindings: { ...this.bindings, ...bindings },
+      bindings: merged,
+      _prefix: serializeBindings(merged),
     });
   }
 
+  /**
+   * Synchronously flushes a buffered destination (no-op otherwise).
+   */
+  flush() {
+    if (typeof this.stream.flushSync === "function") this.stream.flushSync();
+  }
+
   trace(obj, msg, c) {
     this._log(10, obj, msg, c);
   }
@@ -71,6 +108,14 @@ export class Logger {
   _log(level, obj, msg, c) {
     if (level < this.level) return;
 
+    if (!this.prettyPrint) {
+      const line = this._serialize(level, obj, msg, c);
+      if (line !== null) {
+        this.stream.write(line);
+        return;
+      }
+    }
+
     const base = {
       level,
       time: Date.now(),
@@ -114,6 +159,46 @@ export class Logger {
     }
   }
 
+  /**
+   * Builds a JSON line by string concatenation: the level/time header,
+   * the pre-serialized bindings, then the record fields.
+   * Returns null for shapes that need the generic object path, including
+   * records that rebind a binding key (the record's value wins there).
+   */
+  _serialize(level, obj, msg, c) {
+    let line = `{"level":${level},"time":${Date.now()}${this._prefix}`;
+    let customColor;
+
+    if (obj instanceof Error) {
+      line += `,"err":${JSON.stringify({
+        type: obj.name || "Error",
+        message: obj.message,
+        stack: obj.stack,
+      })},"msg":${JSON.stringify(typeof msg === "string" ? msg : obj.message)}`;
+      customColor = c;
+    } else if (typeof obj === "string") {
+      line += `,"msg":${JSON.stringify(obj)}`;
+      customColor = msg;
+    } else if (typeof obj === "object" && obj !== null) {
+      for (const key in obj) {
+        if (Object.hasOwn(this.bindings, key)) return null;
+      }
+      const fields = JSON.stringify(obj);
+      if (fields === undefined || fields.charCodeAt(0) !== 123) return null;
+      if (fields.length > 2) line += "," + fields.slice(1, -1);
+      if (typeof msg === "string") line += `,"msg":${JSON.stringify(msg)}`;
+      customColor = c;
+    } else {
+      line += `,"msg":${JSON.stringify(String(obj))}`;
+      customColor = msg;
+    }
+
+    if (typeof customColor === "string" && customColor) {
+      line += `,"color":${JSON.stringify(customColor)}`;
+    }
+    return line + "}\n";
+  }
+
   _printPretty(log) {
     const time = new Date(log.time).toLocaleTimeString();
     const lvlName = LEVEL_NAMES[log.level] || "INFO";
@@ -0,0 +1,97 @@
+/**
+ * Linear route matching and the linear/trie choice.
+ *
+ * Parameterless routes never get here: they are answered from the static
+ * Map first. What remains is a regex scan (cheap for a few routes, O(n))
+ * or the trie (a fixed cost per segment, flat in the route count). Which
+ * one wins depends on how many param routes the app has and what they
+ * look like; tests/bench/micro.js measures the crossover that the default
+ * threshold comes from, and "auto" measures it on the app's own routes.
+ */
+
+/**
+ * First route whose regex matches (static routes are skipped: the static
+ * Map always answers them first)
+ * @param {import("../../vibe.js").VibeRoute[]} routes
+ * @param {string} method
+ * @param {string} url - Pathname
+ * @returns {{ route: import("../../vibe.js").VibeRoute, params: Record<string, string> } | null}
+ */
+export function linearMatch(routes, method, url) {
+  for (let i = 0, len = routes.length; i < len; i++) {
+    const route = routes[i];
+    if (route.method !== method || route.isStatic) continue;
+    const result = route.pathRegex.exec(url);
+    if (result) {
+      return { route, params: result.groups || {} };
+    }
+  }
+  return null;
+}
+
+/**
+ * Routes that reach the linear / trie matcher
+ * @param {import("../../vibe.js").VibeRoute[]} routes
+ */
+export function countDynamic(routes) {
+  let n = 0;
+  for (let i = 0; i < routes.length; i++) if (!routes[i].isStatic) n++;
+  return n;
+}
+
+// Time per calibration round and matcher (ms)
+const ROUND_MS = 1;
+const ROUNDS = 3;
+
+// Mean ms per match over `samples`, for at least `budget` ms
+function timeMatches(match, samples, budget) {
+  let n = 0;
+  const start = performance.now();
+  let elapsed = 0;
+  do {
+    for (let i = 0; i < samples.length; i += 2) {
+      match(samples[i], samples[i + 1]);
+    }
+    n += samples.length / 2;
+    elapsed = performance.now() - start;
+  } while (elapsed < budget);
+  return elapsed / n;
+}
+
+/**
+ * Time both matchers on the app's own routes (one request per param
+ * route, plus a miss per method) and report whether the trie is faster.
+ * Takes a few milliseconds; used by `trieThreshold: "auto"` at listen().
+ * @param {import("../../vibe.js").VibeRoute[]} routes
+ * @param {import("./trie.js").RouteTrie} trie
+ * @returns {boolean}
+ */
+export function trieIsFaster(routes, trie) {
+  // Flat [method, path, method, path, ...]
+  const samples = [];
+  const methods = new Set();
+  for (const route of routes) {
+    if (route.isStatic) continue;
+    methods.add(route.method);
+    samples.push(
+      route.method,
+      route.path.replace(/:[^/]+/g, "1").replace(/\*/g, "x"),
+    );
+  }
+  if (samples.length === 0) return false;
+  for (const method of methods) samples.push(method, "/__vibe/miss/1");
+
+  const linear = (method, url) => linearMatch(routes, method, url);
+  const tree = (method, url) => trie.match(method, url);
+  // First round warms both up; then the best of the rest counts
+  let linearMs = Infinity;
+  let trieMs = Infinity;
+  for (let round = 0; round <= ROUNDS; round++) {
+    const l = timeMatches(linear, samples, ROUND_MS);
+    const t = timeMatches(tree, samples, ROUND_MS);
+    if (round === 0) continue;
+    linearMs = Math.min(linearMs, l);
+    trieMs = Math.min(trieMs, t);
+  }
+  return trieMs < linearMs;
+}
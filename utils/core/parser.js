@@ -1,8 +1,9 @@
 import busboy from "busboy";
-import fs from "fs";
-import crypto from "crypto";
 import path from "path";
 import { EventEmitter } from "events";
+import { diskSink, storeUpload } from "./upload-sinks.js";
+import { JsonSelectParser, selectJson } from "./json-select.js";
+import { isHttp2 } from "./protocols.js";
 
 /**
  * Default streaming threshold (1MB)
@@ -20,9 +21,16 @@ const DEFAULT_STREAM_THRESHOLD = 1024 * 1024;
  * @param {import("../vibe.js").VibeResponse} res - Response object
  * @param {import("../vibe.js").MediaOptions} [media={}] - Route-specific file config
  * @param {import("../vibe.js").VibeConfig} [options={}] - Global framework config
+ * @param {((body: any) => string | null) | null} [validate] - Route body validator; makes malformed JSON a 400
  * @returns {Promise<void>} Resolves when parsing completes
  */
-export default function bodyParser(req, res, media = {}, options = {}) {
+export default function bodyParser(
+  req,
+  res,
+  media = {},
+  options = {},
+  validate = null,
+) {
   return new Promise((resolve, reject) => {
     const contentType = req.headers["content-type"];
     if (!contentType) return resolve();
@@ -52,7 +60,7 @@ export default function bodyParser(req, res, media = {}, options = {}) {
 
     /* ---------- JSON ---------- */
     if (contentType.includes("application/json")) {
-      parseJson(req, res, media, options, resolve, reject);
+      parseJson(req, res, media, options, validate, resolve);
       return;
     }
 
@@ -95,11 +103,13 @@ function parseMultipart(req, res, media, options, resolve, reject) {
     }
   };
 
+  const maxSize = media.maxSize || 10 * 1024 * 1024;
+
   try {
     bb = busboy({
       headers: req.headers,
       limits: {
-        fileSize: media.maxSize || 10 * 1024 * 1024,
+        fileSize: maxSize,
       },
     });
   } catch (err) {
@@ -111,8 +121,8 @@ function parseMultipart(req, res, media, options, resolve, reject) {
     req.body[name] = value;
   });
 
-  bb.on("file", (name, file, info) => {
-    const { filename, mimeType } = info;
+  bb.on("file", (name, file, part) => {
+    const { filename, mimeType } = part;
     if (!filename) return file.resume();
 
     // File type validation - support wildcards like "image/*"
@@ -133,101 +143,49 @@ function parseMultipart(req, res, media, options, resolve, reject) {
       }
     }
 
-    // STREAMING MODE: Emit file event, let handler deal with it
+    const info = { field: name, filename, mimeType };
+    const store = {
+      sink: media.sink || null,
+      hash: media.hash || null,
+      limiter: media.limiter || null,
+      maxSize,
+    };
+
+    // STREAMING MODE: Emit file event, let handler deal with it.
+    // info.save() stores the file like buffered mode would (default sink,
+    // hashing, concurrency limit) and resolves with its UploadedFile.
     if (streaming) {
-      req.emit("file", name, file, { filename, mimeType });
+      info.save = (sink) =>
+        storeUpload(file, info, {
+          ...store,
+          sink: sink || store.sink || defaultSink(media, options),
+        });
+      req.emit("file", name, file, info);
       return;
     }
 
-    // BUFFERING MODE: Write to disk
-    pendingWrites++;
-
-    const parent = media.public ? options.publicFolder || "" : "";
-    const dest = path.resolve(
-      path.join(parent, media.dest || (media.public ? "uploads" : "private")),
-    );
-
-    // Prevent path traversal
-    if (
-      media.public &&
-      !dest.startsWith(path.resolve(options.publicFolder || ""))
-    ) {
-      console.warn("Attempted upload outside public folder, skipping");
-      pendingWrites--;
-      checkComplete();
-      return file.resume();
-    }
-
-    try {
-      if (!fs.existsSync(dest)) fs.mkdirSync(dest, { recursive: true });
-    } catch (err) {
-      console.error("Failed to create upload folder:", err);
-      pendingWrites--;
-      checkComplete();
-      return file.resume();
+    // BUFFERING MODE: Pipe into the route's sink (disk by default)
+    if (!store.sink) {
+      store.sink = defaultSink(media, options);
+      // Prevent path traversal
+      if (!store.sink) {
+        console.warn("Attempted upload outside public folder, skipping");
+        return file.resume();
+      }
     }
 
-    const ext =
-      path.extname(filename) ||
-      (mimeType?.includes("/") ? "." + mimeType.split("/")[1] : "");
-
-    const safeName = `${path.basename(filename, ext)}-${crypto
-      .randomBytes(3)
-      .toString("hex")}${ext}`;
-    const filePath = path.join(dest, safeName);
-
-    const writeStream = fs.createWriteStream(filePath);
-    let size = 0;
-    let truncated = false;
-
-    file.on("data", (d) => (size += d.length));
-
-    // Handle file size limit exceeded
-    file.on("limit", () => {
-      truncated = true;
-      const err = new Error(
-        `File '${filename}' exceeds max size of ${media.maxSize || 10 * 1024 * 1024} bytes`,
-      );
-      file.unpipe(writeStream);
-      writeStream.end();
-      file.resume();
-      // Clean up partial file and reject immediately
-      fs.unlink(filePath, () => {
+    pendingWrites++;
+    storeUpload(file, info, store).then(
+      (record) => {
+        req.files.push(record);
         pendingWrites--;
-      });
-      // Reject NOW - don't wait for busboy to finish
-      rejectNow(err);
-    });
-
-    file.on("error", (err) => {
-      console.error("File stream error:", err);
-      writeStream.end();
-      pendingWrites--;
-      checkComplete();
-    });
-
-    writeStream.on("error", (err) => {
-      console.error("Write stream error:", err);
-      file.resume();
-      pendingWrites--;
-      checkComplete();
-    });
-
-    writeStream.on("finish", () => {
-      if (!truncated) {
-        req.files.push({
-          filename: safeName,
-          originalName: filename,
-          type: mimeType,
-          filePath,
-          size,
-        });
-      }
-      pendingWrites--;
-      checkComplete();
-    });
-
-    file.pipe(writeStream);
+        checkComplete();
+      },
+      (err) => {
+        pendingWrites--;
+        rejectNow(err);
+      },
+    );
   });
 
   bb.on("error", (err) => {
@@ -244,57 +202,167 @@ function parseMultipart(req, res, media, options, resolve, reject) {
   req.pipe(bb);
 }
 
+/**
+ * Disk sink for a route's dest folder, or null if it escapes the public
+ * folder. Directory creation is cached by the sink module, so this is
+ * cheap to call per file.
+ */
+function defaultSink(media, options) {
+  const parent = media.public ? options.publicFolder || "" : "";
+  const dir = path.resolve(
+    path.join(parent, media.dest || (media.public ? "uploads" : "private")),
+  );
+  if (
+    media.public &&
+    !dir.startsWith(path.resolve(options.publicFolder || ""))
+  ) {
+    return null;
+  }
+  return diskSink({ dir });
+}
+
+/**
+ * Answers 413 and closes the connection (the rest of the body is never read)
+ */
+function payloadTooLarge(res, limit) {
+  if (res.headersSent) return;
+  // HTTP/2 has no connection header; ending the stream is enough there
+  res.writeHead(
+    413,
+    isHttp2(res.req)
+      ? { "content-type": "application/json" }
+      : { "content-type": "application/json", connection: "close" },
+  );
+  res.end(
+    JSON.stringify({
+      error: "Payload Too Large",
+      message: `Body exceeds ${limit} bytes`,
+    }),
+  );
+}
+
 /**
  * Parse JSON body with streaming support for large payloads
  */
-function parseJson(req, res, media, options, resolve, reject) {
+function parseJson(req, res, media, options, validate, resolve) {
   const limit = options.maxJsonSize || 1e6;
   const streamThreshold = media?.streamThreshold || DEFAULT_STREAM_THRESHOLD;
   const contentLength = parseInt(req.headers["content-length"] || "0", 10);
 
-  // STREAMING MODE: For very large JSON, let handler process incrementally
-  if (media?.streaming && contentLength > streamThreshold) {
+  // STREAMING MODE: For very large (or chunked, size unknown) JSON,
+  // let the handler process it incrementally with parseJsonStream()
+  if (
+    media?.streaming &&
+    (contentLength > streamThreshold || !req.headers["content-length"])
+  ) {
     req.body = null; // Signal that body should be consumed via stream
     req.emit("jsonStream", req);
     resolve();
     return;
   }
 
-  // BUFFERING MODE: Collect and parse
-  let body = "";
+  // Declared too large: refuse before reading a single byte
+  if (contentLength > limit) {
+    payloadTooLarge(res, limit);
+    resolve();
+    return;
+  }
+
+  // BUFFERING MODE: Collect raw chunks, decode once at the end
+  let chunks = [];
+  let size = 0;
+
+  // Every exit path settles the promise exactly once and drops the
+  // listeners, so aborted or oversized requests leave nothing behind
+  const settle = () => {
+    req.off("data", onData);
+    req.off("end", onEnd);
+    req.off("close", onClose);
+    chunks = null;
+    resolve();
+  };
 
-  req.on("data", (chunk) => {
-    body += chunk;
-    if (body.length > limit) {
-      console.warn("JSON payload too large, destroying connection");
-      req.destroy();
+  const onData = (chunk) => {
+    size += chunk.length; // bytes, not UTF-16 units
+    if (size > limit) {
+      // Chunked / lying Content-Length: stop buffering, answer 413
+      req.pause();
+      payloadTooLarge(res, limit);
+      settle();
+      return;
     }
-  });
+    chunks.push(chunk);
+  };
 
-  req.on("end", () => {
+  const onEnd = () => {
+    const text =
+      chunks.length === 1
+        ? chunks[0].toString()
+        : Buffer.concat(chunks, size).toString();
     try {
-      req.body = JSON.parse(body || "{}");
+      req.body = JSON.parse(text || "{}");
     } catch {
+      // Routes with a body schema reject malformed JSON outright
+      if (validate) {
+        res.writeHead(400, { "content-type": "application/json" });
+        res.end(
+          JSON.stringify({
+            error: "Bad Request",
+            message: "Body is not valid JSON",
+          }),
+        );
+      }
       req.body = {};
     }
-    resolve();
-  });
+    settle();
+  };
+
+  // Client went away mid-body: nothing to answer, just release the request
+  const onClose = () => {
+    if (chunks !== null) settle();
+  };
+
+  req.on("data", onData);
+  req.on("end", onEnd);
+  req.on("close", onClose);
 }
 
 /**
- * Stream JSON parser helper
- * Use with streaming mode to parse large JSON incrementally
+ * Parse a JSON body incrementally, as its bytes arrive.
+ *
+ * Without a path, resolves with the whole document. With a path such as
+ * `"$.items[*]"`, returns an async iterator over the matched values, so
+ * memory stays bounded by the largest single value:
+ *
+ *   for await (const item of parseJsonStream(req, "$.items[*]")) { ... }
  *
  * @param {NodeJS.ReadableStream} stream
- * @returns {Promise<any>}
+ * @param {string} [path] - Values to yield (`$`, `.key`, `[*]`, `[0]`, `['key']`)
+ * @param {{ maxItemSize?: number }} [options] - maxItemSize caps one value, in bytes
+ * @returns {Promise<any> | AsyncGenerator<any>}
  */
-export async function parseJsonStream(stream) {
+export function parseJsonStream(stream, path, options) {
+  if (path !== undefined) return selectJson(stream, path, options);
+
   return new Promise((resolve, reject) => {
-    let body = "";
-    stream.on("data", (chunk) => (body += chunk));
+    let value;
+    let failed = false;
+    const parser = new JsonSelectParser("$", (v) => (value = v), options);
+    stream.on("data", (chunk) => {
+      if (failed) return;
+      try {
+        parser.write(typeof chunk === "string" ? Buffer.from(chunk) : chunk);
+      } catch (err) {
+        failed = true;
+        stream.destroy();
+        reject(err);
+      }
+    });
     stream.on("end", () => {
+      if (failed) return;
       try {
-        resolve(JSON.parse(body));
+        parser.end();
+        resolve(value);
       } catch (err) {
         reject(err);
       }
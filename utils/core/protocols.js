@@ -0,0 +1,63 @@
+import http from "http";
+import https from "https";
+import http2 from "http2";
+
+/**
+ * Server protocols: HTTP/1.1 (default), HTTPS, and HTTP/2 (TLS with an
+ * HTTP/1.1 fallback for clients that don't negotiate h2, or cleartext h2c
+ * without `https`).
+ *
+ * HTTP/2 requests use the compatibility API (Http2ServerRequest /
+ * Http2ServerResponse), so handlers, interceptors and the response helpers
+ * see the same req/res interface on every protocol. Everything Vibe
+ * installs on a prototype goes on each class listed here.
+ */
+
+/** Request classes Vibe's accessors (query, id, log, ip, decorators) go on */
+export const REQUEST_CLASSES = [
+  http.IncomingMessage,
+  http2.Http2ServerRequest,
+];
+
+/** Response classes the response helpers go on */
+export const RESPONSE_CLASSES = [
+  http.ServerResponse,
+  http2.Http2ServerResponse,
+];
+
+// Http2ServerResponse has no `destroyed`; the streaming code checks it
+if (!("destroyed" in http2.Http2ServerResponse.prototype)) {
+  Object.defineProperty(http2.Http2ServerResponse.prototype, "destroyed", {
+    get() {
+      return this.stream.destroyed;
+    },
+    configurable: true,
+  });
+}
+
+/**
+ * @param {{ https?: Object | null, http2?: boolean | Object }} options
+ * @param {Function} listener
+ * @returns {http.Server | https.Server | http2.Http2Server | http2.Http2SecureServer}
+ */
+export function createServer(options, listener) {
+  const tls = options.https || null;
+  if (options.http2) {
+    const settings = options.http2 === true ? {} : options.http2;
+    return tls
+      ? http2.createSecureServer(
+          { allowHTTP1: true, ...settings, ...tls },
+          listener,
+        )
+      : http2.createServer(settings, listener);
+  }
+  return tls ? https.createServer(tls, listener) : http.createServer(listener);
+}
+
+/**
+ * HTTP/2 forbids connection-specific headers (`connection: close` etc.)
+ * @param {{ httpVersionMajor: number } | undefined} req
+ */
+export function isHttp2(req) {
+  return req?.httpVersionMajor === 2;
+}
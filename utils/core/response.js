@@ -1,11 +1,11 @@
 import fs from "fs";
 import path from "path";
-import { mimeTypes } from "../helpers/mime.js";
+import { getStaticFiles } from "./static.js";
 
 // Pre-allocated headers (avoid per-request object creation)
 const JSON_CT = { "content-type": "application/json" };
 const TEXT_CT = { "content-type": "text/plain" };
-const HTML_CT = { "Content-Type": "text/html" };
+const HTML_CT = { "content-type": "text/html" };
 
 // Pre-allocated response templates (stringified once at startup)
 const RESPONSES = {
@@ -79,48 +79,26 @@ const vibeResponseMethods = {
     const publicFolder = this._vibeOptions.publicFolder;
     if (!publicFolder) throw new Error("No Public folder set");
 
-    const resolvedPath = path.resolve(publicFolder, filename);
-
-    if (!resolvedPath.startsWith(path.resolve(publicFolder))) {
-      this.statusCode = 403;
-      return this.end("Forbidden");
-    }
-
-    if (!fs.existsSync(resolvedPath)) {
-      this.statusCode = 404;
-      return this.end("Not Found");
-    }
-
-    this.writeHead(200, { "Content-Type": "text/html" });
-    fs.createReadStream(resolvedPath).pipe(this);
+    getStaticFiles(this._vibeOptions).serveFile(
+      this.req,
+      this,
+      filename,
+      HTML_CT,
+    );
   },
 
   /**
    * Safely send any static file from the public folder.
+   * Served from the in-memory manifest (no disk stat per request), with
+   * ETag/Last-Modified, 304 and Range support. A file not in the manifest
+   * yet (e.g. written by this handler) is looked up on disk once.
    * @param {string} filePath
    */
   sendFile(filePath) {
     const publicFolder = this._vibeOptions.publicFolder;
     if (!publicFolder) throw new Error("No Public folder set");
 
-    const resolvedPath = path.resolve(publicFolder, filePath);
-
-    if (!resolvedPath.startsWith(path.resolve(publicFolder))) {
-      this.statusCode = 403;
-      return this.end("Forbidden");
-    }
-
-    if (!fs.existsSync(resolvedPath)) {
-      this.statusCode = 404;
-      return this.end("Not Found");
-    }
-
-    const ext = path.extname(resolvedPath);
-    this.writeHead(200, {
-      "Content-Type": mimeTypes[ext] || "application/octet-stream",
-    });
-
-    fs.createReadStream(resolvedPath).pipe(this);
+    getStaticFiles(this._vibeOptions).serveFile(this.req, this, filePath);
   },
 
   /**
@@ -133,23 +111,23 @@ const vibeResponseMethods = {
   sendAbsoluteFile(absolutePath, opts = {}) {
     const resolvedPath = path.resolve(absolutePath);
 
-    if (!fs.existsSync(resolvedPath)) {
-      this.statusCode = 404;
-      return this.end("Not Found");
-    }
-
-    const ext = path.extname(resolvedPath);
-    const filename = opts.filename || path.basename(resolvedPath);
-    const headers = {
-      "Content-Type": mimeTypes[ext] || "application/octet-stream",
-    };
-
-    if (opts.download) {
-      headers["Content-Disposition"] = `attachment; filename="${filename}"`;
-    }
-
-    this.writeHead(200, headers);
-    fs.createReadStream(resolvedPath).pipe(this);
+    fs.stat(resolvedPath, (err, stat) => {
+      if (err || !stat.isFile()) {
+        this.statusCode = 404;
+        return this.end("Not Found");
+      }
+
+      const files = getStaticFiles(this._vibeOptions);
+      let headers;
+      if (opts.download) {
+        const filename = opts.filename || path.basename(resolvedPath);
+        headers = {
+          "content-disposition": `attachment; filename="${filename}"`,
+        };
+      }
+      const file = files.record(resolvedPath, stat, null, false);
+      files.send(this.req, this, file, headers);
+    });
   },
 
   /**
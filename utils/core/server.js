@@ -1,13 +1,29 @@
-import http from "http";
+import cluster from "cluster";
 import crypto from "crypto";
-import { error, getNetworkIP, handleError, isSendAble } from "./handler.js";
+import { error, getNetworkIP, handleError } from "./handler.js";
 import bodyParser from "./parser.js";
 import { installResponseMethods, initResponse } from "./response.js";
 import { parseQuery } from "../native.js";
-
-// Pre-allocated headers (frozen for V8 optimization)
-const JSON_HEADERS = { "content-type": "application/json" };
-const TEXT_HEADERS = { "content-type": "text/plain" };
+import { isStreamable, streamJson } from "./stream-json.js";
+import { countDynamic, linearMatch, trieIsFaster } from "./matching.js";
+import {
+  INTERCEPT,
+  BODY,
+  VALIDATE,
+  HANDLER,
+  SERIALIZE,
+} from "./tracing.js";
+import {
+  REQUEST_CLASSES,
+  RESPONSE_CLASSES,
+  createServer,
+  isHttp2,
+} from "./protocols.js";
+
+// Pre-allocated header blocks, shared by every response on every protocol
+// (frozen: writeHead only reads them)
+const JSON_HEADERS = Object.freeze({ "content-type": "application/json" });
+const TEXT_HEADERS = Object.freeze({ "content-type": "text/plain" });
 
 // Pre-allocated 404 response
 const NOT_FOUND_BODY = "Not Found";
@@ -15,283 +31,604 @@ const NOT_FOUND_BODY = "Not Found";
 // Shared frozen empty params (avoids per-request object allocation)
 const EMPTY_PARAMS = Object.freeze(Object.create(null));
 
+// Request IDs: random per-worker prefix + monotonic counter.
+// Only the counter is stored per request; the string is built on first read.
+const REQ_ID_PREFIX = crypto.randomBytes(4).toString("hex") + "-";
+let reqSeq = 0;
+
 /**
- * Creates and starts the Vibe HTTP server.
- * HEAVILY OPTIMIZED for performance
+ * The part of a request an offloaded handler receives: plain data that
+ * can be structured-cloned onto a worker thread.
  */
-async function server(options, port, host, callback) {
-  // Install response methods on prototype ONCE (zero per-request cost)
-  installResponseMethods(http.ServerResponse);
+function taskRequest(req) {
+  return {
+    method: req.method,
+    url: req.url,
+    params: req.params,
+    query: req.query,
+    headers: req.headers,
+    body: req.body,
+    ip: req.ip,
+    id: req.id,
+  };
+}
 
-  // Install lazy query getter on IncomingMessage prototype ONCE
-  if (!http.IncomingMessage.prototype._vibeQueryInstalled) {
-    Object.defineProperty(http.IncomingMessage.prototype, "query", {
+/**
+ * Lazy request accessors, installed once per request prototype
+ * @param {object} proto
+ */
+function installRequestAccessors(proto) {
+  // Lazy query getter (typed by the route's schema.querystring, if any)
+  if (!proto._vibeQueryInstalled) {
+    Object.defineProperty(proto, "query", {
       get() {
         if (this._parsedQuery !== undefined) return this._parsedQuery;
-        this._parsedQuery =
-          this._qIdx < 0 ? {} : parseQuery(this._rawUrl.slice(this._qIdx + 1));
+        const parse = this.route ? this.route.parseQuery : null;
+        const qs = this._qIdx < 0 ? "" : this._rawUrl.slice(this._qIdx + 1);
+        this._parsedQuery = parse ? parse(qs) : qs ? parseQuery(qs) : {};
         return this._parsedQuery;
       },
       configurable: true,
     });
-    http.IncomingMessage.prototype._vibeQueryInstalled = true;
+    proto._vibeQueryInstalled = true;
+  }
+
+  // Lazy req.id / req.log / req.ip accessors.
+  // Nothing is formatted or allocated unless a handler actually reads them.
+  if (!proto._vibeLogInstalled) {
+    Object.defineProperty(proto, "id", {
+      get() {
+        if (this._id === undefined && this._seq !== undefined) {
+          this._id = REQ_ID_PREFIX + this._seq.toString(36);
+        }
+        return this._id;
+      },
+      set(value) {
+        this._id = value;
+      },
+      configurable: true,
+    });
+    Object.defineProperty(proto, "log", {
+      get() {
+        if (this._log === undefined && this._vibeOptions !== undefined) {
+          this._log = this._vibeOptions.logger.child({ reqId: this.id });
+        }
+        return this._log;
+      },
+      set(value) {
+        this._log = value;
+      },
+      configurable: true,
+    });
+    // Client address, looked up on first read
+    Object.defineProperty(proto, "ip", {
+      get() {
+        if (this._ip === undefined) {
+          this._ip =
+            this.socket.remoteAddress || this.headers["x-forwarded-for"];
+        }
+        return this._ip;
+      },
+      set(value) {
+        this._ip = value;
+      },
+      configurable: true,
+    });
+    proto._vibeLogInstalled = true;
+  }
+}
+
+/**
+ * Creates and starts the Vibe HTTP server.
+ * HEAVILY OPTIMIZED for performance
+ */
+async function server(options, port, host, callback) {
+  // Install response methods and request accessors on every protocol's
+  // prototypes ONCE (zero per-request cost)
+  for (const Response of RESPONSE_CLASSES) installResponseMethods(Response);
+  for (const Request of REQUEST_CLASSES) {
+    installRequestAccessors(Request.prototype);
   }
 
   // Pre-compute everything we can
-  const useTrieMatching = options.routeCount > options.trieThreshold;
   const staticRoutes = options.staticRoutes || new Map();
   const interceptors = options.interceptors;
-  const hasInterceptors = interceptors && interceptors.length > 0;
-  const requestDecorators = options.requestDecorators;
-  const replyDecorators = options.replyDecorators;
-  const hasRequestDecorators =
-    requestDecorators && Object.keys(requestDecorators).length > 0;
-  const hasReplyDecorators =
-    replyDecorators && Object.keys(replyDecorators).length > 0;
   const trie = options.trie;
   const routes = options.routes;
+  // Only param routes reach the linear / trie matcher
+  const dynamicCount = countDynamic(routes);
+  const useTrieMatching =
+    options.trieThreshold === "auto"
+      ? trieIsFaster(routes, trie)
+      : dynamicCount > options.trieThreshold;
+  const logger = options.logger;
+  const lifecycle = !!(options.loggerConfig && options.loggerConfig.lifecycle);
+  const streamMinItems = options.streaming.minItems;
+  const streamChunkSize = options.streaming.chunkSize;
+  const admission = options.admission;
+  const admitting = admission !== null || routes.some((r) => r.admission);
+  const metrics = options.metrics;
+  const tracer = options.tracer;
+
+  // Route ids index the metrics counters
+  if (metrics !== null) metrics.bind(routes);
+
+  // Set by shutdown(): responses close their keep-alive connections
+  let draining = false;
+
+  // Opt-in: compile the trie into one generated matcher per method. Built
+  // here so the first request doesn't pay for it; the trie rebuilds it
+  // after a later insert
+  const compiledRouter = !!options.compiledRouter;
+  if (compiledRouter) trie.matchCompiled("GET", "/");
+
+  // Large arrays / async iterators / Readables: write incrementally
+  function sendStreamed(req, res, result, serialize) {
+    streamJson(
+      res,
+      result,
+      serialize ? serialize.item : undefined,
+      streamChunkSize,
+    ).catch((err) => {
+      if (res.headersSent) res.destroy(err);
+      else options.errorHandler(err, req, res);
+    });
+  }
 
-  // Pre-compute decorator entries
-  const requestDecoratorEntries = hasRequestDecorators
-    ? Object.entries(requestDecorators)
-    : null;
-  const replyDecoratorEntries = hasReplyDecorators
-    ? Object.entries(replyDecorators)
-    : null;
-
-  // Inline interceptor runner (avoid function call overhead)
-  async function runIntercept(intercept, req, res) {
-    if (!intercept) return true;
+  /**
+   * Answer a request the server has no capacity for
+   * @returns {false}
+   */
+  function shed(res, status, retryAfter) {
+    res.writeHead(status, {
+      "content-type": "application/json",
+      "retry-after": String(retryAfter),
+    });
+    res.end(
+      JSON.stringify({
+        error: status === 429 ? "Too Many Requests" : "Service Unavailable",
+        message: "Server is overloaded, retry later",
+      }),
+    );
+    return false;
+  }
 
-    if (Array.isArray(intercept)) {
-      for (let i = 0; i < intercept.length; i++) {
-        await intercept[i](req, res);
-        if (res.writableEnded) return false;
+  /**
+   * Load shedding, before the body is read or any route code runs.
+   * Checks the route's pool, then the route's or the app's adaptive limit.
+   * @returns {boolean} false when the request was shed (already answered)
+   */
+  function admit(route, res) {
+    const gate = route.admission;
+    if (gate === false) return true;
+    let controller = admission;
+
+    if (gate) {
+      const pool = gate.pool;
+      if (pool && pool.waitingCount >= gate.maxWaiting) {
+        // A caller arriving now would wait about as long as recent ones did
+        const wait = pool.waitTime ? pool.waitTime.percentile(90) : 0;
+        return shed(
+          res,
+          gate.status || 503,
+          gate.retryAfter || Math.max(1, Math.ceil(wait / 1000)),
+        );
       }
-    } else {
-      await intercept(req, res);
-      if (res.writableEnded) return false;
+      if (gate.controller) controller = gate.controller;
+    }
+    if (controller === null) return true;
+
+    const start = controller.acquire();
+    if (start < 0) {
+      return shed(
+        res,
+        gate?.status || controller.status,
+        gate?.retryAfter || controller.retryAfter,
+      );
     }
+    // Client aborts say nothing about server latency
+    res.once("close", () => controller.release(start, res.writableFinished));
     return true;
   }
 
-  // Linear route matching (inlined for speed)
-  function linearMatch(method, url) {
-    for (let i = 0, len = routes.length; i < len; i++) {
-      const route = routes[i];
-      if (route.method !== method) continue;
-      const result = route.pathRegex.exec(url);
-      if (result) {
-        return { route, params: result.groups || {} };
+  /**
+   * Send a handler's return value: objects and arrays as JSON, other
+   * values (strings, numbers, booleans) as text. The same rule applies
+   * whether the value was returned or resolved from a promise.
+   */
+  function respond(req, res, result, serialize) {
+    if (result === undefined || res.writableEnded) return;
+    if (typeof result === "object" && result !== null) {
+      if (result instanceof Error) {
+        return options.errorHandler(result, req, res);
       }
+      if (isStreamable(result, serialize, streamMinItems)) {
+        return sendStreamed(req, res, result, serialize);
+      }
+      res.writeHead(200, JSON_HEADERS);
+      res.end(serialize ? serialize(result) : JSON.stringify(result));
+    } else {
+      res.writeHead(200, TEXT_HEADERS);
+      res.end(String(result));
     }
-    return null;
   }
 
-  // Main request handler - ULTRA OPTIMIZED
-  function reqListener(req, res) {
-    req.id = crypto.randomUUID();
-    req.log = options.logger.child({ reqId: req.id });
+  /**
+   * Tracing: wrap a step so sampled requests time it into `phase`.
+   * Without a tracer the step is returned as is, so untraced apps compose
+   * exactly the same pipeline as before.
+   */
+  function timed(step, phase) {
+    if (tracer === null) return step;
+    return (req, res) => {
+      const trace = req._trace;
+      if (trace === null) return step(req, res);
+      const since = performance.now();
+      const r = step(req, res);
+      if (r && typeof r.then === "function") {
+        return r.then((ok) => {
+          tracer.phase(req, trace, phase, since);
+          return ok;
+        });
+      }
+      tracer.phase(req, trace, phase, since);
+      return r;
+    };
+  }
 
-    if (options.loggerConfig && options.loggerConfig.lifecycle) {
-      req.startTime = Date.now();
-      req.log.info({ type: "req" }, "Incoming request");
+  // Tracing: the handler finished at this point; time the response
+  function tracedRespond(req, res, trace, since, result, serialize) {
+    tracer.phase(req, trace, HANDLER, since);
+    const start = performance.now();
+    respond(req, res, result, serialize);
+    tracer.phase(req, trace, SERIALIZE, start);
+  }
 
-      res.on("finish", () => {
-        req.log.info(
-          {
-            type: "res",
-            statusCode: res.statusCode,
-            responseTimeMs: Date.now() - req.startTime,
-          },
-          "Request completed",
-        );
-      });
+  /**
+   * Last step of a route: run the handler (or send its prebuilt value)
+   * @param {import("../../vibe.js").VibeRoute} route
+   */
+  function terminal(route) {
+    const { handler, serialize } = route;
+
+    // Prebuilt at registration: bytes, length, type and ETag are ready
+    if (route._handlerType === 2) {
+      const body = route._prebuiltBody;
+      const headers = route._prebuiltHeaders;
+      const etag = route._etag;
+      const notModified = Object.freeze({ etag });
+      return timed((req, res) => {
+        const inm = req.headers["if-none-match"];
+        if (
+          inm !== undefined &&
+          (inm === etag || inm === "*" || inm.indexOf(etag) !== -1)
+        ) {
+          res.writeHead(304, notModified);
+          res.end();
+          return;
+        }
+        res.writeHead(200, headers);
+        res.end(body);
+      }, SERIALIZE);
     }
 
-    // Fast pathname extraction
-    const url = req.url;
-    const qIdx = url.indexOf("?");
-    const pathname = qIdx < 0 ? url : url.slice(0, qIdx);
-
-    // Store raw values for lazy query parsing (prototype getter handles the rest)
-    req._qIdx = qIdx;
-    req._rawUrl = url;
-    req._parsedQuery = undefined;
-
-    req.url = pathname;
+    if (route.offload) {
+      const task = route.offload;
+      return (req, res) => {
+        const trace = tracer === null ? null : req._trace;
+        const since = trace === null ? 0 : performance.now();
+        return options.tasks
+          .run(task, [taskRequest(req)])
+          .then((val) =>
+            trace === null
+              ? respond(req, res, val, serialize)
+              : tracedRespond(req, res, trace, since, val, serialize),
+          );
+      };
+    }
 
-    // Stamp response with options ref (ONLY per-request cost for response methods)
-    res._vibeOptions = options;
+    if (typeof handler !== "function") {
+      return () => {
+        throw new Error("Invalid handler type");
+      };
+    }
 
-    // Apply decorators (only if exist)
-    if (requestDecoratorEntries) {
-      for (let i = 0; i < requestDecoratorEntries.length; i++) {
-        const e = requestDecoratorEntries[i];
-        req[e[0]] = typeof e[1] === "function" ? e[1]() : e[1];
+    const run = (req, res) => {
+      const result = handler(req, res);
+      if (
+        typeof result === "object" &&
+        result !== null &&
+        typeof result.then === "function"
+      ) {
+        return result.then((val) => respond(req, res, val, serialize));
       }
-    }
-    if (replyDecoratorEntries) {
-      for (let i = 0; i < replyDecoratorEntries.length; i++) {
-        const e = replyDecoratorEntries[i];
-        res[e[0]] = typeof e[1] === "function" ? e[1]() : e[1];
+      respond(req, res, result, serialize);
+    };
+    if (tracer === null) return run;
+
+    // Traced: handler and serialization are timed separately
+    return (req, res) => {
+      const trace = req._trace;
+      if (trace === null) return run(req, res);
+      const since = performance.now();
+      const result = handler(req, res);
+      if (
+        typeof result === "object" &&
+        result !== null &&
+        typeof result.then === "function"
+      ) {
+        return result.then((val) =>
+          tracedRespond(req, res, trace, since, val, serialize),
+        );
       }
-    }
-
-    // SYNC FAST PATH — avoid async/await for simple GET routes
-    if (!hasInterceptors && req.method === "GET") {
-      const routeKey = "GET" + pathname;
-      const staticMatch = staticRoutes.get(routeKey);
-
-      if (staticMatch && !staticMatch.intercept) {
-        req.params = EMPTY_PARAMS;
-
-        // Pre-built response (string/object/number/boolean registered at route time)
-        if (staticMatch._handlerType === 2) {
-          const pb = staticMatch._prebuilt;
-          // Check if it looks like JSON (starts with { or [)
-          const c = pb.charCodeAt(0);
-          if (c === 123 || c === 91) {
-            res.writeHead(200, JSON_HEADERS);
-          } else {
-            res.writeHead(200, TEXT_HEADERS);
-          }
-          res.end(pb);
-          return;
-        }
+      tracedRespond(req, res, trace, since, result, serialize);
+    };
+  }
 
-        // Function handler
-        const handler = staticMatch.handler;
-        const serialize = staticMatch.serialize;
-
-        try {
-          const result = handler(req, res);
-          if (result !== undefined && !res.writableEnded) {
-            if (result && typeof result.then === "function") {
-              result
-                .then((val) => {
-                  if (val instanceof Error) {
-                    return options.errorHandler(val, req, res);
-                  }
-                  if (val !== undefined && !res.writableEnded) {
-                    res.writeHead(200, JSON_HEADERS);
-                    res.end(serialize ? serialize(val) : JSON.stringify(val));
-                  }
-                })
-                .catch((err) => options.errorHandler(err, req, res));
-            } else if (typeof result === "object" && result !== null) {
-              if (result instanceof Error) {
-                return options.errorHandler(result, req, res);
-              }
-              res.writeHead(200, JSON_HEADERS);
-              res.end(serialize ? serialize(result) : JSON.stringify(result));
-            } else {
-              res.writeHead(200, TEXT_HEADERS);
-              res.end(String(result));
-            }
-          }
-        } catch (err) {
-          options.errorHandler(err, req, res);
-        }
-        return;
+  /**
+   * Put `step` in front of `next`. The pair stays synchronous unless the
+   * step returns a promise. A step stops the chain by ending the response
+   * or returning (or resolving to) false.
+   */
+  function link(step, next) {
+    return (req, res) => {
+      const r = step(req, res);
+      if (r && typeof r.then === "function") {
+        return r.then((ok) =>
+          ok === false || res.writableEnded ? undefined : next(req, res),
+        );
       }
-    }
+      if (r === false || res.writableEnded) return;
+      return next(req, res);
+    };
+  }
 
-    // Fallback to full async handler for complex routes
-    handleRequest(req, res, pathname);
+  /**
+   * Global interceptors that apply to a route (all but the ones it skips)
+   * @param {import("../../vibe.js").VibeRoute | null} route
+   * @returns {Function[]}
+   */
+  function globalsFor(route) {
+    const skip = route ? route.skipInterceptors : undefined;
+    if (skip === true) return [];
+    const steps = [];
+    for (let i = 0; i < interceptors.length; i++) {
+      const entry = interceptors[i];
+      if (skip && skip.includes(entry.source)) continue;
+      steps.push(timed(entry.run, INTERCEPT));
+    }
+    return steps;
   }
 
-  async function handleRequest(req, res, pathname) {
-    // Global interceptors
-    if (hasInterceptors) {
-      if (!(await runIntercept(interceptors, req, res))) return;
+  /**
+   * Compose a route's whole pipeline into one function: global
+   * interceptors, body parsing and validation, route interceptors, then
+   * the handler. It returns undefined when everything ran synchronously,
+   * otherwise a promise that rejects with the first error.
+   * @param {import("../../vibe.js").VibeRoute} route
+   * @returns {(req: any, res: any) => Promise<void> | void}
+   */
+  function compose(route) {
+    const steps = globalsFor(route);
+    const { media, method } = route;
+    const validate = route.validate || null;
+
+    // Schema-typed query validation (parsed here, so before any body)
+    const validateQuery = route.validateQuery || null;
+    if (validateQuery) {
+      steps.push(
+        timed((req, res) => {
+          const problem = validateQuery(req.query);
+          if (problem === null) return true;
+          res.writeHead(400, JSON_HEADERS);
+          res.end(JSON.stringify({ error: "Bad Request", message: problem }));
+          return false;
+        }, VALIDATE),
+      );
     }
 
-    // Lazy IP
-    if (!req.ip) {
-      req.ip = req.socket.remoteAddress || req.headers["x-forwarded-for"];
+    // Body parsing (only for non-GET with body)
+    if (media || validate || (method !== "GET" && method !== "HEAD")) {
+      steps.push(
+        timed(
+          (req, res) =>
+            bodyParser(req, res, media, options, validate).then(
+              // Already answered (413/400) or the client aborted mid-body
+              () => !(req.destroyed && !req.complete),
+            ),
+          BODY,
+        ),
+      );
     }
 
-    // Route matching - FAST PATH first
-    const routeKey = req.method + pathname;
-    let match = staticRoutes.get(routeKey);
+    // Schema-compiled body validation (before any route code runs)
+    if (validate) {
+      steps.push(
+        timed((req, res) => {
+          const problem = validate(req.body);
+          if (problem === null) return true;
+          res.writeHead(400, JSON_HEADERS);
+          res.end(JSON.stringify({ error: "Bad Request", message: problem }));
+          return false;
+        }, VALIDATE),
+      );
+    }
 
-    if (match) {
-      // Static route found - O(1)
-      match = { route: match, params: {} };
-    } else if (useTrieMatching) {
-      match = trie.match(req.method, pathname);
-    } else {
-      match = linearMatch(req.method, pathname);
+    // Route interceptors
+    const restFrom = steps.length;
+    if (route.intercept) {
+      const intercept = Array.isArray(route.intercept)
+        ? route.intercept
+        : [route.intercept];
+      for (let i = 0; i < intercept.length; i++) {
+        steps.push(timed(intercept[i], INTERCEPT));
+      }
+    }
+
+    let run = terminal(route);
+    for (let i = steps.length - 1; i >= 0; i--) {
+      run = link(i >= restFrom ? withRest(steps[i], run) : steps[i], run);
     }
+    return run;
+  }
+
+  /**
+   * Route interceptor that can see the rest of the route's pipeline as
+   * `req._rest` (the later interceptors and the handler). cacheMiddleware
+   * runs it against a detached response to refresh a stale entry.
+   */
+  function withRest(step, rest) {
+    return (req, res) => {
+      req._rest = rest;
+      return step(req, res);
+    };
+  }
 
-    if (!match) {
-      res.writeHead(404, TEXT_HEADERS);
-      res.end(NOT_FOUND_BODY);
-      return;
+  // Unmatched requests still pass through every global interceptor
+  let notFound = (req, res) => {
+    res.writeHead(404, TEXT_HEADERS);
+    res.end(NOT_FOUND_BODY);
+  };
+  {
+    const steps = globalsFor(null);
+    for (let i = steps.length - 1; i >= 0; i--) {
+      notFound = link(steps[i], notFound);
     }
+  }
 
-    const { route, params } = match;
-    const { handler, intercept, media, serialize } = route;
+  // Compose every route once; routes registered after listen() are
+  // composed on first use
+  for (let i = 0; i < routes.length; i++) {
+    routes[i]._dispatch = compose(routes[i]);
+  }
 
+  function dispatch(run, req, res) {
     try {
-      // Body parsing (only for non-GET with body)
-      const method = req.method;
-      if (media || (method !== "GET" && method !== "HEAD")) {
-        await bodyParser(req, res, media, options);
+      const pending = run(req, res);
+      if (pending !== undefined) {
+        pending.catch((err) => options.errorHandler(err, req, res));
       }
+    } catch (err) {
+      options.errorHandler(err, req, res);
+    }
+  }
 
-      req.params = params;
+  // Main request handler - ULTRA OPTIMIZED
+  function reqListener(req, res) {
+    // Fast pathname extraction
+    const url = req.url;
+    const qIdx = url.indexOf("?");
+    const pathname = qIdx < 0 ? url : url.slice(0, qIdx);
+    req.url = pathname;
 
-      // Route interceptors
-      if (intercept) {
-        if (!(await runIntercept(intercept, req, res))) return;
-      }
+    // Every field Vibe adds, always in this order, so all requests (and
+    // all responses) share one hidden class. Lazy values (id, log, ip,
+    // query, decorators) are filled in by the prototype accessors.
+    req._vibeOptions = options;
+    req._seq = ++reqSeq;
+    req._id = undefined;
+    req._log = undefined;
+    req._ip = undefined;
+    req._qIdx = qIdx;
+    req._rawUrl = url;
+    req._parsedQuery = undefined;
+    req._decorations = null;
+    req.params = EMPTY_PARAMS;
+    req.route = null;
+    req.body = undefined;
+    req.files = undefined;
+    req._rest = null;
+    req._trace = tracer === null ? null : tracer.start(req, res);
+
+    // Response methods read their options from here
+    res._vibeOptions = options;
+    res._vibeStart = metrics !== null ? performance.now() : -1;
+    res._vibeRoute = 0; // unmatched until a route is found
+    res._decorations = null;
+    if (draining && !isHttp2(req)) res.setHeader("connection", "close");
 
-      // Execute handler
-      if (typeof handler === "function") {
-        const result = await handler(req, res);
-        if (result instanceof Error) {
-          return options.errorHandler(result, req, res);
-        }
-        if (result !== undefined && !res.writableEnded) {
-          if (serialize) {
-            // Pre-compiled schema serializer — fastest path
-            res.writeHead(200, JSON_HEADERS);
-            res.end(serialize(result));
-          } else {
-            res.writeHead(200, JSON_HEADERS);
-            res.end(JSON.stringify(result));
-          }
-        }
-      } else if (isSendAble(handler)) {
-        if (serialize && typeof handler === "object" && handler !== null) {
-          res.writeHead(200, JSON_HEADERS);
-          res.end(serialize(handler));
-        } else {
-          res.send(handler);
-        }
-      } else {
-        throw new Error("Invalid handler type");
+    if (lifecycle) {
+      req.startTime = Date.now();
+      req.log.info({ type: "req" }, "Incoming request");
+
+      res.on("finish", () => {
+        req.log.info(
+          {
+            type: "res",
+            statusCode: res.statusCode,
+            responseTimeMs: Date.now() - req.startTime,
+          },
+          "Request completed",
+        );
+      });
+    }
+
+    // Route matching - static routes first, O(1)
+    let route = staticRoutes.get(req.method + pathname);
+    let params = EMPTY_PARAMS;
+    if (route === undefined) {
+      const match = compiledRouter
+        ? trie.matchCompiled(req.method, pathname)
+        : useTrieMatching
+          ? trie.match(req.method, pathname)
+          : linearMatch(routes, req.method, pathname);
+      if (!match) {
+        if (req._trace !== null) tracer.routed(req, req._trace, null);
+        return dispatch(notFound, req, res);
       }
-    } catch (err) {
-      options.errorHandler(err, req, res);
+      route = match.route;
+      params = match.params;
     }
+
+    req.params = params;
+    req.route = route;
+    if (metrics !== null) res._vibeRoute = route._metricsId ?? 0;
+    if (req._trace !== null) tracer.routed(req, req._trace, route);
+
+    if (admitting && route._handlerType !== 2 && !admit(route, res)) return;
+
+    dispatch(route._dispatch || (route._dispatch = compose(route)), req, res);
   }
 
   let mainHost = host || "0.0.0.0";
   if (mainHost === "localhost") mainHost = "127.0.0.1";
 
-  const vibe_server = http.createServer(reqListener);
+  // HTTP/1.1, HTTPS, or HTTP/2 (options.https / options.http2)
+  const vibe_server = createServer(options, reqListener);
+  const scheme = options.https ? "https" : "http";
 
-  vibe_server.listen(port, mainHost, () => {
-    getNetworkIP(mainHost, port);
+  // HTTP/2 sessions, closed with GOAWAY on shutdown
+  const sessions = new Set();
+  if (options.http2) {
+    vibe_server.on("session", (session) => {
+      sessions.add(session);
+      session.once("close", () => sessions.delete(session));
+    });
+  }
+
+  const listenOptions = { port, host: mainHost };
+  if (process.env.VIBE_REUSE_PORT === "1") {
+    // clusterize({ reusePort }): bind our own SO_REUSEPORT socket instead of
+    // sharing the primary's, so the kernel balances accepts across workers
+    listenOptions.reusePort = true;
+    listenOptions.exclusive = true;
+  }
 
-    const strategy = useTrieMatching ? "Trie (O(log n))" : "Linear (O(n))";
+  vibe_server.listen(listenOptions, () => {
+    getNetworkIP(mainHost, port, scheme);
+
+    const strategy = compiledRouter
+      ? "Compiled (generated matcher)"
+      : useTrieMatching
+        ? "Trie (O(log n))"
+        : "Linear (O(n))";
     console.log(
-      `[VIBE] Route matching: ${strategy} (${options.routeCount} routes, ${staticRoutes.size} static, threshold: ${options.trieThreshold})`,
+      `[VIBE] Route matching: ${strategy} (${options.routeCount} routes, ${staticRoutes.size} static, ${dynamicCount} with params, threshold: ${options.trieThreshold})`,
     );
 
+    // Rolling reloads wait for this before draining the old worker
+    if (cluster.isWorker) process.send({ type: "vibe:listening", port });
+
     if (callback) callback();
   });
 
@@ -305,14 +642,32 @@ async function server(options, port, host, callback) {
   });
 
   // Graceful shutdown support for node --watch, nodemon, and cluster mode
+  const drainTimeout =
+    Number(process.env.VIBE_DRAIN_TIMEOUT) || options.drainTimeout;
   const shutdown = () => {
-    // vibe_server.close stops accepting new connections
-    // Existing keep-alive connections will still prevent instant exit,
-    // so we force an exit if it takes longer than 3 seconds.
+    if (draining) return;
+    draining = true;
+
+    // Stop accepting and drop idle keep-alive connections. Busy ones end
+    // after their current response (sent with `connection: close`); the
+    // server closes once the last one is gone.
     vibe_server.close(() => {
+      logger.flush();
       process.exit(0);
     });
-    setTimeout(() => process.exit(0), 3000).unref();
+    // HTTP/2: GOAWAY lets open streams finish and refuses new ones. The
+    // HTTP/1.1 fallback of an HTTP/2 server has no idle tracking; its
+    // connections close after their next response or at drainTimeout.
+    for (const session of sessions) session.close();
+    vibe_server.closeIdleConnections?.();
+
+    // Requests still running after drainTimeout are cut off
+    setTimeout(() => {
+      vibe_server.closeAllConnections?.();
+      for (const session of sessions) session.destroy();
+      logger.flush();
+      process.exit(0);
+    }, drainTimeout).unref();
   };
 
   process.on("SIGTERM", shutdown);
@@ -0,0 +1,728 @@
+/**
+ * Static file engine for the public folder.
+ *
+ * The folder is scanned once into a manifest (kept current by a watcher),
+ * so requests never stat the disk. Small files are held in memory as ready
+ * Buffers with precomputed headers; larger ones stream from a pooled file
+ * descriptor. Supports single-range `Range` requests and conditional GET.
+ *
+ * Precompressed `.br` / `.gz` siblings (or variants generated once in the
+ * background) are picked from `Accept-Encoding`, so no response is ever
+ * compressed on the request path.
+ */
+import fs from "fs";
+import path from "path";
+import zlib from "zlib";
+import { mimeTypes } from "../helpers/mime.js";
+
+const TEXT_HEADERS = Object.freeze({ "content-type": "text/plain" });
+const RANGE_RE = /^bytes=(\d*)-(\d*)$/;
+
+// Content-Encoding -> sibling file extension, in order of preference
+const ENCODINGS = [
+  ["br", ".br"],
+  ["gzip", ".gz"],
+];
+const BR = 1;
+const GZIP = 2;
+
+// Worth compressing: text-like types only (images/fonts are already packed)
+const COMPRESSIBLE =
+  /^(text\/|application\/(json|javascript|xml|wasm)|image\/svg\+xml)/;
+
+// fs methods for streams over a pooled fd: destroying the stream must not
+// close a descriptor that other streams share (the pool closes it)
+const POOLED_FS = {
+  open: fs.open,
+  read: fs.read,
+  close(fd, callback) {
+    callback();
+  },
+};
+
+/**
+ * Static engine options
+ * @typedef {Object} StaticOptions
+ * @property {number} [inlineSize=65536] - Files up to this size (bytes) are kept in memory
+ * @property {number} [maxFds=64] - Idle file descriptors kept open for large files
+ * @property {boolean} [watch=true] - Watch the folder and update the manifest
+ * @property {boolean} [compress=false] - Generate missing .br/.gz variants in the background
+ * @property {number} [compressMinSize=1024] - Smallest file (bytes) worth compressing
+ * @property {number} [compressMaxSize=10485760] - Largest file (bytes) compressed into memory
+ */
+
+/**
+ * Manifest record for one file
+ * @typedef {Object} StaticFile
+ * @property {string} abs - Absolute path
+ * @property {number} size - Size in bytes
+ * @property {number} mtime - Modification time (ms, truncated to seconds)
+ * @property {string} etag
+ * @property {string} lastModified - HTTP date
+ * @property {string} contentType
+ * @property {Buffer | null} body - File contents when inlined
+ * @property {boolean} pooled - Large-file reads go through the fd pool
+ * @property {{ br?: StaticFile, gzip?: StaticFile } | null} variants - Compressed variants
+ * @property {Object} headers - Ready 200 response headers
+ */
+
+/**
+ * Parses a single `bytes=` range.
+ * @param {string} header
+ * @param {number} size
+ * @returns {{ start: number, end: number } | null | undefined}
+ *   null when unsatisfiable (416), undefined when unsupported (send 200)
+ */
+export function parseRange(header, size) {
+  const m = RANGE_RE.exec(header);
+  if (!m || (m[1] === "" && m[2] === "")) return undefined;
+
+  let start;
+  let end;
+  if (m[1] === "") {
+    // Suffix range: last N bytes
+    const n = Number(m[2]);
+    if (n === 0) return null;
+    start = Math.max(size - n, 0);
+    end = size - 1;
+  } else {
+    start = Number(m[1]);
+    end = m[2] === "" ? size - 1 : Math.min(Number(m[2]), size - 1);
+    if (start >= size) return null;
+    if (end < start) return undefined;
+  }
+  return { start, end };
+}
+
+// Accept-Encoding header -> BR | GZIP bitmask (few distinct values in practice)
+const acceptCache = new Map();
+
+/**
+ * Which of br/gzip a client accepts (q=0 means refused).
+ * @param {string | undefined} header
+ * @returns {number} Bitmask of BR | GZIP
+ */
+export function acceptedEncodings(header) {
+  if (header === undefined) return 0;
+  let mask = acceptCache.get(header);
+  if (mask !== undefined) return mask;
+
+  mask = 0;
+  for (const part of header.split(",")) {
+    const semi = part.indexOf(";");
+    const name = (semi < 0 ? part : part.slice(0, semi)).trim().toLowerCase();
+    if (semi >= 0) {
+      const q = /q=([\d.]+)/.exec(part.slice(semi));
+      if (q && Number(q[1]) === 0) continue;
+    }
+    if (name === "br") mask |= BR;
+    else if (name === "gzip") mask |= GZIP;
+    else if (name === "*") mask |= BR | GZIP;
+  }
+
+  if (acceptCache.size >= 256) acceptCache.clear();
+  acceptCache.set(header, mask);
+  return mask;
+}
+
+/**
+ * In-memory manifest of a folder plus an fd pool for large files.
+ */
+export class StaticFiles {
+  /**
+   * @param {string} root - Folder to serve
+   * @param {StaticOptions} [options]
+   */
+  constructor(root, options = {}) {
+    this.root = path.resolve(root);
+    this.inlineSize = options.inlineSize ?? 64 * 1024;
+    this.maxFds = options.maxFds || 64;
+    this.compress = options.compress === true;
+    this.compressMinSize = options.compressMinSize ?? 1024;
+    this.compressMaxSize = options.compressMaxSize ?? 10 * 1024 * 1024;
+
+    // Background compression jobs, run one at a time
+    this.queue = [];
+    this.compressing = false;
+
+    /** @type {Map<string, StaticFile>} relative path ("css/app.css") -> record */
+    this.files = new Map();
+
+    // abs path -> { fd, refs, stale, waiting }; insertion order = LRU
+    this.fds = new Map();
+
+    this.watcher = null;
+
+    this.scan();
+    if (options.watch !== false) this.watch();
+  }
+
+  /**
+   * Builds the manifest synchronously (startup only).
+   */
+  scan() {
+    this.files.clear();
+    if (!fs.existsSync(this.root)) return;
+
+    // Directories already walked, by dev:ino, so a symlink back up the
+    // tree (`ln -s .. loop`) is skipped instead of walked again
+    const seen = new Set();
+    const walk = (dir, stat) => {
+      const id = `${stat.dev}:${stat.ino}`;
+      if (seen.has(id)) return;
+      seen.add(id);
+      for (const dirent of fs.readdirSync(dir, { withFileTypes: true })) {
+        const abs = path.join(dir, dirent.name);
+        let stat;
+        try {
+          stat = fs.statSync(abs);
+        } catch {
+          continue; // Dangling symlink
+        }
+        if (stat.isDirectory()) {
+          walk(abs, stat);
+        } else if (stat.isFile()) {
+          const body =
+            stat.size <= this.inlineSize ? fs.readFileSync(abs) : null;
+          this.files.set(this.relative(abs), this.record(abs, stat, body));
+        }
+      }
+    };
+    walk(this.root, fs.statSync(this.root));
+
+    for (const rel of [...this.files.keys()]) this.link(rel);
+  }
+
+  /**
+   * Attaches compressed variants to a file: existing `.br`/`.gz` siblings
+   * first, then (with `compress`) background-generated ones.
+   * @param {string} rel
+   */
+  link(rel) {
+    const base = this.files.get(rel);
+    if (!base || rel.endsWith(".br") || rel.endsWith(".gz")) return;
+
+    base.variants = null;
+    delete base.headers.vary;
+    const missing = [];
+    for (const [encoding, ext] of ENCODINGS) {
+      const sibling = this.files.get(rel + ext);
+      if (sibling) {
+        this.addVariant(base, encoding, sibling);
+      } else {
+        missing.push(encoding);
+      }
+    }
+
+    if (
+      this.compress &&
+      missing.length > 0 &&
+      base.size >= this.compressMinSize &&
+      base.size <= this.compressMaxSize &&
+      COMPRESSIBLE.test(base.contentType)
+    ) {
+      this.queue.push({ rel, base, missing });
+      this.pump();
+    }
+  }
+
+  /**
+   * @param {StaticFile} base
+   * @param {string} encoding
+   * @param {{ size: number, body: Buffer | null, abs: string | null, pooled: boolean }} source
+   */
+  addVariant(base, encoding, source) {
+    const etag = base.etag.slice(0, -1) + "-" + encoding + '"';
+    if (!base.variants) base.variants = {};
+    base.variants[encoding] = {
+      abs: source.abs,
+      size: source.size,
+      mtime: base.mtime,
+      etag,
+      lastModified: base.lastModified,
+      contentType: base.contentType,
+      body: source.body,
+      pooled: source.pooled,
+      variants: null,
+      headers: {
+        "content-type": base.contentType,
+        "content-length": source.size,
+        "content-encoding": encoding,
+        etag,
+        "last-modified": base.lastModified,
+        vary: "Accept-Encoding",
+      },
+    };
+    // The identity response varies too, or caches would pin one encoding
+    base.headers.vary = "Accept-Encoding";
+  }
+
+  // Runs the next compression job; zlib works on the libuv threadpool,
+  // one job at a time so request-path fs reads are not starved
+  pump() {
+    if (this.compressing) return;
+    const job = this.queue.shift();
+    if (!job) return;
+    this.compressing = true;
+
+    const next = () => {
+      this.compressing = false;
+      this.pump();
+    };
+    const stale = () => this.files.get(job.rel) !== job.base;
+
+    const run = (source) => {
+      let pending = job.missing.length;
+      for (const encoding of job.missing) {
+        const done = (err, out) => {
+          if (!err && !stale() && out.length < source.length) {
+            this.addVariant(job.base, encoding, {
+              size: out.length,
+              body: out,
+              abs: null,
+              pooled: false,
+            });
+          }
+          if (--pending === 0) next();
+        };
+        if (encoding === "br") {
+          zlib.brotliCompress(
+            source,
+            {
+              params: {
+                [zlib.constants.BROTLI_PARAM_MODE]:
+                  zlib.constants.BROTLI_MODE_TEXT,
+                [zlib.constants.BROTLI_PARAM_QUALITY]: 11,
+                [zlib.constants.BROTLI_PARAM_SIZE_HINT]: source.length,
+              },
+            },
+            done,
+          );
+        } else {
+          zlib.gzip(source, { level: 9 }, done);
+        }
+      }
+    };
+
+    if (stale()) return next();
+    if (job.base.body) return run(job.base.body);
+    fs.readFile(job.base.abs, (err, source) => {
+      if (err || stale()) return next();
+      run(source);
+    });
+  }
+
+  /**
+   * Keeps the manifest current. Changes are applied asynchronously.
+   */
+  watch() {
+    if (this.watcher || !fs.existsSync(this.root)) return;
+    try {
+      this.watcher = fs.watch(this.root, { recursive: true }, (_, filename) => {
+        if (filename) this.refresh(filename.toString());
+      });
+      this.watcher.on("error", () => this.unwatch());
+      this.watcher.unref();
+    } catch {
+      // Recursive watch unsupported: manifest stays as scanned
+      this.watcher = null;
+    }
+  }
+
+  /**
+   * Stops watching the folder.
+   */
+  unwatch() {
+    if (this.watcher) this.watcher.close();
+    this.watcher = null;
+  }
+
+  /**
+   * Stops watching and closes descriptors once their streams finish.
+   */
+  close() {
+    this.unwatch();
+    for (const slot of this.fds.values()) this.retire(slot);
+    this.fds.clear();
+  }
+
+  /**
+   * Re-reads one changed path (file or directory) from disk.
+   * @param {string} filename - Path relative to root
+   */
+  refresh(filename) {
+    const abs = path.join(this.root, filename);
+    const rel = this.relative(abs);
+
+    const slot = this.fds.get(abs);
+    if (slot) {
+      this.fds.delete(abs);
+      this.retire(slot);
+    }
+
+    fs.stat(abs, (err, stat) => {
+      if (err) {
+        // Removed: drop the file and anything under it
+        this.files.delete(rel);
+        const prefix = rel + "/";
+        for (const key of this.files.keys()) {
+          if (key.startsWith(prefix)) this.files.delete(key);
+        }
+        this.relink(rel);
+        return;
+      }
+
+      if (stat.isDirectory()) {
+        fs.readdir(abs, (readErr, names) => {
+          if (readErr) return;
+          for (const name of names) this.refresh(path.join(filename, name));
+        });
+        return;
+      }
+
+      if (!stat.isFile()) return;
+      if (stat.size > this.inlineSize) {
+        this.files.set(rel, this.record(abs, stat, null));
+        this.relink(rel);
+        return;
+      }
+      fs.readFile(abs, (readErr, body) => {
+        if (readErr) return;
+        this.files.set(rel, this.record(abs, stat, body));
+        this.relink(rel);
+      });
+    });
+  }
+
+  // A changed file or sibling: re-attach the variants of its base file
+  relink(rel) {
+    if (rel.endsWith(".br") || rel.endsWith(".gz")) {
+      this.link(rel.slice(0, -3));
+    } else {
+      this.link(rel);
+    }
+  }
+
+  /**
+   * @param {string} abs
+   * @param {fs.Stats} stat
+   * @param {Buffer | null} body
+   * @param {boolean} [pooled=true] - Stream through the fd pool (files under root)
+   * @returns {StaticFile}
+   */
+  record(abs, stat, body, pooled = true) {
+    const mtime = Math.floor(stat.mtimeMs / 1000) * 1000;
+    const etag = `"${stat.size.toString(16)}-${mtime.toString(16)}"`;
+    const lastModified = new Date(mtime).toUTCString();
+    const contentType =
+      mimeTypes[path.extname(abs).toLowerCase()] || "application/octet-stream";
+
+    return {
+      abs,
+      size: stat.size,
+      mtime,
+      etag,
+      lastModified,
+      contentType,
+      body,
+      pooled,
+      variants: null,
+      headers: {
+        "content-type": contentType,
+        "content-length": stat.size,
+        etag,
+        "last-modified": lastModified,
+        "accept-ranges": "bytes",
+      },
+    };
+  }
+
+  relative(abs) {
+    return path.relative(this.root, abs).split(path.sep).join("/");
+  }
+
+  /**
+   * Finds the manifest record for a request path.
+   * @param {string} rel - Path relative to root (may be URL-encoded)
+   * @returns {StaticFile | null | undefined} null for traversal attempts
+   */
+  lookup(rel) {
+    const key = this.keyOf(rel);
+    return typeof key === "string" ? this.files.get(key) : key;
+  }
+
+  /**
+   * Normalizes a request path to a manifest key ("css/app.css").
+   * @param {string} rel - Path relative to root (may be URL-encoded)
+   * @returns {string | null | undefined} null for traversal attempts,
+   *   undefined when it can't be decoded
+   */
+  keyOf(rel) {
+    let key = rel.charCodeAt(0) === 47 ? rel.slice(1) : rel;
+    if (key.indexOf("%") !== -1) {
+      try {
+        key = decodeURIComponent(key);
+      } catch {
+        return undefined;
+      }
+    }
+    if (key.indexOf("//") !== -1 || key.indexOf("..") !== -1) {
+      const segments = key.split("/").filter(Boolean);
+      if (segments.includes("..")) return null;
+      key = segments.join("/");
+    }
+    return key;
+  }
+
+  /**
+   * Serves a path relative to root: 404/403 without touching the disk.
+   * @param {import("http").IncomingMessage} req
+   * @param {import("http").ServerResponse} res
+   * @param {string} rel
+   * @param {Object} [extraHeaders] - Merged into the file's headers
+   */
+  serve(req, res, rel, extraHeaders) {
+    const file = this.lookup(rel);
+    if (file) return this.send(req, res, file, extraHeaders);
+
+    const status = file === null ? 403 : 404;
+    res.writeHead(status, TEXT_HEADERS);
+    res.end(status === 403 ? "Forbidden" : "Not Found");
+  }
+
+  /**
+   * Like serve(), but a manifest miss is checked on disk before the 404:
+   * a file written since the scan (before the watcher catches up, or with
+   * `watch: false`) is recorded into the manifest and sent. Used by
+   * res.sendFile() / res.sendHtml(), whose handlers may have just written
+   * the file.
+   * @param {import("http").IncomingMessage} req
+   * @param {import("http").ServerResponse} res
+   * @param {string} rel
+   * @param {Object} [extraHeaders] - Merged into the file's headers
+   */
+  serveFile(req, res, rel, extraHeaders) {
+    const key = this.keyOf(rel);
+    const file = typeof key === "string" ? this.files.get(key) : key;
+    if (file) return this.send(req, res, file, extraHeaders);
+    if (file === null || !key) return this.serve(req, res, rel, extraHeaders);
+
+    const abs = path.join(this.root, key);
+    fs.stat(abs, (err, stat) => {
+      if (err || !stat.isFile()) {
+        res.writeHead(404, TEXT_HEADERS);
+        res.end("Not Found");
+        return;
+      }
+      // Streamed from the fd pool; a later refresh may inline it
+      const recorded = this.record(abs, stat, null);
+      this.files.set(key, recorded);
+      this.relink(key);
+      this.send(req, res, recorded, extraHeaders);
+    });
+  }
+
+  /**
+   * Writes a manifest file, honouring conditional and Range headers.
+   * @param {import("http").IncomingMessage} req
+   * @param {import("http").ServerResponse} res
+   * @param {StaticFile} file
+   * @param {Object} [extraHeaders] - Merged into every response (e.g. download)
+   */
+  send(req, res, file, extraHeaders) {
+    const h = req.headers;
+    const range = h.range;
+
+    // Pick a precompressed variant (Range requests stay on identity bytes)
+    let out = file;
+    if (file.variants !== null && range === undefined) {
+      const accepted = acceptedEncodings(h["accept-encoding"]);
+      const variants = file.variants;
+      if (variants.br !== undefined && (accepted & BR) !== 0) {
+        out = variants.br;
+      } else if (variants.gzip !== undefined && (accepted & GZIP) !== 0) {
+        out = variants.gzip;
+      }
+    }
+
+    // Conditional GET: If-None-Match wins over If-Modified-Since
+    const inm = h["if-none-match"];
+    const ims = h["if-modified-since"];
+    if (
+      inm !== undefined
+        ? inm === "*" || inm.indexOf(out.etag) !== -1
+        : ims !== undefined && Date.parse(ims) >= file.mtime
+    ) {
+      const notModified = {
+        etag: out.etag,
+        "last-modified": file.lastModified,
+      };
+      if (file.variants !== null) notModified.vary = "Accept-Encoding";
+      res.writeHead(304, notModified);
+      res.end();
+      return;
+    }
+
+    const head = req.method === "HEAD";
+    if (range !== undefined && file.size > 0) {
+      const ifRange = h["if-range"];
+      if (
+        ifRange === undefined ||
+        ifRange === file.etag ||
+        ifRange === file.lastModified
+      ) {
+        const r = parseRange(range, file.size);
+        if (r === null) {
+          res.writeHead(416, { "content-range": `bytes */${file.size}` });
+          res.end();
+          return;
+        }
+        if (r !== undefined) {
+          res.writeHead(206, {
+            ...file.headers,
+            ...extraHeaders,
+            "content-length": r.end - r.start + 1,
+            "content-range": `bytes ${r.start}-${r.end}/${file.size}`,
+          });
+          if (head) res.end();
+          else if (file.body) res.end(file.body.subarray(r.start, r.end + 1));
+          else this.stream(res, file, r.start, r.end);
+          return;
+        }
+      }
+    }
+
+    res.writeHead(
+      200,
+      extraHeaders ? { ...out.headers, ...extraHeaders } : out.headers,
+    );
+    if (head || out.size === 0) res.end();
+    else if (out.body) res.end(out.body);
+    else this.stream(res, out, 0, out.size - 1);
+  }
+
+  /**
+   * Streams a byte range from a pooled descriptor. Reads are positional,
+   * so concurrent streams can share one fd.
+   */
+  stream(res, file, start, end) {
+    // Files outside the watched root are not pooled (no change events)
+    if (!file.pooled) {
+      const stream = fs.createReadStream(file.abs, { start, end });
+      stream.on("error", (err) => res.destroy(err));
+      res.on("close", () => stream.destroy());
+      stream.pipe(res);
+      return;
+    }
+
+    this.acquire(file.abs, (err, slot) => {
+      if (err) {
+        res.destroy(err);
+        return;
+      }
+      const stream = fs.createReadStream(null, {
+        fd: slot.fd,
+        fs: POOLED_FS,
+        start,
+        end,
+      });
+      let released = false;
+      const release = () => {
+        if (released) return;
+        released = true;
+        this.release(slot);
+      };
+      stream.on("error", (streamErr) => {
+        release();
+        res.destroy(streamErr);
+      });
+      stream.on("close", release);
+      res.on("close", () => stream.destroy());
+      stream.pipe(res);
+    });
+  }
+
+  acquire(abs, callback) {
+    let slot = this.fds.get(abs);
+    if (slot) {
+      // Most recently used goes last
+      this.fds.delete(abs);
+      this.fds.set(abs, slot);
+      slot.refs++;
+      if (slot.fd === null) slot.waiting.push(callback);
+      else callback(null, slot);
+      return;
+    }
+
+    slot = { fd: null, refs: 1, stale: false, waiting: [callback] };
+    this.fds.set(abs, slot);
+    fs.open(abs, "r", (err, fd) => {
+      const waiting = slot.waiting;
+      slot.waiting = [];
+      if (err) {
+        if (this.fds.get(abs) === slot) this.fds.delete(abs);
+        for (const cb of waiting) cb(err);
+        return;
+      }
+      slot.fd = fd;
+      for (const cb of waiting) cb(null, slot);
+      this.trim();
+    });
+  }
+
+  release(slot) {
+    slot.refs--;
+    if (slot.stale) this.retire(slot);
+    else this.trim();
+  }
+
+  // Closes a descriptor once no stream uses it
+  retire(slot) {
+    slot.stale = true;
+    if (slot.refs > 0 || slot.fd === null) return;
+    const fd = slot.fd;
+    slot.fd = null;
+    fs.close(fd, () => {});
+  }
+
+  // Keeps at most maxFds descriptors open, closing idle ones oldest-first
+  trim() {
+    if (this.fds.size <= this.maxFds) return;
+    for (const [abs, slot] of this.fds) {
+      if (this.fds.size <= this.maxFds) break;
+      if (slot.refs > 0 || slot.fd === null) continue;
+      this.fds.delete(abs);
+      this.retire(slot);
+    }
+  }
+}
+
+/**
+ * Returns the app's static engine, building it on first use.
+ * @param {Object} options - App options (publicFolder, static)
+ * @returns {StaticFiles}
+ */
+export function getStaticFiles(options) {
+  const folder = options.publicFolder || "public";
+  let files = options.staticFiles;
+  // Rebuilt only if setPublicFolder() changed the folder since
+  if (!files || files.folder !== folder) {
+    if (files) files.close();
+    files = new StaticFiles(folder, options.static);
+    files.folder = folder;
+    options.staticFiles = files;
+  }
+  return files;
+}
+
+/**
+ * Creates the static engine for a folder.
+ * @param {string} root
+ * @param {StaticOptions} [options]
+ * @returns {StaticFiles}
+ */
+export function createStaticFiles(root, options) {
+  return new StaticFiles(root, options);
+}
+
+export default createStaticFiles;
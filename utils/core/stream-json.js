@@ -0,0 +1,119 @@
+/**
+ * Incremental JSON responses.
+ *
+ * Large arrays, async iterators and object-mode Readables returned by a
+ * handler are written as a JSON array in fixed-size chunks instead of one
+ * big string, so memory stays flat and the first bytes leave right away.
+ * Writes respect backpressure: the writer waits for `drain` whenever the
+ * socket buffer is full.
+ *
+ * @module stream-json
+ */
+import { pipeline } from "stream";
+
+/**
+ * Streaming thresholds
+ * @typedef {Object} StreamingOptions
+ * @property {number} [minItems=1000] - Schema arrays at least this long are streamed
+ * @property {number} [chunkSize=16384] - Characters buffered per res.write()
+ */
+
+const JSON_HEADERS = { "content-type": "application/json" };
+const BINARY_HEADERS = { "content-type": "application/octet-stream" };
+
+function serializeAny(v) {
+  const json = JSON.stringify(v);
+  return json === undefined ? "null" : json;
+}
+
+/**
+ * Whether a handler result should be streamed rather than serialized
+ * in one piece.
+ * @param {any} result - Handler return value (non-null object)
+ * @param {((data: any) => string) & { item?: Function } | null} serialize - Route serializer
+ * @param {number} minItems
+ * @returns {boolean}
+ */
+export function isStreamable(result, serialize, minItems) {
+  if (Array.isArray(result)) {
+    return (
+      serialize != null &&
+      serialize.item !== undefined &&
+      result.length >= minItems
+    );
+  }
+  return (
+    typeof result[Symbol.asyncIterator] === "function" ||
+    typeof result.pipe === "function"
+  );
+}
+
+// Resolves once the socket can take more data (or is gone)
+function drained(res) {
+  return new Promise((resolve) => {
+    const done = () => {
+      res.off("drain", done);
+      res.off("close", done);
+      resolve();
+    };
+    res.on("drain", done);
+    res.on("close", done);
+  });
+}
+
+/**
+ * Writes `source` to `res` as a JSON array, chunk by chunk.
+ * Headers go out with the first chunk, so an error thrown before that can
+ * still become a normal error response; later errors destroy the socket.
+ *
+ * @param {import("http").ServerResponse} res
+ * @param {any[] | AsyncIterable<any> | import("stream").Readable} source
+ * @param {(item: any) => string} [serializeItem] - Compiled item serializer
+ * @param {number} [chunkSize=16384]
+ * @returns {Promise<void>}
+ */
+export async function streamJson(res, source, serializeItem, chunkSize) {
+  // Byte streams are passed through untouched
+  if (typeof source.pipe === "function" && source.readableObjectMode === false) {
+    if (!res.headersSent) res.writeHead(res.statusCode || 200, BINARY_HEADERS);
+    return new Promise((resolve) => pipeline(source, res, () => resolve()));
+  }
+
+  const item = serializeItem || serializeAny;
+  const limit = chunkSize || 16 * 1024;
+  let chunk = "[";
+  let first = true;
+
+  const flush = async () => {
+    if (!res.headersSent) res.writeHead(200, JSON_HEADERS);
+    const ok = res.write(chunk);
+    chunk = "";
+    if (!ok && !res.destroyed) await drained(res);
+  };
+
+  if (Array.isArray(source)) {
+    for (let i = 0, len = source.length; i < len; i++) {
+      chunk += first ? item(source[i]) : "," + item(source[i]);
+      first = false;
+      if (chunk.length >= limit) {
+        await flush();
+        if (res.destroyed) return;
+      }
+    }
+  } else {
+    // Breaking out of for-await closes the iterator / destroys the Readable
+    for await (const value of source) {
+      chunk += first ? item(value) : "," + item(value);
+      first = false;
+      if (chunk.length >= limit) {
+        await flush();
+        if (res.destroyed) return;
+      }
+    }
+  }
+
+  if (!res.headersSent) res.writeHead(200, JSON_HEADERS);
+  res.end(chunk + "]");
+}
+
+export default streamJson;
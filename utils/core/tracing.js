@@ -0,0 +1,308 @@
+/**
+ * Request Tracing
+ * Opt-in per-phase timing of sampled requests: routing, interceptors,
+ * body parsing, validation, handler and serialization.
+ *
+ * Nothing here runs unless the app is created with `trace`: the server
+ * only composes the timing wrappers into route pipelines when a tracer
+ * exists, so a disabled tracer costs nothing on the hot path. Enabled,
+ * unsampled requests pay one null check per phase; sampled ones record
+ * `performance.now()` deltas into a preallocated record.
+ *
+ * Each sampled request can be reported as OpenTelemetry spans (OTLP/JSON
+ * field names: a SERVER span plus one child per phase, continuing an
+ * incoming W3C `traceparent`), and is folded into per-route totals that
+ * export as a collapsed-stack flame summary.
+ */
+import crypto from "crypto";
+
+/**
+ * Tracing configuration
+ * @typedef {Object} TraceOptions
+ * @property {number} [sampleRate=1] - Fraction of requests traced (requests with a sampled `traceparent` always are)
+ * @property {(span: OtelSpan) => void} [onSpan] - Receives each finished span (phase children first, then the request span)
+ * @property {PhaseHook} [onRoute] - Route matched
+ * @property {PhaseHook} [onBodyParsed] - Body read and parsed
+ * @property {PhaseHook} [onHandler] - Handler returned (or its promise settled)
+ * @property {PhaseHook} [onSerialize] - Result serialized and written
+ */
+
+/**
+ * @callback PhaseHook
+ * @param {import("../../vibe.js").VibeRequest} req
+ * @param {number} ms - Time spent in the phase
+ */
+
+/**
+ * Span in OTLP/JSON shape
+ * @typedef {Object} OtelSpan
+ * @property {string} traceId - 32 hex chars
+ * @property {string} spanId - 16 hex chars
+ * @property {string} parentSpanId - Empty for a root span
+ * @property {string} name
+ * @property {number} kind - 1 internal, 2 server
+ * @property {string} startTimeUnixNano
+ * @property {string} endTimeUnixNano
+ * @property {{ key: string, value: Object }[]} attributes
+ * @property {{ code: number }} status - 0 unset, 2 error
+ */
+
+// Phase indices
+export const ROUTE = 0;
+export const INTERCEPT = 1;
+export const BODY = 2;
+export const VALIDATE = 3;
+export const HANDLER = 4;
+export const SERIALIZE = 5;
+const PHASES = 6;
+
+const PHASE_NAMES = [
+  "routing",
+  "interceptors",
+  "body",
+  "validation",
+  "handler",
+  "serialize",
+];
+// Hook per phase (interceptors and validation have none)
+const HOOK_NAMES = [
+  "onRoute",
+  null,
+  "onBodyParsed",
+  null,
+  "onHandler",
+  "onSerialize",
+];
+
+const TRACEPARENT_RE = /^00-([0-9a-f]{32})-([0-9a-f]{16})-([0-9a-f]{2})$/;
+const ZERO_TRACE = "0".repeat(32);
+
+// Unix nanoseconds (microsecond precision) for a performance.now() reading
+const unixNano = (ms) =>
+  String(BigInt(Math.round((performance.timeOrigin + ms) * 1000)) * 1000n);
+
+const stringAttr = (key, value) => ({ key, value: { stringValue: value } });
+const intAttr = (key, value) => ({ key, value: { intValue: String(value) } });
+
+/**
+ * Timing record of one sampled request
+ */
+class RequestTrace {
+  constructor(start, traceId, parentSpanId) {
+    this.start = start;
+    this.traceId = traceId;
+    this.parentSpanId = parentSpanId;
+    this.route = null;
+    // Per phase: total time and offset of its first start (-1: not run)
+    this.durations = new Float64Array(PHASES);
+    this.offsets = new Float64Array(PHASES).fill(-1);
+  }
+}
+
+/** Per-route sums behind summary() and folded() */
+class RouteTotals {
+  constructor(label) {
+    this.label = label;
+    this.count = 0;
+    this.phases = new Float64Array(PHASES);
+    this.total = 0;
+  }
+}
+
+/**
+ * Samples requests and collects their phase timings
+ */
+export class Tracer {
+  /**
+   * @param {TraceOptions} [options]
+   */
+  constructor(options = {}) {
+    this.sampleRate = options.sampleRate ?? 1;
+    this.onSpan = options.onSpan || null;
+    this.hooks = HOOK_NAMES.map((name) => (name && options[name]) || null);
+
+    this.sampled = 0;
+    /** @type {Map<object, RouteTotals>} keyed by route (null: unmatched) */
+    this.routes = new Map();
+  }
+
+  /**
+   * Decide whether to trace a request; starts its record if so
+   * @returns {RequestTrace | null}
+   */
+  start(req, res) {
+    const now = performance.now();
+    let traceId = null;
+    let parentSpanId = "";
+
+    // Parent-based sampling: a caller's traceparent decides for us
+    const header = req.headers.traceparent;
+    const parent =
+      typeof header === "string" ? TRACEPARENT_RE.exec(header) : null;
+    if (parent !== null && parent[1] !== ZERO_TRACE) {
+      if ((parseInt(parent[3], 16) & 1) === 0) return null;
+      traceId = parent[1];
+      parentSpanId = parent[2];
+    } else if (this.sampleRate < 1 && Math.random() >= this.sampleRate) {
+      return null;
+    }
+
+    const trace = new RequestTrace(now, traceId, parentSpanId);
+    this.sampled++;
+    res.once("close", () => this.finish(trace, req, res));
+    return trace;
+  }
+
+  /**
+   * Record time spent in a phase (from `since` until now)
+   * @param {RequestTrace} trace
+   * @param {number} phase
+   * @param {number} since - performance.now() when the phase started
+   */
+  phase(req, trace, phase, since) {
+    const ms = performance.now() - since;
+    trace.durations[phase] += ms;
+    if (trace.offsets[phase] < 0) trace.offsets[phase] = since - trace.start;
+    const hook = this.hooks[phase];
+    if (hook !== null) hook(req, ms);
+  }
+
+  /**
+   * Route matching is done (route null: no route matched)
+   */
+  routed(req, trace, route) {
+    trace.route = route;
+    this.phase(req, trace, ROUTE, trace.start);
+  }
+
+  finish(trace, req, res) {
+    const total = performance.now() - trace.start;
+    const route = trace.route;
+
+    let totals = this.routes.get(route);
+    if (totals === undefined) {
+      totals = new RouteTotals(
+        route ? `${route.method} ${route.path}` : "unmatched",
+      );
+      this.routes.set(route, totals);
+    }
+    totals.count++;
+    totals.total += total;
+    for (let i = 0; i < PHASES; i++) totals.phases[i] += trace.durations[i];
+
+    if (this.onSpan !== null) this.emit(trace, req, res, totals.label, total);
+  }
+
+  emit(trace, req, res, label, total) {
+    // One draw for every id: trace (16 bytes), request span, phase spans
+    const ids = crypto.randomBytes(24 + 8 * PHASES);
+    const traceId = trace.traceId ?? ids.toString("hex", 0, 16);
+    const spanId = ids.toString("hex", 16, 24);
+    const status = res.statusCode;
+    const aborted = !res.writableFinished;
+
+    for (let i = 0; i < PHASES; i++) {
+      if (trace.offsets[i] < 0) continue;
+      const start = trace.start + trace.offsets[i];
+      this.onSpan({
+        traceId,
+        spanId: ids.toString("hex", 24 + 8 * i, 32 + 8 * i),
+        parentSpanId: spanId,
+        name: PHASE_NAMES[i],
+        kind: 1,
+        startTimeUnixNano: unixNano(start),
+        endTimeUnixNano: unixNano(start + trace.durations[i]),
+        attributes: [],
+        status: { code: 0 },
+      });
+    }
+
+    const attributes = [
+      stringAttr("http.request.method", req.method),
+      stringAttr("url.path", req.url),
+      intAttr("http.response.status_code", status),
+    ];
+    if (trace.route !== null) {
+      attributes.push(stringAttr("http.route", trace.route.path));
+    }
+    if (aborted) attributes.push(stringAttr("error.type", "aborted"));
+    this.onSpan({
+      traceId,
+      spanId,
+      parentSpanId: trace.parentSpanId,
+      name: label,
+      kind: 2,
+      startTimeUnixNano: unixNano(trace.start),
+      endTimeUnixNano: unixNano(trace.start + total),
+      attributes,
+      status: { code: status >= 500 || aborted ? 2 : 0 },
+    });
+  }
+
+  /**
+   * Mean time per phase for each route (milliseconds)
+   * @returns {Record<string, { count: number, total: number, routing: number, interceptors: number, body: number, validation: number, handler: number, serialize: number }>}
+   */
+  summary() {
+    const r = (v) => Math.round(v * 1000) / 1000;
+    const out = {};
+    for (const totals of this.routes.values()) {
+      const entry = {
+        count: totals.count,
+        total: r(totals.total / totals.count),
+      };
+      for (let i = 0; i < PHASES; i++) {
+        entry[PHASE_NAMES[i]] = r(totals.phases[i] / totals.count);
+      }
+      out[totals.label] = entry;
+    }
+    return out;
+  }
+
+  /**
+   * Sampled time per route and phase in collapsed-stack format
+   * (`route;phase microseconds` per line), for flame graph tools.
+   * Time not spent in any phase (waiting on I/O between them, writing
+   * to the socket) is listed as `other`.
+   * @returns {string}
+   */
+  folded() {
+    const lines = [];
+    for (const totals of this.routes.values()) {
+      let inPhases = 0;
+      for (let i = 0; i < PHASES; i++) {
+        const us = Math.round(totals.phases[i] * 1000);
+        inPhases += totals.phases[i];
+        if (us > 0) lines.push(`${totals.label};${PHASE_NAMES[i]} ${us}`);
+      }
+      const other = Math.round((totals.total - inPhases) * 1000);
+      if (other > 0) lines.push(`${totals.label};other ${other}`);
+    }
+    return lines.join("\n");
+  }
+
+  /** Forget the collected totals */
+  reset() {
+    this.routes.clear();
+    this.sampled = 0;
+  }
+}
+
+/**
+ * Wrap spans in an OTLP/JSON ExportTraceServiceRequest, ready to POST to
+ * a collector's /v1/traces endpoint
+ * @param {OtelSpan[]} spans
+ * @param {string} [serviceName="vibe"]
+ */
+export function toOtlp(spans, serviceName = "vibe") {
+  return {
+    resourceSpans: [
+      {
+        resource: { attributes: [stringAttr("service.name", serviceName)] },
+        scopeSpans: [{ scope: { name: "vibe" }, spans }],
+      },
+    ],
+  };
+}
+
+export default Tracer;
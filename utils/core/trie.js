@@ -1,31 +1,90 @@
 /**
  * Radix Trie for efficient route matching.
- * Provides O(log n) average-case lookup instead of O(n) linear search.
+ * Static path characters are prefix-compressed into edges, so long shared
+ * prefixes like `/api/v2/tenants/` cost one `startsWith` instead of one
+ * lookup per segment. Provides O(k) lookup in the path length.
  */
 
 /**
  * @typedef {Object} TrieNode
- * @property {Map<string, TrieNode>} children - Static segment children
+ * @property {string} prefix - Static characters consumed by this node
+ * @property {TrieNode[]} children - Static children (distinct first chars)
+ * @property {number[]} childCodes - First char code of each static child
  * @property {TrieNode|null} paramChild - Dynamic parameter child (e.g., :id)
  * @property {TrieNode|null} wildcardChild - Wildcard child (*)
- * @property {string|null} paramName - Name of the parameter if this is a param node
+ * @property {string|null} paramName - Name of the parameter (first registered, for listing)
  * @property {import("../vibe.js").VibeRoute|null} route - The route if this is an endpoint
+ * @property {string|null} routePath - Normalized route path (for listing)
+ * @property {string[]|null} paramNames - Param names captured on the way to this route
+ * @property {Function|null} Params - Fixed-shape params constructor for this route
+ * @property {((values: string[]) => Object)|null} createParams - Builds params from captured values
  */
 
 /**
  * Creates a new trie node.
+ * @param {string} [prefix=""]
  * @returns {TrieNode}
  */
-function createNode() {
+function createNode(prefix = "") {
   return {
-    children: new Map(),
+    prefix,
+    children: [],
+    childCodes: [],
     paramChild: null,
     wildcardChild: null,
     paramName: null,
     route: null,
+    routePath: null,
+    paramNames: null,
+    Params: null,
+    createParams: null,
   };
 }
 
+/**
+ * Returns true when a request path must be normalized to match the
+ * `split("/").filter(Boolean)` semantics (repeated or trailing slashes).
+ * @param {string} path
+ * @returns {boolean}
+ */
+function needsNormalize(path) {
+  const len = path.length;
+  if (len === 0 || path.charCodeAt(0) !== 47) return true;
+  if (len > 1 && path.charCodeAt(len - 1) === 47) return true;
+  return path.indexOf("//") !== -1;
+}
+
+/**
+ * Collapses empty segments: "//a///b/" -> "/a/b".
+ * @param {string} path
+ * @returns {string}
+ */
+function normalizePath(path) {
+  return "/" + path.split("/").filter(Boolean).join("/");
+}
+
+/**
+ * Builds a fixed-shape constructor for a route's params object.
+ * Every match for the route allocates through the same constructor, so
+ * `req.params` keeps one hidden class and handler property reads stay
+ * monomorphic.
+ *
+ * @param {string[]} names
+ * @returns {{ Params: Function, createParams: (values: string[]) => Object }}
+ */
+function buildParams(names) {
+  const args = names.map((_, i) => `a${i}`);
+  const body = names
+    .map((name, i) => `this[${JSON.stringify(name)}] = a${i};`)
+    .join("\n");
+  const Params = new Function(...args, body);
+  const createParams = new Function(
+    "P",
+    `return function createParams(v) { return new P(${names.map((_, i) => `v[${i}]`).join(", ")}); };`,
+  )(Params);
+  return { Params, createParams };
+}
+
 /**
  * Route Trie class for efficient route matching.
  */
@@ -33,6 +92,10 @@ export class RouteTrie {
   constructor() {
     // Separate tries for each HTTP method
     this.methods = new Map();
+    // Scratch buffer for captured param values (matching is synchronous)
+    this._values = [];
+    // compile() output for matchCompiled(); dropped by every insert
+    this._compiled = null;
   }
 
   /**
@@ -54,43 +117,54 @@ export class RouteTrie {
    * @param {import("../vibe.js").VibeRoute} route - Route object
    */
   insert(method, path, route) {
+    this._compiled = null;
     const root = this.getMethodRoot(method);
     const segments = path.split("/").filter(Boolean);
-
-    // Handle root path
-    if (segments.length === 0) {
-      root.route = route;
-      return;
-    }
+    const names = [];
 
     let current = root;
+    let text = "";
+    let routePath = "";
 
     for (const segment of segments) {
       if (segment.startsWith(":")) {
         // Dynamic parameter segment
+        current = insertStatic(current, text + "/");
+        text = "";
         if (!current.paramChild) {
           current.paramChild = createNode();
           current.paramChild.paramName = segment.slice(1);
         }
         current = current.paramChild;
+        names.push(segment.slice(1));
       } else if (segment === "*") {
-        // Wildcard segment
+        // Wildcard segment (captures everything, break here)
+        current = insertStatic(current, text + "/");
+        text = "";
         if (!current.wildcardChild) {
           current.wildcardChild = createNode();
         }
         current = current.wildcardChild;
-        // Wildcard captures everything, break here
+        names.push("wildcard");
+        routePath += "/*";
         break;
       } else {
-        // Static segment
-        if (!current.children.has(segment)) {
-          current.children.set(segment, createNode());
-        }
-        current = current.children.get(segment);
+        // Static segment (compressed into the pending edge text)
+        text += "/" + segment;
       }
+      routePath += "/" + segment;
     }
 
+    // Handle root path
+    if (segments.length === 0) text = "/";
+    current = insertStatic(current, text);
+
+    const { Params, createParams } = buildParams(names);
     current.route = route;
+    current.routePath = routePath || "/";
+    current.paramNames = names;
+    current.Params = Params;
+    current.createParams = createParams;
   }
 
   /**
@@ -103,75 +177,50 @@ export class RouteTrie {
     const root = this.methods.get(method);
     if (!root) return null;
 
-    const segments = path.split("/").filter(Boolean);
-    const params = {};
+    if (needsNormalize(path)) path = normalizePath(path);
 
-    // Handle root path
-    if (segments.length === 0) {
-      if (root.route) {
-        return { route: root.route, params: {} };
-      }
-      return null;
-    }
+    const values = this._values;
+    const leaf = matchNode(root, path, 0, values, 0);
+    if (leaf === null) return null;
 
-    const result = this._matchRecursive(root, segments, 0, params);
-    return result;
+    return { route: leaf.route, params: leaf.createParams(values) };
   }
 
   /**
-   * Recursive matching helper.
-   * @param {TrieNode} node
-   * @param {string[]} segments
-   * @param {number} index
-   * @param {Record<string, string>} params
-   * @returns {{ route: import("../vibe.js").VibeRoute, params: Record<string, string> } | null}
+   * Compiles every method trie into a single generated matcher function.
+   * The generated code scans the pathname with charCodeAt, slices params
+   * in place and builds params through each route's fixed constructor —
+   * no segment arrays, no recursion, no object spreads on the hot path.
+   *
+   * Matching priority is identical to `match()`: static > param > wildcard,
+   * with backtracking when a deeper branch fails. Large subtrees are split
+   * into helper functions so V8 can still optimize them.
+   *
+   * @returns {(method: string, path: string) => { route: import("../vibe.js").VibeRoute, params: Record<string, string> } | null}
    */
-  _matchRecursive(node, segments, index, params) {
-    // Base case: all segments matched
-    if (index === segments.length) {
-      if (node.route) {
-        return { route: node.route, params: { ...params } };
-      }
-      return null;
-    }
-
-    const segment = segments[index];
-
-    // 1. Try static match first (highest priority)
-    if (node.children.has(segment)) {
-      const result = this._matchRecursive(
-        node.children.get(segment),
-        segments,
-        index + 1,
-        params,
-      );
-      if (result) return result;
-    }
-
-    // 2. Try parameter match
-    if (node.paramChild) {
-      const newParams = { ...params, [node.paramChild.paramName]: segment };
-      const result = this._matchRecursive(
-        node.paramChild,
-        segments,
-        index + 1,
-        newParams,
-      );
-      if (result) return result;
+  compile() {
+    const compiled = new Map();
+    for (const [method, root] of this.methods) {
+      compiled.set(method, compileMethod(root));
     }
 
-    // 3. Try wildcard match (lowest priority, captures rest)
-    if (node.wildcardChild) {
-      const remaining = segments.slice(index).join("/");
-      if (node.wildcardChild.route) {
-        return {
-          route: node.wildcardChild.route,
-          params: { ...params, wildcard: remaining },
-        };
-      }
-    }
+    return function compiledMatch(method, path) {
+      const fn = compiled.get(method);
+      if (fn === undefined) return null;
+      return fn(needsNormalize(path) ? normalizePath(path) : path);
+    };
+  }
 
-    return null;
+  /**
+   * Matches through the compile() matcher, rebuilding it first when a
+   * route was inserted since the last build (e.g. added after listen()).
+   * @param {string} method - HTTP method
+   * @param {string} path - Request path
+   * @returns {{ route: import("../vibe.js").VibeRoute, params: Record<string, string> } | null}
+   */
+  matchCompiled(method, path) {
+    if (this._compiled === null) this._compiled = this.compile();
+    return this._compiled(method, path);
   }
 
   /**
@@ -181,7 +230,7 @@ export class RouteTrie {
   getAllRoutes() {
     const routes = [];
     for (const [method, root] of this.methods) {
-      this._collectRoutes(root, "", method, routes);
+      this._collectRoutes(root, method, routes);
     }
     return routes;
   }
@@ -189,30 +238,245 @@ export class RouteTrie {
   /**
    * Helper to collect routes from trie.
    * @param {TrieNode} node
-   * @param {string} path
    * @param {string} method
    * @param {Array} routes
    */
-  _collectRoutes(node, path, method, routes) {
+  _collectRoutes(node, method, routes) {
     if (node.route) {
-      routes.push({ method, path: path || "/" });
+      routes.push({ method, path: node.routePath });
     }
 
-    for (const [segment, child] of node.children) {
-      this._collectRoutes(child, `${path}/${segment}`, method, routes);
+    for (const child of node.children) {
+      this._collectRoutes(child, method, routes);
     }
 
     if (node.paramChild) {
-      this._collectRoutes(
-        node.paramChild,
-        `${path}/:${node.paramChild.paramName}`,
-        method,
-        routes,
-      );
+      this._collectRoutes(node.paramChild, method, routes);
     }
 
     if (node.wildcardChild) {
-      this._collectRoutes(node.wildcardChild, `${path}/*`, method, routes);
+      this._collectRoutes(node.wildcardChild, method, routes);
     }
   }
 }
+
+/**
+ * Inserts static text below a node, splitting edges on partial overlap.
+ * @param {TrieNode} node
+ * @param {string} text
+ * @returns {TrieNode} Node that ends exactly at the end of `text`
+ */
+function insertStatic(node, text) {
+  while (text.length > 0) {
+    const idx = node.childCodes.indexOf(text.charCodeAt(0));
+
+    if (idx < 0) {
+      const child = createNode(text);
+      node.children.push(child);
+      node.childCodes.push(text.charCodeAt(0));
+      return child;
+    }
+
+    let child = node.children[idx];
+    const prefix = child.prefix;
+    const max = Math.min(prefix.length, text.length);
+    let common = 1;
+    while (common < max && prefix.charCodeAt(common) === text.charCodeAt(common)) {
+      common++;
+    }
+
+    // Split the edge: node -> mid(prefix[0..common]) -> child(rest)
+    if (common < prefix.length) {
+      const mid = createNode(prefix.slice(0, common));
+      child.prefix = prefix.slice(common);
+      mid.children.push(child);
+      mid.childCodes.push(child.prefix.charCodeAt(0));
+      node.children[idx] = mid;
+      child = mid;
+    }
+
+    node = child;
+    text = text.slice(common);
+  }
+  return node;
+}
+
+/**
+ * Recursive matching helper.
+ * Captured param values are written into `values` at index `n`.
+ *
+ * @param {TrieNode} node
+ * @param {string} path - Normalized request path
+ * @param {number} pos
+ * @param {string[]} values
+ * @param {number} n
+ * @returns {TrieNode | null} Matched leaf
+ */
+function matchNode(node, path, pos, values, n) {
+  const prefix = node.prefix;
+  if (prefix.length > 0) {
+    if (!path.startsWith(prefix, pos)) return null;
+    pos += prefix.length;
+  }
+
+  const len = path.length;
+
+  // Base case: whole path consumed
+  if (pos === len) return node.route ? node : null;
+
+  // 1. Try static match first (highest priority)
+  const codes = node.childCodes;
+  if (codes.length > 0) {
+    const code = path.charCodeAt(pos);
+    for (let i = 0; i < codes.length; i++) {
+      if (codes[i] === code) {
+        const leaf = matchNode(node.children[i], path, pos, values, n);
+        if (leaf !== null) return leaf;
+        break;
+      }
+    }
+  }
+
+  // 2. Try parameter match (one non-empty segment)
+  if (node.paramChild) {
+    let end = path.indexOf("/", pos);
+    if (end < 0) end = len;
+    if (end > pos) {
+      values[n] = path.slice(pos, end);
+      const leaf = matchNode(node.paramChild, path, end, values, n + 1);
+      if (leaf !== null) return leaf;
+    }
+  }
+
+  // 3. Try wildcard match (lowest priority, captures rest)
+  if (node.wildcardChild && node.wildcardChild.route) {
+    values[n] = path.slice(pos);
+    return node.wildcardChild;
+  }
+
+  return null;
+}
+
+/**
+ * Generated subtrees larger than this (in characters of source) are hoisted
+ * into their own function. V8 refuses to optimize very large functions, so
+ * one giant matcher for hundreds of routes would stay in the interpreter.
+ */
+const MAX_INLINE_SOURCE = 3000;
+
+/**
+ * Generates the matcher function for a single method trie.
+ * The returned function expects an already-normalized path.
+ * @param {TrieNode} root
+ * @returns {(path: string) => { route: import("../vibe.js").VibeRoute, params: Record<string, string> } | null}
+ */
+function compileMethod(root) {
+  const ctx = { leaves: [], fns: [] };
+  const body =
+    "const len = p.length;\n" +
+    generateNode(root, 0, "0", [], ctx) +
+    "return null;\n";
+
+  const source =
+    ctx.fns.join("\n") + `\nreturn function match(p) {\n${body}};`;
+  return new Function("R", "P", source)(
+    ctx.leaves.map((leaf) => leaf.route),
+    ctx.leaves.map((leaf) => leaf.Params),
+  );
+}
+
+/**
+ * Emits matcher code for one trie node.
+ * `pos` is the expression holding the offset where this node's prefix
+ * starts; `params` lists the variable names captured so far.
+ *
+ * @param {TrieNode} node
+ * @param {number} depth
+ * @param {string} pos
+ * @param {string[]} params
+ * @param {{ leaves: TrieNode[], fns: string[] }} ctx - Matched leaves and hoisted functions
+ * @returns {string}
+ */
+function generateNode(node, depth, pos, params, ctx) {
+  const s = `s${depth}`;
+  const prefix = node.prefix;
+  let code = "";
+  let close = "";
+
+  if (prefix.length === 1) {
+    code += `if (p.charCodeAt(${pos}) === ${prefix.charCodeAt(0)}) {\n`;
+    close = "}\n";
+  } else if (prefix.length > 1) {
+    code += `if (p.startsWith(${JSON.stringify(prefix)}, ${pos})) {\n`;
+    close = "}\n";
+  }
+  code += `const ${s} = ${pos} + ${prefix.length};\n`;
+
+  // Whole path consumed — endpoint check
+  if (node.route) {
+    code += `if (${s} === len) return ${emitMatch(node, params, ctx)};\n`;
+  }
+
+  const wildcard = node.wildcardChild;
+  const hasChildren =
+    node.children.length > 0 || node.paramChild || (wildcard && wildcard.route);
+
+  if (hasChildren) {
+    code += `if (${s} < len) {\n`;
+
+    // 1. Static children, dispatched on first char
+    if (node.children.length > 0) {
+      code += `switch (p.charCodeAt(${s})) {\n`;
+      for (let i = 0; i < node.children.length; i++) {
+        code += `case ${node.childCodes[i]}: {\n`;
+        code += generateChild(node.children[i], depth + 1, s, params, ctx);
+        code += "break;\n}\n";
+      }
+      code += "}\n";
+    }
+
+    // 2. Parameter child (one non-empty segment)
+    if (node.paramChild) {
+      const e = `e${depth}`;
+      const v = `v${depth}`;
+      code += `let ${e} = ${s};\n`;
+      code += `while (${e} < len && p.charCodeAt(${e}) !== 47) ${e}++;\n`;
+      code += `if (${e} > ${s}) {\n`;
+      code += `const ${v} = p.slice(${s}, ${e});\n`;
+      code += generateChild(node.paramChild, depth + 1, e, params.concat(v), ctx);
+      code += "}\n";
+    }
+
+    // 3. Wildcard (captures the rest of the path)
+    if (wildcard && wildcard.route) {
+      code += `return ${emitMatch(wildcard, params.concat(`p.slice(${s})`), ctx)};\n`;
+    }
+
+    code += "}\n";
+  }
+
+  return code + close;
+}
+
+/**
+ * Emits a child subtree inline, or hoists it into a separate function
+ * (called with the current offset and captured params) when it is large.
+ */
+function generateChild(child, depth, pos, params, ctx) {
+  const code = generateNode(child, depth, pos, params, ctx);
+  if (code.length <= MAX_INLINE_SOURCE) return code;
+
+  const name = `m${ctx.fns.length}`;
+  const args = ["p", "len", pos, ...params].join(", ");
+  ctx.fns.push(`function ${name}(${args}) {\n${code}return null;\n}`);
+  return `{ const r = ${name}(${args}); if (r !== null) return r; }\n`;
+}
+
+/**
+ * Emits a `{ route, params }` expression for a matched leaf.
+ */
+function emitMatch(leaf, params, ctx) {
+  let idx = ctx.leaves.indexOf(leaf);
+  if (idx < 0) idx = ctx.leaves.push(leaf) - 1;
+  return `{ route: R[${idx}], params: new P[${idx}](${params.join(", ")}) }`;
+}
@@ -0,0 +1,365 @@
+/**
+ * Upload sinks for multipart file uploads.
+ *
+ * A sink decides where the bytes of an uploaded file go. The parser pipes
+ * each busboy file stream straight into the sink's Writable, so chunks are
+ * never copied or collected, and a slow sink slows the client down through
+ * backpressure. Size and an optional hash are computed inline on the way.
+ *
+ * Built-in sinks: disk (default), S3-style multipart, and any Writable.
+ *
+ * @module upload-sinks
+ */
+import fs from "fs";
+import path from "path";
+import crypto from "crypto";
+import { Writable, finished } from "stream";
+
+/**
+ * What the parser knows about a file when the sink is opened
+ * @typedef {Object} UploadInfo
+ * @property {string} field - Form field name
+ * @property {string} filename - Original filename from the client
+ * @property {string} mimeType
+ */
+
+/**
+ * An opened upload: the stream receives the bytes, commit() runs once
+ * they are all written, abort() when the upload fails or is too large.
+ * @typedef {Object} UploadTarget
+ * @property {NodeJS.WritableStream} stream
+ * @property {() => Promise<Object> | Object} [commit] - Extra fields for req.files
+ * @property {(err: Error) => Promise<void> | void} [abort]
+ */
+
+/**
+ * @typedef {Object} UploadSink
+ * @property {(info: UploadInfo) => Promise<UploadTarget> | UploadTarget} open
+ */
+
+// ==========================================
+// Disk
+// ==========================================
+
+// Directories already created, shared by every route and request
+const dirs = new Map();
+
+/**
+ * mkdir -p, once per directory for the life of the process
+ * @param {string} dir - Absolute path
+ * @returns {Promise<void>}
+ */
+export function ensureDir(dir) {
+  let ready = dirs.get(dir);
+  if (!ready) {
+    ready = fs.promises.mkdir(dir, { recursive: true }).then(
+      () => {},
+      (err) => {
+        dirs.delete(dir);
+        throw err;
+      },
+    );
+    dirs.set(dir, ready);
+  }
+  return ready;
+}
+
+function uniqueName(filename, mimeType) {
+  const ext =
+    path.extname(filename) ||
+    (mimeType?.includes("/") ? "." + mimeType.split("/")[1] : "");
+  return `${path.basename(filename, ext)}-${crypto
+    .randomBytes(3)
+    .toString("hex")}${ext}`;
+}
+
+/**
+ * Open a new file exclusively ("wx"), creating the directory on first use
+ * and again if it was removed since.
+ */
+async function openUnique(dir, info) {
+  await ensureDir(dir);
+  for (let attempt = 0; ; attempt++) {
+    const filename = uniqueName(info.filename, info.mimeType);
+    const filePath = path.join(dir, filename);
+    try {
+      const handle = await fs.promises.open(filePath, "wx");
+      return { filename, filePath, handle };
+    } catch (err) {
+      if (attempt >= 3) throw err;
+      if (err.code === "ENOENT") {
+        dirs.delete(dir);
+        await ensureDir(dir);
+      } else if (err.code !== "EEXIST") {
+        throw err;
+      }
+    }
+  }
+}
+
+/**
+ * Write uploads into a directory under a unique, collision-free name.
+ * @param {{ dir: string }} options - Absolute target directory
+ * @returns {UploadSink}
+ */
+export function diskSink({ dir }) {
+  return {
+    async open(info) {
+      const { filename, filePath, handle } = await openUnique(dir, info);
+      return {
+        stream: handle.createWriteStream(),
+        commit: () => ({ filename, filePath }),
+        abort: () => fs.promises.unlink(filePath).catch(() => {}),
+      };
+    },
+  };
+}
+
+// ==========================================
+// S3-style multipart
+// ==========================================
+
+/**
+ * Object-store client for multipart uploads (S3, GCS, R2, ...)
+ * @typedef {Object} MultipartClient
+ * @property {(info: UploadInfo) => Promise<any>} create - Start an upload, returns its handle
+ * @property {(upload: any, partNumber: number, body: Buffer) => Promise<any>} uploadPart - Returns the part ETag
+ * @property {(upload: any, parts: { partNumber: number, etag: any }[]) => Promise<Object | void>} complete
+ * @property {(upload: any) => Promise<void>} [abort]
+ */
+
+/**
+ * Upload files as fixed-size parts to an object store. At most `queueSize`
+ * parts are in flight per file; further writes wait, which holds the
+ * client back instead of buffering the file in memory.
+ *
+ * @param {MultipartClient} client
+ * @param {{ partSize?: number, queueSize?: number }} [options]
+ * @returns {UploadSink}
+ */
+export function multipartSink(client, options = {}) {
+  const partSize = options.partSize || 5 * 1024 * 1024;
+  const queueSize = options.queueSize || 4;
+
+  return {
+    async open(info) {
+      const upload = await client.create(info);
+      const parts = [];
+      const inflight = new Set();
+      let buffered = [];
+      let bufferedSize = 0;
+      let failed = null;
+
+      // Cut the next part (exactly partSize bytes unless it is the last)
+      // off the buffered chunks; slices of one chunk are not copied
+      const takePart = (n) => {
+        if (buffered[0].length >= n) {
+          const body = buffered[0].subarray(0, n);
+          buffered[0] = buffered[0].subarray(n);
+          if (buffered[0].length === 0) buffered.shift();
+          bufferedSize -= n;
+          return body;
+        }
+        const body = Buffer.allocUnsafe(n);
+        let at = 0;
+        while (at < n) {
+          const chunk = buffered[0];
+          const take = Math.min(chunk.length, n - at);
+          chunk.copy(body, at, 0, take);
+          at += take;
+          if (take === chunk.length) buffered.shift();
+          else buffered[0] = chunk.subarray(take);
+        }
+        bufferedSize -= n;
+        return body;
+      };
+
+      const sendPart = (n) => {
+        const body = n === 0 ? Buffer.alloc(0) : takePart(n);
+        const partNumber = parts.length + inflight.size + 1;
+        const sent = client.uploadPart(upload, partNumber, body).then(
+          (etag) => {
+            parts.push({ partNumber, etag });
+            inflight.delete(sent);
+          },
+          (err) => {
+            failed ||= err;
+            inflight.delete(sent);
+          },
+        );
+        inflight.add(sent);
+      };
+
+      // Resolves once a slot is free (or everything is sent)
+      const settle = async (all) => {
+        while (inflight.size > (all ? 0 : queueSize - 1)) {
+          await Promise.race(inflight);
+        }
+        if (failed) throw failed;
+      };
+
+      const stream = new Writable({
+        highWaterMark: partSize,
+        write(chunk, encoding, callback) {
+          if (failed) return callback(failed);
+          buffered.push(chunk);
+          bufferedSize += chunk.length;
+          if (bufferedSize < partSize) return callback();
+          (async () => {
+            while (bufferedSize >= partSize) {
+              sendPart(partSize);
+              await settle(false);
+            }
+          })().then(() => callback(), callback);
+        },
+        final(callback) {
+          // The remainder, or one empty part for an empty file
+          if (bufferedSize > 0 || parts.length + inflight.size === 0) {
+            sendPart(bufferedSize);
+          }
+          settle(true).then(() => callback(), callback);
+        },
+      });
+
+      return {
+        stream,
+        async commit() {
+          parts.sort((a, b) => a.partNumber - b.partNumber);
+          return (await client.complete(upload, parts)) || {};
+        },
+        async abort() {
+          await Promise.allSettled(inflight);
+          await client.abort?.(upload);
+        },
+      };
+    },
+  };
+}
+
+// ==========================================
+// Any Writable
+// ==========================================
+
+/**
+ * Hand each file to a Writable created by the application
+ * @param {(info: UploadInfo) => NodeJS.WritableStream | Promise<NodeJS.WritableStream>} create
+ * @returns {UploadSink}
+ */
+export function writableSink(create) {
+  return {
+    async open(info) {
+      return { stream: await create(info) };
+    },
+  };
+}
+
+// ==========================================
+// Concurrency
+// ==========================================
+
+/**
+ * Counting semaphore: at most `max` holders at a time, the rest wait in
+ * arrival order.
+ * @param {number} max
+ */
+export function createLimiter(max) {
+  let active = 0;
+  const waiting = [];
+
+  const release = () => {
+    const next = waiting.shift();
+    if (next) next(release);
+    else active--;
+  };
+
+  return {
+    /** @returns {Promise<() => void>} Resolves with the release function */
+    acquire() {
+      if (active < max) {
+        active++;
+        return Promise.resolve(release);
+      }
+      return new Promise((resolve) => waiting.push(resolve));
+    },
+    get active() {
+      return active;
+    },
+    get waiting() {
+      return waiting.length;
+    },
+  };
+}
+
+// ==========================================
+// Pipeline
+// ==========================================
+
+/**
+ * Store one uploaded file through a sink.
+ * Must be called synchronously from busboy's "file" event so a size limit
+ * hit while waiting for a concurrency slot is not missed.
+ *
+ * @param {NodeJS.ReadableStream} file - busboy file stream
+ * @param {UploadInfo} info
+ * @param {{ sink: UploadSink, hash?: string, limiter?: ReturnType<typeof createLimiter>, maxSize: number }} store
+ * @returns {Promise<import("../../vibe.js").UploadedFile>}
+ */
+export function storeUpload(file, info, store) {
+  let limited = false;
+  file.once("limit", () => (limited = true));
+  file.pause(); // nothing may flow before the sink is attached
+
+  const tooLarge = () =>
+    new Error(
+      `File '${info.filename}' exceeds max size of ${store.maxSize} bytes`,
+    );
+
+  return (async () => {
+    // The file stays paused while waiting, which backs up the socket
+    const release = store.limiter ? await store.limiter.acquire() : null;
+    let target = null;
+    let size = 0;
+
+    try {
+      target = await store.sink.open(info);
+      const out = target.stream;
+      const digest = store.hash ? crypto.createHash(store.hash) : null;
+
+      await new Promise((resolve, reject) => {
+        file.on("data", (chunk) => {
+          size += chunk.length;
+          if (digest) digest.update(chunk);
+        });
+        file.once("error", reject);
+        finished(out, (err) => (err ? reject(err) : resolve()));
+        file.pipe(out);
+      });
+      if (limited || file.truncated) throw tooLarge();
+
+      const record = {
+        filename: info.filename,
+        originalName: info.filename,
+        type: info.mimeType,
+        size,
+        ...(await target.commit?.()),
+      };
+      if (digest) record.hash = digest.digest("hex");
+      return record;
+    } catch (err) {
+      // Drain what is left so busboy can move on to the next part
+      file.unpipe();
+      file.resume();
+      if (target) {
+        target.stream.destroy();
+        try {
+          await target.abort?.(err);
+        } catch {
+          // Cleanup is best effort; report the original failure
+        }
+      }
+      throw limited || file.truncated ? tooLarge() : err;
+    } finally {
+      release?.();
+    }
+  })();
+}
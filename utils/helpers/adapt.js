@@ -42,60 +42,81 @@ export function adapt(mw) {
 
 /**
  * Optimized Express-style adapter
- * Uses callback pattern, only creates Promise when necessary
+ * Synchronous when next() is called before the middleware returns (the
+ * common case); only a deferred next() costs a Promise
  */
 function adaptExpress(mw) {
   return (req, res) => {
-    return new Promise((resolve) => {
-      try {
-        mw(req, res, (err) => {
-          if (err) {
-            handleError(err, res);
-            resolve(false);
-          } else {
-            resolve(true);
-          }
-        });
-      } catch (err) {
+    let outcome; // true: next(), false: next(err) or throw
+    let settle = null;
+    const next = (err) => {
+      if (outcome !== undefined) return;
+      if (err) handleError(err, res);
+      outcome = !err;
+      if (settle !== null) settle(outcome);
+    };
+    try {
+      mw(req, res, next);
+    } catch (err) {
+      if (outcome === undefined) {
         handleError(err, res);
-        resolve(false);
+        outcome = false;
       }
+    }
+    if (outcome !== undefined) return outcome;
+    return new Promise((resolve) => {
+      settle = resolve;
     });
   };
 }
 
 /**
  * Optimized async middleware adapter
+ * Chains onto the middleware's own promise instead of wrapping it
  */
 function adaptAsync(mw) {
-  return async (req, res) => {
+  return (req, res) => {
+    let result;
     try {
-      await mw(req, res);
-      return true;
+      result = mw(req, res);
     } catch (err) {
       handleError(err, res);
       return false;
     }
+    return Promise.resolve(result).then(
+      () => true,
+      (err) => {
+        handleError(err, res);
+        return false;
+      },
+    );
   };
 }
 
 /**
  * Optimized sync middleware adapter
- * Only awaits if result is a Promise
+ * Returns synchronously unless the middleware returns a Promise
  */
 function adaptSync(mw) {
-  return async (req, res) => {
+  return (req, res) => {
+    let result;
     try {
-      const result = mw(req, res);
-      // Only await if it's a Promise (duck typing for speed)
-      if (result && typeof result.then === "function") {
-        await result;
-      }
-      return true;
+      result = mw(req, res);
     } catch (err) {
       handleError(err, res);
       return false;
     }
+    // Only chain if it's a Promise (duck typing for speed)
+    if (result && typeof result.then === "function") {
+      return result.then(
+        () => true,
+        (err) => {
+          handleError(err, res);
+          return false;
+        },
+      );
+    }
+    return true;
   };
 }
 
@@ -0,0 +1,71 @@
+// utils/helpers/deque.js
+
+/**
+ * Double-ended queue on a power-of-two ring buffer.
+ * push/shift/pop are O(1) and allocation-free until the ring has to grow,
+ * unlike Array#shift which moves every remaining element.
+ */
+export class Deque {
+  /**
+   * @param {number} [capacity=16] - Initial slots (rounded up to a power of two)
+   */
+  constructor(capacity = 16) {
+    let size = 4;
+    while (size < capacity) size <<= 1;
+    this.buf = new Array(size);
+    this.mask = size - 1;
+    this.head = 0;
+    this.length = 0;
+  }
+
+  /** Append at the back */
+  push(item) {
+    if (this.length === this.buf.length) this._grow();
+    this.buf[(this.head + this.length) & this.mask] = item;
+    this.length++;
+  }
+
+  /** Remove from the front (oldest first) */
+  shift() {
+    if (this.length === 0) return undefined;
+    const item = this.buf[this.head];
+    this.buf[this.head] = undefined;
+    this.head = (this.head + 1) & this.mask;
+    this.length--;
+    return item;
+  }
+
+  /** Remove from the back (newest first) */
+  pop() {
+    if (this.length === 0) return undefined;
+    const i = (this.head + this.length - 1) & this.mask;
+    const item = this.buf[i];
+    this.buf[i] = undefined;
+    this.length--;
+    return item;
+  }
+
+  /** Oldest item without removing it */
+  peek() {
+    return this.length === 0 ? undefined : this.buf[this.head];
+  }
+
+  _grow() {
+    const old = this.buf;
+    const next = new Array(old.length * 2);
+    for (let i = 0; i < this.length; i++) {
+      next[i] = old[(this.head + i) & this.mask];
+    }
+    this.buf = next;
+    this.mask = next.length - 1;
+    this.head = 0;
+  }
+
+  *[Symbol.iterator]() {
+    for (let i = 0; i < this.length; i++) {
+      yield this.buf[(this.head + i) & this.mask];
+    }
+  }
+}
+
+export default Deque;
@@ -0,0 +1,159 @@
+// utils/helpers/histogram.js
+
+/**
+ * Fixed-memory latency histogram.
+ * Values are stored in microsecond buckets: 8 linear sub-buckets per power
+ * of two, so any percentile is within ~6% of the true value. Recording is
+ * O(1) and never allocates, which keeps it safe on hot paths.
+ *
+ * More sub-buckets trade memory for precision (HdrHistogram-style): 7 bits
+ * (128 per power of two, ~37 KB) keeps percentiles within ~0.4%, enough
+ * for p99.9 in benchmarks. Only histograms of equal precision merge.
+ */
+
+const SUB_BITS = 3;
+const MAX_EXPONENT = 36; // 2^36 µs ≈ 19 hours
+
+// `sub`: sub-buckets per power of two
+function bucketOf(micros, sub) {
+  if (micros < sub) return micros < 0 ? 0 : Math.floor(micros);
+  const exp = Math.min(Math.floor(Math.log2(micros)), MAX_EXPONENT);
+  const i = Math.min(Math.floor((micros / 2 ** exp - 1) * sub), sub - 1);
+  return exp * sub + i;
+}
+
+// Midpoint of a bucket, in microseconds
+function valueOf(index, sub) {
+  if (index < sub) return index;
+  const exp = Math.floor(index / sub);
+  return 2 ** exp * (1 + ((index % sub) + 0.5) / sub);
+}
+
+export class Histogram {
+  /**
+   * @param {number} [subBits=3] - log2 of the sub-buckets per power of two
+   */
+  constructor(subBits = SUB_BITS) {
+    this.subBuckets = 1 << subBits;
+    this.counts = new Float64Array((MAX_EXPONENT + 1) * this.subBuckets);
+    this.count = 0;
+    this.sum = 0;
+    this.max = 0;
+  }
+
+  /**
+   * @param {number} ms - Duration in milliseconds
+   */
+  record(ms) {
+    this.counts[bucketOf(ms * 1000, this.subBuckets)]++;
+    this.count++;
+    this.sum += ms;
+    if (ms > this.max) this.max = ms;
+  }
+
+  /**
+   * @param {number} p - Percentile, 0-100
+   * @returns {number} Milliseconds (0 when empty)
+   */
+  percentile(p) {
+    if (this.count === 0) return 0;
+    const rank = Math.max(1, Math.ceil((p / 100) * this.count));
+    let seen = 0;
+    const counts = this.counts;
+    for (let i = 0; i < counts.length; i++) {
+      seen += counts[i];
+      if (seen >= rank) {
+        return Math.min(valueOf(i, this.subBuckets) / 1000, this.max);
+      }
+    }
+    return this.max;
+  }
+
+  /** @returns {number} Mean in milliseconds */
+  get mean() {
+    return this.count === 0 ? 0 : this.sum / this.count;
+  }
+
+  /**
+   * Add another histogram's samples into this one
+   * @param {Histogram | { counts: ArrayLike<number>, count: number, sum: number, max: number }} other
+   */
+  merge(other) {
+    const counts = this.counts;
+    for (let i = 0; i < counts.length; i++) counts[i] += other.counts[i];
+    this.count += other.count;
+    this.sum += other.sum;
+    if (other.max > this.max) this.max = other.max;
+  }
+
+  /**
+   * Samples at or below each bound (cumulative, as Prometheus `le` buckets).
+   * A bucket only counts once it lies wholly below the bound, so counts
+   * err low by at most one sub-bucket (~6%).
+   * @param {number[]} boundsMs - Ascending, in milliseconds
+   * @returns {number[]}
+   */
+  cumulative(boundsMs) {
+    const out = new Array(boundsMs.length);
+    let seen = 0;
+    let i = 0;
+    for (let b = 0; b < boundsMs.length; b++) {
+      const end = bucketOf(boundsMs[b] * 1000, this.subBuckets);
+      for (; i < end; i++) seen += this.counts[i];
+      out[b] = seen;
+    }
+    return out;
+  }
+
+  /**
+   * Compact copy for IPC: non-empty buckets as [index, count] pairs
+   * @returns {{ buckets: number[], count: number, sum: number, max: number }}
+   */
+  sparse() {
+    const buckets = [];
+    const counts = this.counts;
+    for (let i = 0; i < counts.length; i++) {
+      if (counts[i] !== 0) buckets.push(i, counts[i]);
+    }
+    return { buckets, count: this.count, sum: this.sum, max: this.max };
+  }
+
+  /**
+   * Add samples received from sparse()
+   * @param {{ buckets: number[], count: number, sum: number, max: number }} other
+   */
+  mergeSparse(other) {
+    const buckets = other.buckets;
+    for (let i = 0; i < buckets.length; i += 2) {
+      this.counts[buckets[i]] += buckets[i + 1];
+    }
+    this.count += other.count;
+    this.sum += other.sum;
+    if (other.max > this.max) this.max = other.max;
+  }
+
+  reset() {
+    this.counts.fill(0);
+    this.count = 0;
+    this.sum = 0;
+    this.max = 0;
+  }
+
+  /**
+   * Summary for stats endpoints (milliseconds, 3 decimals)
+   * @returns {{ count: number, mean: number, p50: number, p90: number, p99: number, max: number }}
+   */
+  toJSON() {
+    const r = (v) => Math.round(v * 1000) / 1000;
+    return {
+      count: this.count,
+      mean: r(this.mean),
+      p50: r(this.percentile(50)),
+      p90: r(this.percentile(90)),
+      p99: r(this.percentile(99)),
+      max: r(this.max),
+    };
+  }
+}
+
+export default Histogram;
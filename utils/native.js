@@ -28,32 +28,86 @@ export function parseUrl(url) {
   return { pathname, query };
 }
 
+// Escape flags collected while scanning a key or value
+const ESC_PERCENT = 1;
+const ESC_PLUS = 2;
+
+/**
+ * Decode `qs.slice(start, end)` as a query component. Clean slices (the
+ * common case) are returned as-is; `+` becomes a space and `%XX` escapes
+ * are decoded only when the scan saw them. Malformed escapes keep the raw
+ * text.
+ * @param {string} qs
+ * @param {number} start
+ * @param {number} end
+ * @param {number} escapes - Flags from the scan (0: nothing to decode)
+ * @returns {string}
+ */
+export function decodeComponent(qs, start, end, escapes) {
+  let s = qs.slice(start, end);
+  if (escapes === 0) return s;
+  if ((escapes & ESC_PLUS) !== 0) s = s.replaceAll("+", " ");
+  if ((escapes & ESC_PERCENT) !== 0) {
+    try {
+      return decodeURIComponent(s);
+    } catch {
+      // Invalid encoding, use raw
+    }
+  }
+  return s;
+}
+
 /**
- * Parse query string into object
+ * Parse query string into object.
+ *
+ * One charCodeAt pass records where each key and value starts and ends
+ * and whether it holds `%` or `+`; only those slices are decoded. A
+ * repeated key collects its values into an array, and a key without `=`
+ * (`?debug`) is kept with the value "".
  * @param {string} queryString - Query string (with or without leading ?)
- * @returns {Object} Parsed query parameters
+ * @returns {Record<string, string | string[]>} Parsed query parameters
  */
 export function parseQuery(queryString) {
   const query = {};
   if (!queryString) return query;
 
-  let qs = queryString;
-  if (qs[0] === "?") {
-    qs = qs.slice(1);
-  }
+  const qs = queryString;
+  const len = qs.length;
+  let start = qs.charCodeAt(0) === 63 ? 1 : 0; // "?"
+  let eq = -1;
+  let keyEsc = 0;
+  let valueEsc = 0;
 
-  const pairs = qs.split("&");
-  for (const pair of pairs) {
-    const eq = pair.indexOf("=");
-    if (eq > 0) {
-      try {
-        const key = decodeURIComponent(pair.slice(0, eq));
-        const value = decodeURIComponent(pair.slice(eq + 1));
-        query[key] = value;
-      } catch {
-        // Invalid encoding, use raw
-        query[pair.slice(0, eq)] = pair.slice(eq + 1);
+  for (let i = start; i <= len; i++) {
+    const c = i < len ? qs.charCodeAt(i) : 38;
+    if (c === 38) {
+      // "&": end of pair (empty pairs and empty keys are skipped)
+      const keyEnd = eq < 0 ? i : eq;
+      if (keyEnd > start) {
+        const key = decodeComponent(qs, start, keyEnd, keyEsc);
+        const value = eq < 0 ? "" : decodeComponent(qs, eq + 1, i, valueEsc);
+        const prev = query[key];
+        if (prev === undefined || !Object.hasOwn(query, key)) {
+          query[key] = value;
+        } else if (typeof prev === "string") {
+          query[key] = [prev, value];
+        } else {
+          prev.push(value);
+        }
       }
+      start = i + 1;
+      eq = -1;
+      keyEsc = 0;
+      valueEsc = 0;
+    } else if (c === 61) {
+      // "=": the first one splits key and value
+      if (eq < 0) eq = i;
+    } else if (c === 37) {
+      if (eq < 0) keyEsc |= ESC_PERCENT;
+      else valueEsc |= ESC_PERCENT;
+    } else if (c === 43) {
+      if (eq < 0) keyEsc |= ESC_PLUS;
+      else valueEsc |= ESC_PLUS;
     }
   }
 
@@ -89,6 +143,7 @@ export default {
   stringify,
   parseUrl,
   parseQuery,
+  decodeComponent,
   decodeURI,
   isNativeEnabled,
   getNativeVersion,
@@ -0,0 +1,202 @@
+/**
+ * Adaptive Admission Control
+ * Sheds load before it queues up: a request is admitted only while fewer
+ * than `limit` requests are in flight, and the limit follows observed
+ * latency instead of being a fixed guess (after Netflix concurrency-limits).
+ *
+ * - "gradient": compares each latency sample with its long-term average and
+ *   shrinks the limit as latency rises above it.
+ * - "aimd": adds one while latency stays under `timeout`, multiplies by
+ *   `backoff` when it does not.
+ *
+ * Both treat a stalled event loop (p99 delay above `maxEventLoopDelay`) as
+ * overload, which catches CPU saturation before latency samples arrive.
+ */
+import { monitorEventLoopDelay } from "perf_hooks";
+
+/**
+ * Admission controller configuration
+ * @typedef {Object} AdmissionOptions
+ * @property {"gradient" | "aimd"} [algorithm="gradient"] - Limit algorithm
+ * @property {number} [initialLimit=20] - Starting concurrency limit
+ * @property {number} [minLimit=1] - Lowest limit
+ * @property {number} [maxLimit=1000] - Highest limit
+ * @property {number} [timeout=2000] - aimd: latency (ms) counted as overload
+ * @property {number} [backoff=0.9] - Multiplier applied on overload
+ * @property {number} [tolerance=1.5] - gradient: latency ratio tolerated before shrinking
+ * @property {number} [smoothing=0.2] - gradient: weight of each new limit
+ * @property {number} [maxEventLoopDelay=100] - p99 event-loop delay (ms) counted as overload (0: off)
+ * @property {number} [status=503] - Status for shed requests (503 or 429)
+ * @property {number} [retryAfter=1] - Retry-After seconds for shed requests
+ */
+
+// Samples averaged into the long-term latency (gradient)
+const LONG_WINDOW = 600;
+// Samples before the long-term average is trusted
+const WARMUP = 10;
+// How often the event-loop delay is read
+const LOOP_SAMPLE_MS = 500;
+
+/**
+ * Concurrency limiter with a latency-driven limit
+ */
+export class AdmissionController {
+  /**
+   * @param {AdmissionOptions} [options]
+   */
+  constructor(options = {}) {
+    this.algorithm = options.algorithm || "gradient";
+    if (this.algorithm !== "gradient" && this.algorithm !== "aimd") {
+      throw new Error(`Unknown admission algorithm "${this.algorithm}"`);
+    }
+    this.minLimit = options.minLimit || 1;
+    this.maxLimit = options.maxLimit || 1000;
+    this.limit = Math.min(
+      Math.max(options.initialLimit || 20, this.minLimit),
+      this.maxLimit,
+    );
+    this.timeout = options.timeout || 2000;
+    this.backoff = options.backoff || 0.9;
+    this.tolerance = options.tolerance || 1.5;
+    this.smoothing = options.smoothing || 0.2;
+    this.status = options.status || 503;
+    this.retryAfter = options.retryAfter || 1;
+
+    this.inflight = 0;
+    this.admitted = 0;
+    this.shed = 0;
+
+    // Latency (ms)
+    this.longRtt = 0;
+    this.samples = 0;
+    this.lastRtt = 0;
+
+    // Event loop
+    this.maxEventLoopDelay = options.maxEventLoopDelay ?? 100;
+    this.eventLoopDelay = 0;
+    this.overloaded = false;
+    this._loop = null;
+    this._loopTimer = null;
+    if (this.maxEventLoopDelay > 0) {
+      this._loop = monitorEventLoopDelay({ resolution: 10 });
+      this._loop.enable();
+      this._loopTimer = setInterval(() => this._sampleLoop(), LOOP_SAMPLE_MS);
+      this._loopTimer.unref();
+    }
+  }
+
+  _sampleLoop() {
+    // Delay beyond the timer resolution, in ms
+    this.eventLoopDelay = Math.max(0, this._loop.percentile(99) / 1e6 - 10);
+    this._loop.reset();
+    this.overloaded = this.eventLoopDelay > this.maxEventLoopDelay;
+  }
+
+  /**
+   * Claim a slot for a request
+   * @returns {number} Start time to pass to release(), or -1 when shed
+   */
+  acquire() {
+    if (this.inflight >= Math.floor(this.limit)) {
+      this.shed++;
+      return -1;
+    }
+    this.inflight++;
+    this.admitted++;
+    return performance.now();
+  }
+
+  /**
+   * Return a slot and feed its latency into the limit
+   * @param {number} start - Value returned by acquire()
+   * @param {boolean} [sample=true] - false for requests that say nothing about load (client aborts)
+   */
+  release(start, sample = true) {
+    const inflight = this.inflight--;
+    if (!sample) return;
+    const rtt = performance.now() - start;
+    this.lastRtt = rtt;
+    this.limit =
+      this.algorithm === "aimd"
+        ? this._aimd(rtt, inflight)
+        : this._gradient(rtt, inflight);
+  }
+
+  _clamp(limit) {
+    return Math.min(Math.max(limit, this.minLimit), this.maxLimit);
+  }
+
+  _aimd(rtt, inflight) {
+    if (this.overloaded || rtt > this.timeout) {
+      return this._clamp(Math.floor(this.limit * this.backoff));
+    }
+    // Only grow when the limit is actually being used
+    if (inflight * 2 >= this.limit) return this._clamp(this.limit + 1);
+    return this.limit;
+  }
+
+  _gradient(rtt, inflight) {
+    // Long-term average: plain mean while warming up, then exponential
+    this.samples++;
+    if (this.samples <= WARMUP) {
+      this.longRtt += (rtt - this.longRtt) / this.samples;
+      return this.limit;
+    }
+    this.longRtt += (rtt - this.longRtt) * (2 / (LONG_WINDOW + 1));
+
+    if (this.overloaded) {
+      return this._clamp(this.limit * this.backoff);
+    }
+    // Too few requests in flight to learn anything about the limit
+    if (inflight < this.limit / 2) return this.limit;
+
+    // Latency dropped well below the average (load went away): let the
+    // average catch up instead of holding the limit down
+    if (this.longRtt / rtt > 2) this.longRtt *= 0.95;
+
+    const gradient = Math.max(
+      0.5,
+      Math.min(1, (this.tolerance * this.longRtt) / Math.max(rtt, 1e-3)),
+    );
+    const queueSize = Math.sqrt(this.limit);
+    const next = this.limit * gradient + queueSize;
+    return this._clamp(
+      this.limit * (1 - this.smoothing) + next * this.smoothing,
+    );
+  }
+
+  /** Stop sampling the event loop */
+  close() {
+    clearInterval(this._loopTimer);
+    this._loop?.disable();
+  }
+
+  /**
+   * Current limit and counters (latency in milliseconds)
+   */
+  get stats() {
+    const r = (v) => Math.round(v * 1000) / 1000;
+    return {
+      algorithm: this.algorithm,
+      limit: Math.floor(this.limit),
+      inflight: this.inflight,
+      admitted: this.admitted,
+      shed: this.shed,
+      rtt: r(this.lastRtt),
+      longRtt: r(this.longRtt),
+      eventLoopDelay: r(this.eventLoopDelay),
+      overloaded: this.overloaded,
+    };
+  }
+}
+
+/**
+ * Create an admission controller
+ * @param {AdmissionOptions} [options]
+ * @returns {AdmissionController}
+ */
+export function createAdmission(options) {
+  return new AdmissionController(options);
+}
+
+export default AdmissionController;
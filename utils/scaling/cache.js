@@ -2,24 +2,124 @@
  * LRU Cache for Response Caching
  * Efficient caching with TTL and max size limits
  */
+import http from "http";
 
 /**
  * Cache entry
  * @typedef {Object} CacheEntry
- * @property {any} value - Cached value
+ * @property {any} value - Cached value (a Buffer body when set by cacheMiddleware)
  * @property {number} expires - Expiration timestamp
  * @property {string} etag - ETag for conditional requests
+ * @property {string} [contentType] - Content-Type of a cached body
  */
 
 /**
  * Cache options
  * @typedef {Object} CacheOptions
  * @property {number} [max=1000] - Maximum number of entries
+ * @property {number} [maxBytes=Infinity] - Byte budget over stored value sizes
  * @property {number} [ttl=60000] - Default TTL in milliseconds
+ * @property {number} [sweepInterval=1000] - Expiry bucket width / sweep period (ms)
+ * @property {"lru" | "tinylfu"} [admission="lru"] - "tinylfu" only admits a new
+ *   key over the LRU victim when it has been requested at least as often
  */
 
+/**
+ * Middleware counters (see cacheMiddleware)
+ * @typedef {Object} CacheStats
+ * @property {number} hits - Served from a fresh entry
+ * @property {number} misses - Ran the handler to fill the cache
+ * @property {number} stale - Served an expired entry inside the stale window
+ * @property {number} coalesced - Waited on another request's in-flight handler
+ */
+
+/**
+ * @returns {CacheStats}
+ */
+export function createCacheStats() {
+  return { hits: 0, misses: 0, stale: 0, coalesced: 0 };
+}
+
+/**
+ * Stats of every cache behind a cacheMiddleware (summed into app metrics)
+ * @type {Set<CacheStats>}
+ */
+export const cacheStatsRegistry = new Set();
+
+/**
+ * Approximate access counts for TinyLFU admission.
+ * Count-min sketch with 4 rows of 4-bit-saturating counters in one
+ * Uint8Array; all counters are halved periodically so old popularity fades.
+ */
+class FrequencySketch {
+  /**
+   * @param {number} capacity - Expected number of cached entries
+   */
+  constructor(capacity) {
+    // Small tables saturate under scans; 1 KB is the floor
+    let width = 1024;
+    while (width < capacity * 4) width <<= 1;
+    this.mask = width - 1;
+    this.table = new Uint8Array(width);
+    this.additions = 0;
+    this.resetAt = capacity * 10;
+  }
+
+  static hash(key) {
+    let hash = 0x811c9dc5;
+    for (let i = 0; i < key.length; i++) {
+      hash = Math.imul(hash ^ key.charCodeAt(i), 0x01000193);
+    }
+    return hash >>> 0;
+  }
+
+  increment(key) {
+    const h = FrequencySketch.hash(key);
+    const step = (h >>> 16) | 1;
+    const table = this.table;
+    for (let i = 0; i < 4; i++) {
+      const idx = (h + i * step) & this.mask;
+      if (table[idx] < 15) table[idx]++;
+    }
+    if (++this.additions >= this.resetAt) this.reset();
+  }
+
+  frequency(key) {
+    const h = FrequencySketch.hash(key);
+    const step = (h >>> 16) | 1;
+    let min = 15;
+    for (let i = 0; i < 4; i++) {
+      const count = this.table[(h + i * step) & this.mask];
+      if (count < min) min = count;
+    }
+    return min;
+  }
+
+  reset() {
+    const table = this.table;
+    for (let i = 0; i < table.length; i++) table[i] >>= 1;
+    this.additions = 0;
+  }
+}
+
+/**
+ * Stored size of a value in bytes (serialized form for objects).
+ * @param {any} value
+ * @returns {number}
+ */
+function sizeOf(value) {
+  if (Buffer.isBuffer(value)) return value.length;
+  if (typeof value === "string") return Buffer.byteLength(value);
+  const json = JSON.stringify(value);
+  return json === undefined ? 0 : Buffer.byteLength(json);
+}
+
 /**
  * LRU Cache implementation
+ *
+ * Expired entries are reclaimed by a bucketed sweep: each entry is filed
+ * under the tick in which it dies, and the sweep timer only visits the
+ * buckets whose tick has passed — amortized O(1) per entry, no full scan.
  */
 export class LRUCache {
   /**
@@ -27,8 +127,25 @@ export class LRUCache {
    */
   constructor(options = {}) {
     this.max = options.max || 1000;
+    this.maxBytes = options.maxBytes || Infinity;
     this.ttl = options.ttl || 60000;
     this.cache = new Map();
+    this.stats = createCacheStats();
+
+    // Total stored bytes (only tracked with a byte budget)
+    this.bytes = 0;
+
+    // Expired entries are kept this long for stale reads (set by cacheMiddleware)
+    this.staleRetention = 0;
+
+    this.sketch =
+      options.admission === "tinylfu" ? new FrequencySketch(this.max) : null;
+
+    // Expiry buckets: tick -> [key, entry, key, entry, ...]
+    this.resolution = options.sweepInterval || 1000;
+    this.buckets = new Map();
+    this.nextTick = Math.floor(Date.now() / this.resolution);
+    this.timer = null;
   }
 
   /**
@@ -42,34 +159,40 @@ export class LRUCache {
   }
 
   /**
-   * Generate ETag from value
-   * @param {any} value
+   * Generate ETag from value.
+   * FNV-1a over the bytes (non-cryptographic) plus the byte length.
+   * Strings and objects are hashed as their UTF-8 / JSON bytes.
+   * @param {Buffer | string | any} value
    * @returns {string}
    */
   static etag(value) {
-    const str = typeof value === "string" ? value : JSON.stringify(value);
-    let hash = 0;
-    for (let i = 0; i < str.length; i++) {
-      const char = str.charCodeAt(i);
-      hash = (hash << 5) - hash + char;
-      hash = hash & hash;
+    const bytes = Buffer.isBuffer(value)
+      ? value
+      : Buffer.from(typeof value === "string" ? value : JSON.stringify(value));
+    let hash = 0x811c9dc5;
+    for (let i = 0; i < bytes.length; i++) {
+      hash = Math.imul(hash ^ bytes[i], 0x01000193);
     }
-    return `"${Math.abs(hash).toString(36)}"`;
+    return `"${bytes.length.toString(36)}-${(hash >>> 0).toString(36)}"`;
   }
 
   /**
    * Get value from cache
    * @param {string} key
+   * @param {number} [stale=0] - Also return entries expired less than this many ms ago
    * @returns {CacheEntry | null}
    */
-  get(key) {
+  get(key, stale = 0) {
+    if (this.sketch) this.sketch.increment(key);
+
     const entry = this.cache.get(key);
 
     if (!entry) return null;
 
-    // Check expiration
-    if (Date.now() > entry.expires) {
-      this.cache.delete(key);
+    // Check expiration (keep it around while a stale read may still want it)
+    const now = Date.now();
+    if (now > entry.expires + stale) {
+      if (now > entry.expires + this.staleRetention) this._remove(key, entry);
       return null;
     }
 
@@ -81,26 +204,49 @@ export class LRUCache {
   }
 
   /**
-   * Set value in cache
+   * Set value in cache. With a byte budget or TinyLFU admission the value
+   * may not be stored; the entry is returned either way.
    * @param {string} key
    * @param {any} value
    * @param {number} [ttl] - TTL in ms (uses default if not specified)
+   * @param {string} [etag] - Precomputed ETag (derived from value if omitted)
+   * @param {string} [contentType] - Content-Type of a cached body
    * @returns {CacheEntry}
    */
-  set(key, value, ttl) {
-    // Evict oldest if at capacity
-    if (this.cache.size >= this.max) {
-      const oldest = this.cache.keys().next().value;
-      this.cache.delete(oldest);
-    }
-
+  set(key, value, ttl, etag, contentType) {
     const entry = {
       value,
       expires: Date.now() + (ttl || this.ttl),
-      etag: LRUCache.etag(value),
+      etag: etag || LRUCache.etag(value),
+      contentType,
+      size: this.maxBytes === Infinity ? 0 : sizeOf(value),
     };
 
+    // Larger than the whole budget: never stored
+    if (entry.size > this.maxBytes) return entry;
+
+    const existing = this.cache.get(key);
+    if (existing) this._remove(key, existing);
+
+    // Evict oldest until the new entry fits
+    if (this._full(entry.size)) {
+      // TinyLFU: a rarer key must not push out a more popular one
+      // (reads are counted in get(); ties fall back to plain LRU)
+      if (this.sketch && !existing) {
+        const victim = this.cache.keys().next().value;
+        if (this.sketch.frequency(key) < this.sketch.frequency(victim)) {
+          return entry;
+        }
+      }
+      while (this.cache.size > 0 && this._full(entry.size)) {
+        const [oldestKey, oldest] = this.cache.entries().next().value;
+        this._remove(oldestKey, oldest);
+      }
+    }
+
     this.cache.set(key, entry);
+    this.bytes += entry.size;
+    this._schedule(key, entry);
     return entry;
   }
 
@@ -110,7 +256,10 @@ export class LRUCache {
    * @returns {boolean}
    */
   delete(key) {
-    return this.cache.delete(key);
+    const entry = this.cache.get(key);
+    if (!entry) return false;
+    this._remove(key, entry);
+    return true;
   }
 
   /**
@@ -118,6 +267,82 @@ export class LRUCache {
    */
   clear() {
     this.cache.clear();
+    this.buckets.clear();
+    this.bytes = 0;
+    if (this.timer) {
+      clearInterval(this.timer);
+      this.timer = null;
+    }
+  }
+
+  /**
+   * Reclaims entries whose expiry (plus stale retention) has passed.
+   * Runs on the sweep timer; visits only buckets that are due.
+   * @returns {number} Entries removed
+   */
+  prune() {
+    const now = Date.now();
+    const currentTick = Math.floor(now / this.resolution);
+    let removed = 0;
+
+    for (; this.nextTick <= currentTick; this.nextTick++) {
+      const bucket = this.buckets.get(this.nextTick);
+      if (!bucket) continue;
+      this.buckets.delete(this.nextTick);
+
+      for (let i = 0; i < bucket.length; i += 2) {
+        const key = bucket[i];
+        const entry = bucket[i + 1];
+        // Skip entries that were replaced or deleted since
+        if (this.cache.get(key) !== entry) continue;
+        if (now > entry.expires + this.staleRetention) {
+          this._remove(key, entry);
+          removed++;
+        } else {
+          // Retention grew after it was filed: file it again
+          this._schedule(key, entry);
+        }
+      }
+    }
+
+    // Nothing left to expire: stop the timer until the next set()
+    if (this.cache.size === 0 && this.timer) {
+      clearInterval(this.timer);
+      this.timer = null;
+      this.buckets.clear();
+    }
+    return removed;
+  }
+
+  _full(incoming) {
+    return (
+      this.cache.size >= this.max || this.bytes + incoming > this.maxBytes
+    );
+  }
+
+  _remove(key, entry) {
+    this.cache.delete(key);
+    this.bytes -= entry.size;
+  }
+
+  // Files an entry under the tick in which it can be reclaimed
+  _schedule(key, entry) {
+    if (!this.timer) {
+      this.nextTick = Math.floor(Date.now() / this.resolution);
+      this.timer = setInterval(() => this.prune(), this.resolution);
+      this.timer.unref();
+    }
+
+    // First tick that starts strictly after the deadline, so a sweep of
+    // that tick always finds the entry expired (never re-files it in place)
+    const deadline = entry.expires + this.staleRetention;
+    const tick = Math.max(
+      Math.floor(deadline / this.resolution) + 1,
+      this.nextTick,
+    );
+    const bucket = this.buckets.get(tick);
+    if (bucket) bucket.push(key, entry);
+    else this.buckets.set(tick, [key, entry]);
   }
 
   /**
@@ -138,12 +363,48 @@ export class LRUCache {
   }
 }
 
+// In-flight fills per cache: key -> Promise<CacheEntry | null>
+const inflightByCache = new WeakMap();
+
 /**
- * Create cache middleware for route-level caching
- * @param {LRUCache} cache
+ * Cache middleware options
+ * @typedef {Object} CacheMiddlewareOptions
+ * @property {number} [staleWhileRevalidate=0] - Window (ms) after expiry in which the
+ *   old entry is served immediately while one background refresh runs
+ */
+
+/**
+ * Create cache middleware for route-level caching.
+ * Stores the final response bytes with their ETag and content-type, so a
+ * hit is a single writeHead + end with no JSON work. Works with any cache
+ * exposing get/set; `get()` may return a Promise (SharedCache in cluster mode).
+ *
+ * Concurrent misses for one key are coalesced: only the first request runs
+ * the handler, the rest wait for its result. Counters land in `cache.stats`.
+ * @param {LRUCache | import("./shared-cache.js").SharedCache} cache
+ * @param {CacheMiddlewareOptions} [options]
  * @returns {Function}
  */
-export function cacheMiddleware(cache) {
+export function cacheMiddleware(cache, options = {}) {
+  if (!cache.stats) cache.stats = createCacheStats();
+  cacheStatsRegistry.add(cache.stats);
+
+  let inflight = inflightByCache.get(cache);
+  if (!inflight) {
+    inflight = new Map();
+    inflightByCache.set(cache, inflight);
+  }
+
+  const ctx = {
+    cache,
+    stats: cache.stats,
+    inflight,
+    swr: options.staleWhileRevalidate || 0,
+  };
+
+  // Keep expired entries around for the stale window
+  if (ctx.swr > (cache.staleRetention || 0)) cache.staleRetention = ctx.swr;
+
   return (req, res) => {
     // Use the full original URL (includes query string) for the cache key.
     // req.url is overwritten with just the pathname by the server internals,
@@ -156,65 +417,195 @@ export function cacheMiddleware(cache) {
         ? JSON.stringify(req.params)
         : "";
     const key = LRUCache.key(req.method, rawUrl + paramsStr);
-    const entry = cache.get(key);
-
-    if (entry) {
-      // Check If-None-Match header
-      const clientEtag = req.headers["if-none-match"];
-      if (clientEtag === entry.etag) {
-        res.statusCode = 304;
-        res.end();
-        return false; // Stop execution
-      }
+    const entry = cache.get(key, ctx.swr);
 
-      // Return cached response
-      res.setHeader("ETag", entry.etag);
-      res.setHeader("X-Cache", "HIT");
-      res.json(entry.value);
-      return false; // Stop execution
+    if (entry && typeof entry.then === "function") {
+      return entry.then((resolved) => lookup(ctx, key, resolved, req, res));
     }
+    return lookup(ctx, key, entry, req, res);
+  };
+}
+
+/**
+ * Decides between fresh hit, stale hit, coalesced wait and miss.
+ * @returns {boolean | Promise<boolean>} false when the response was sent
+ */
+function lookup(ctx, key, entry, req, res) {
+  if (entry) {
+    if (Date.now() <= entry.expires) {
+      ctx.stats.hits++;
+      return serveEntry(entry, req, res, "HIT");
+    }
+
+    // Stale: serve the old bytes now, refresh once in the background
+    if (!ctx.inflight.has(key)) {
+      const rest = req._rest;
+      if (typeof rest !== "function") {
+        // Not a route interceptor (global or called by hand): this request
+        // refreshes
+        ctx.stats.misses++;
+        return capture(ctx, key, res);
+      }
+      revalidate(ctx, key, rest, req, res);
+    }
+    ctx.stats.stale++;
+    return serveEntry(entry, req, res, "STALE");
+  }
+
+  // Single-flight: attach to the request already filling this key
+  const pending = ctx.inflight.get(key);
+  if (pending) {
+    ctx.stats.coalesced++;
+    return pending.then((fresh) =>
+      fresh ? serveEntry(fresh, req, res, "HIT") : true,
+    );
+  }
+
+  ctx.stats.misses++;
+  return capture(ctx, key, res);
+}
+
+/**
+ * Runs the rest of the route's pipeline (the interceptors after this one,
+ * then the handler, offload and response writing exactly as for a client)
+ * against a detached response, and stores what it sends. The client has
+ * already been answered from the stale entry.
+ */
+function revalidate(ctx, key, rest, req, res) {
+  const shadow = new http.ServerResponse(req);
+  // Same fields the server sets on every response (not counted in metrics)
+  shadow._vibeOptions = res._vibeOptions;
+  shadow._vibeStart = -1;
+  shadow._vibeRoute = 0;
+  shadow._decorations = null;
+  capture(ctx, key, shadow);
+
+  const settle = () => {
+    if (shadow.writableEnded) return;
+    shadow.statusCode = 500;
+    shadow.end();
+  };
+  Promise.resolve()
+    .then(() => rest(req, shadow))
+    .then(settle, settle);
+}
 
-    // Store original json and end methods to intercept response
-    const originalJson = res.json.bind(res);
-    const originalEnd = res.end.bind(res);
+/**
+ * Writes a cached entry (or 304) to the client.
+ * @returns {boolean} false: stop execution
+ */
+function serveEntry(entry, req, res, state) {
+  // If-None-Match: a single tag, a list, or "*" (as in the static engine)
+  const inm = req.headers["if-none-match"];
+  if (inm !== undefined && (inm === "*" || inm.indexOf(entry.etag) !== -1)) {
+    res.writeHead(304, { ETag: entry.etag, "X-Cache": state });
+    res.end();
+    return false; // Stop execution
+  }
 
-    // Intercept res.json (explicit json calls by handler)
-    res.json = (data) => {
-      const newEntry = cache.set(key, data);
+  // Cached bytes: write them as-is
+  if (Buffer.isBuffer(entry.value)) {
+    res.writeHead(200, {
+      "content-type": entry.contentType,
+      "content-length": entry.value.length,
+      ETag: entry.etag,
+      "X-Cache": state,
+    });
+    res.end(entry.value);
+    return false;
+  }
+
+  // Value set manually (not by this middleware)
+  res.setHeader("ETag", entry.etag);
+  res.setHeader("X-Cache", state);
+  res.json(entry.value);
+  return false; // Stop execution
+}
+
+/**
+ * Hooks the response so its bytes get cached, and publishes the result
+ * to coalesced waiters (null when the response was not cacheable).
+ * @returns {boolean} true: continue to handler
+ */
+function capture(ctx, key, res) {
+  const { cache, inflight } = ctx;
+
+  let settle;
+  const flight = new Promise((resolve) => (settle = resolve));
+  inflight.set(key, flight);
+  const done = (entry) => {
+    if (inflight.get(key) === flight) inflight.delete(key);
+    settle(entry);
+  };
+  // Client went away before the handler finished
+  if (typeof res.once === "function") res.once("close", () => done(null));
+
+  // Defer writeHead until the body is known so ETag/X-Cache can still be
+  // added. res.json/res.send and the return-value path in server.js all
+  // end up in writeHead + end, so capturing those covers every helper.
+  const originalWriteHead = res.writeHead;
+  const originalWrite = res.write;
+  const originalEnd = res.end;
+  let headArgs = null;
+
+  const restore = () => {
+    res.writeHead = originalWriteHead;
+    res.write = originalWrite;
+    res.end = originalEnd;
+    if (headArgs) res.writeHead(...headArgs);
+  };
+
+  res.writeHead = (...args) => {
+    headArgs = args;
+    return res;
+  };
+
+  // Streaming responses are not cached
+  res.write = (...args) => {
+    done(null);
+    restore();
+    return res.write(...args);
+  };
+
+  res.end = (body, ...rest) => {
+    const status = headArgs ? headArgs[0] : res.statusCode;
+    const bytes =
+      typeof body === "string"
+        ? Buffer.from(body)
+        : Buffer.isBuffer(body)
+          ? body
+          : null;
+    const contentType =
+      bytes && status === 200 && headContentType(res, headArgs);
+
+    if (contentType) {
+      const newEntry = cache.set(key, bytes, undefined, undefined, contentType);
       res.setHeader("ETag", newEntry.etag);
       res.setHeader("X-Cache", "MISS");
-      originalJson(data);
-    };
-
-    // Intercept res.end (implicit return-value path in server.js uses
-    // res.writeHead + res.end directly, bypassing res.json).
-    // Note: res.getHeader() does NOT see headers set via res.writeHead(),
-    // so we can't check Content-Type that way. Instead, try JSON.parse directly.
-    res.end = (body) => {
-      if (body && !res._vibeCached) {
-        try {
-          const parsed = JSON.parse(body);
-          // Only cache plain objects/arrays — not error objects, not primitives
-          if (
-            typeof parsed === "object" &&
-            parsed !== null &&
-            !parsed.error // skip error responses
-          ) {
-            res._vibeCached = true;
-            const newEntry = cache.set(key, parsed);
-            // setHeader is safe here — headers not yet flushed
-            res.setHeader("ETag", newEntry.etag);
-            res.setHeader("X-Cache", "MISS");
-          }
-        } catch {
-          // Not JSON — skip caching
-        }
-      }
-      originalEnd(body);
-    };
+      body = bytes;
+      done(newEntry);
+    } else {
+      done(null);
+    }
 
-    return true; // Continue to handler
+    restore();
+    return res.end(body, ...rest);
   };
+
+  return true; // Continue to handler
+}
+
+/**
+ * Content-Type of a pending response (from deferred writeHead args or
+ * headers set with setHeader). Only responses with one are cached.
+ */
+function headContentType(res, headArgs) {
+  const headers = headArgs && headArgs[headArgs.length - 1];
+  if (headers && typeof headers === "object" && !Array.isArray(headers)) {
+    const type = headers["content-type"] || headers["Content-Type"];
+    if (type) return type;
+  }
+  return res.getHeader("content-type");
 }
 
 export default LRUCache;
@@ -5,6 +5,8 @@
 import cluster from "node:cluster";
 import os from "node:os";
 import { color } from "../helpers/colors.js";
+import { hostSharedCache } from "./shared-cache.js";
+import { hostMetrics } from "./metrics.js";
 
 /**
  * Cluster configuration options
@@ -12,10 +14,36 @@ import { color } from "../helpers/colors.js";
  * @property {number} [workers] - Number of worker processes (default: CPU count)
  * @property {boolean} [restart] - Auto-restart crashed workers (default: true)
  * @property {number} [restartDelay] - Delay before restarting (ms, default: 1000)
+ * @property {boolean} [reusePort] - Each worker binds its own SO_REUSEPORT socket and the kernel balances accepts (Node >= 22.12 / 23.1 on Linux and some BSDs; falls back to primary round-robin elsewhere)
+ * @property {number} [drainTimeout] - Time a retiring worker gets to finish in-flight requests (ms, default: 10000)
+ * @property {number} [startTimeout] - Time a new worker gets to start listening during a reload (ms, default: 30000)
+ * @property {string | false} [reloadSignal] - Signal that starts a rolling reload (default: "SIGHUP")
+ * @property {{ port?: number, host?: string, path?: string }} [metrics] - Also serve the workers' merged metrics from the primary on this port
  * @property {Function} [onWorkerStart] - Called when worker starts
  * @property {Function} [onWorkerExit] - Called when worker exits
  */
 
+// Primary state: the active configuration, workers being retired on
+// purpose (never restarted), and whether a reload or shutdown is running
+let settings = null;
+const retiring = new Set();
+let reloading = null;
+let shuttingDown = false;
+
+/**
+ * Whether this Node.js build can bind with `reusePort`
+ * @returns {boolean}
+ */
+export function supportsReusePort() {
+  const [major, minor] = process.versions.node.split(".").map(Number);
+  const version =
+    major > 23 || (major === 23 && minor >= 1) || (major === 22 && minor >= 12);
+  return (
+    version &&
+    ["linux", "freebsd", "sunos", "aix"].includes(process.platform)
+  );
+}
+
 /**
  * Start the application in cluster mode
  * @param {Function} startFn - Function that initializes and starts the app
@@ -26,6 +54,11 @@ export function clusterize(startFn, options = {}) {
     workers = os.cpus().length,
     restart = true,
     restartDelay = 1000,
+    reusePort = false,
+    drainTimeout = 10000,
+    startTimeout = 30000,
+    reloadSignal = "SIGHUP",
+    metrics,
     onWorkerStart,
     onWorkerExit,
   } = options;
@@ -37,9 +70,28 @@ export function clusterize(startFn, options = {}) {
       ),
     );
 
+    // Workers read these in server.js
+    const env = { VIBE_DRAIN_TIMEOUT: String(drainTimeout) };
+    if (reusePort) {
+      if (supportsReusePort()) {
+        env.VIBE_REUSE_PORT = "1";
+      } else {
+        console.log(
+          color.yellow(
+            `[VIBE CLUSTER] reusePort needs Node >= 22.12 on Linux (running ${process.version} on ${process.platform}); using round-robin`,
+          ),
+        );
+      }
+    }
+    settings = { env, drainTimeout, startTimeout, onWorkerStart };
+
+    // Workers reach SharedCache instances and push metrics through the primary
+    hostSharedCache();
+    hostMetrics(metrics);
+
     // Fork workers
     for (let i = 0; i < workers; i++) {
-      forkWorker(onWorkerStart);
+      forkWorker();
     }
 
     // Handle worker exit
@@ -56,19 +108,21 @@ export function clusterize(startFn, options = {}) {
       }
 
       // Restart worker if enabled and not intentional exit
-      if (restart && code !== 0) {
+      const retired = retiring.delete(worker);
+      if (restart && code !== 0 && !retired && !shuttingDown) {
         console.log(
           color.cyan(
             `[VIBE CLUSTER] Restarting worker in ${restartDelay}ms...`,
           ),
         );
-        setTimeout(() => forkWorker(onWorkerStart), restartDelay);
+        setTimeout(() => forkWorker(), restartDelay);
       }
     });
 
     // Handle primary process signals
     process.on("SIGTERM", () => gracefulShutdown());
     process.on("SIGINT", () => gracefulShutdown());
+    if (reloadSignal) process.on(reloadSignal, () => reloadWorkers());
   } else {
     // Worker process - start the app
     console.log(color.green(`[VIBE CLUSTER] Worker ${process.pid} started`));
@@ -78,34 +132,128 @@ export function clusterize(startFn, options = {}) {
 
 /**
  * Fork a new worker
- * @param {Function} [onStart] - Callback when worker starts
+ * @returns {import("node:cluster").Worker}
  */
-function forkWorker(onStart) {
-  const worker = cluster.fork();
+function forkWorker() {
+  const worker = cluster.fork(settings.env);
 
   worker.on("online", () => {
-    if (onStart) onStart(worker);
+    if (settings.onWorkerStart) settings.onWorkerStart(worker);
   });
 
   return worker;
 }
 
 /**
- * Gracefully shutdown all workers
+ * Resolves once the worker's server is accepting connections
+ * (server.js reports it; the cluster "listening" event does not fire
+ * for sockets a worker binds itself with reusePort)
+ */
+function whenListening(worker, timeout) {
+  return new Promise((resolve, reject) => {
+    const timer = setTimeout(() => {
+      cleanup();
+      reject(new Error(`Worker ${worker.process.pid} did not start listening`));
+    }, timeout);
+    const onMessage = (msg) => {
+      if (msg && msg.type === "vibe:listening") {
+        cleanup();
+        resolve();
+      }
+    };
+    const onExit = () => {
+      cleanup();
+      reject(new Error(`Worker ${worker.process.pid} exited during startup`));
+    };
+    const cleanup = () => {
+      clearTimeout(timer);
+      worker.off("message", onMessage);
+      worker.off("exit", onExit);
+    };
+    worker.on("message", onMessage);
+    worker.on("exit", onExit);
+  });
+}
+
+/**
+ * Ask a worker to drain (stop accepting, finish in-flight requests, close
+ * keep-alives) and kill it if it has not exited after `timeout`
+ * @returns {Promise<void>} Resolves when the worker has exited
+ */
+function retire(worker, timeout) {
+  retiring.add(worker);
+  return new Promise((resolve) => {
+    if (worker.isDead()) return resolve();
+    const timer = setTimeout(() => worker.process.kill("SIGKILL"), timeout);
+    worker.once("exit", () => {
+      clearTimeout(timer);
+      resolve();
+    });
+    if (worker.isConnected()) worker.send("shutdown");
+    else worker.process.kill("SIGTERM");
+  });
+}
+
+/**
+ * Rolling reload: replace workers one at a time. Each old worker is
+ * drained only after its replacement is listening, so capacity never
+ * drops and no connection is refused. A replacement that fails to start
+ * stops the reload and leaves the remaining old workers serving.
+ * @returns {Promise<void>}
+ */
+export function reloadWorkers() {
+  if (!cluster.isPrimary || !settings) {
+    return Promise.reject(
+      new Error("reloadWorkers() must run in the cluster primary"),
+    );
+  }
+  if (reloading) return reloading;
+
+  reloading = (async () => {
+    const old = Object.values(cluster.workers).filter(
+      (w) => !retiring.has(w),
+    );
+    console.log(
+      color.cyan(`[VIBE CLUSTER] Rolling reload of ${old.length} workers...`),
+    );
+    for (const worker of old) {
+      if (shuttingDown) return;
+      const next = forkWorker();
+      try {
+        await whenListening(next, settings.startTimeout);
+      } catch (err) {
+        console.log(color.red(`[VIBE CLUSTER] Reload aborted: ${err.message}`));
+        retire(next, 0);
+        return;
+      }
+      await retire(worker, settings.drainTimeout + 1000);
+    }
+    console.log(color.green("[VIBE CLUSTER] Reload complete"));
+  })().finally(() => {
+    reloading = null;
+  });
+  return reloading;
+}
+
+/**
+ * Gracefully shutdown all workers: each drains its in-flight requests,
+ * then the primary exits once all of them are gone
  */
 function gracefulShutdown() {
+  if (shuttingDown) return;
+  shuttingDown = true;
   console.log(color.yellow("\n[VIBE CLUSTER] Shutting down..."));
 
-  for (const id in cluster.workers) {
-    cluster.workers[id].send("shutdown");
-    cluster.workers[id].disconnect();
-  }
+  const workers = Object.values(cluster.workers);
+  Promise.all(
+    workers.map((worker) => retire(worker, settings.drainTimeout + 1000)),
+  ).then(() => process.exit(0));
 
   // Force exit after timeout
   setTimeout(() => {
     console.log(color.red("[VIBE CLUSTER] Forcing shutdown"));
     process.exit(0);
-  }, 5000);
+  }, settings.drainTimeout + 5000).unref();
 }
 
 /**
@@ -140,4 +288,12 @@ export function getWorkerCount() {
   return Object.keys(cluster.workers || {}).length;
 }
 
-export default { clusterize, isPrimary, isWorker, getWorkerId, getWorkerCount };
+export default {
+  clusterize,
+  reloadWorkers,
+  supportsReusePort,
+  isPrimary,
+  isWorker,
+  getWorkerId,
+  getWorkerCount,
+};
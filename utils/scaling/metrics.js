@@ -0,0 +1,491 @@
+/**
+ * Request Metrics for Prometheus / OpenMetrics
+ * Counts requests per route and status class and keeps a latency
+ * histogram per route. Every route gets a numeric id at listen(), and its
+ * counters are allocated then, so recording a request is a few array
+ * increments with no allocation.
+ *
+ * In cluster mode each worker pushes what it recorded since the last push
+ * to the primary, which merges all workers and serves the scrape, either
+ * through any worker's metrics route or on its own port.
+ */
+import cluster from "node:cluster";
+import http from "node:http";
+import { monitorEventLoopDelay } from "node:perf_hooks";
+import { Histogram } from "../helpers/histogram.js";
+import { RESPONSE_CLASSES } from "../core/protocols.js";
+import { cacheStatsRegistry } from "./cache.js";
+
+// IPC message tag (keeps metrics traffic apart from app messages)
+const MSG = "vibe:metrics";
+
+const STATUS_CLASSES = ["1xx", "2xx", "3xx", "4xx", "5xx"];
+const CACHE_RESULTS = ["hits", "misses", "stale", "coalesced"];
+
+// Latency buckets (seconds) exposed as `le`
+const BOUNDS = [
+  0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10,
+];
+const BOUNDS_MS = BOUNDS.map((b) => b * 1000);
+
+// monitorEventLoopDelay timer period; its samples include it
+const LOOP_RESOLUTION = 10;
+
+const PROMETHEUS_TYPE = "text/plain; version=0.0.4; charset=utf-8";
+const OPENMETRICS_TYPE =
+  "application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+/**
+ * Metrics configuration
+ * @typedef {Object} MetricsOptions
+ * @property {string} [path="/metrics"] - Route serving the scrape
+ * @property {number} [interval=5000] - Cluster workers push to the primary this often (ms)
+ * @property {number} [timeout=1000] - Max wait (ms) for the primary's merged scrape
+ */
+
+/**
+ * Counters and latency of one route
+ */
+class RouteStats {
+  constructor(label) {
+    this.label = label;
+    this.statuses = new Float64Array(STATUS_CLASSES.length);
+    this.latency = new Histogram();
+  }
+
+  get count() {
+    return this.latency.count;
+  }
+
+  reset() {
+    this.statuses.fill(0);
+    this.latency.reset();
+  }
+}
+
+function emptyCache() {
+  return { hits: 0, misses: 0, stale: 0, coalesced: 0 };
+}
+
+// Sum of every cacheMiddleware's counters in this process
+function cacheTotals() {
+  const totals = emptyCache();
+  for (const stats of cacheStatsRegistry) {
+    for (const k of CACHE_RESULTS) totals[k] += stats[k];
+  }
+  return totals;
+}
+
+/**
+ * Process gauges; event-loop delay covers the time since the last sample
+ */
+function sampleProcess(loop) {
+  const mem = process.memoryUsage();
+  const delay = (p) =>
+    Math.max(0, loop.percentile(p) / 1e6 - LOOP_RESOLUTION);
+  const sample = {
+    heapUsed: mem.heapUsed,
+    heapTotal: mem.heapTotal,
+    rss: mem.rss,
+    uptime: process.uptime(),
+    loopP50: delay(50),
+    loopP99: delay(99),
+  };
+  loop.reset();
+  return sample;
+}
+
+// ==========================================
+// Exposition
+// ==========================================
+
+// Milliseconds as seconds, to the microsecond
+const seconds = (ms) => Math.round(ms * 1000) / 1e6;
+
+function escapeLabel(value) {
+  return String(value)
+    .replace(/\\/g, "\\\\")
+    .replace(/"/g, '\\"')
+    .replace(/\n/g, "\\n");
+}
+
+/**
+ * Render a snapshot in the Prometheus text format, or OpenMetrics
+ * (counter families named without `_total`, `# EOF` trailer)
+ * @param {{ routes: Iterable<RouteStats>, workers: Map<number, Object>, cache: Object }} snapshot
+ * @param {boolean} openMetrics
+ * @returns {string}
+ */
+export function formatMetrics(snapshot, openMetrics = false) {
+  const out = [];
+  const family = (name, type, help) => {
+    const base =
+      openMetrics && type === "counter" ? name.replace(/_total$/, "") : name;
+    out.push(`# HELP ${base} ${help}`, `# TYPE ${base} ${type}`);
+  };
+
+  const routes = [...snapshot.routes].filter((r) => r.count > 0);
+
+  family(
+    "vibe_http_requests_total",
+    "counter",
+    "HTTP requests by route and status class",
+  );
+  for (const r of routes) {
+    const route = escapeLabel(r.label);
+    for (let i = 0; i < STATUS_CLASSES.length; i++) {
+      if (r.statuses[i] === 0) continue;
+      out.push(
+        `vibe_http_requests_total{route="${route}",status="${STATUS_CLASSES[i]}"} ${r.statuses[i]}`,
+      );
+    }
+  }
+
+  family(
+    "vibe_http_request_duration_seconds",
+    "histogram",
+    "Time from request to response end",
+  );
+  for (const r of routes) {
+    const route = escapeLabel(r.label);
+    const name = "vibe_http_request_duration_seconds";
+    const counts = r.latency.cumulative(BOUNDS_MS);
+    for (let i = 0; i < BOUNDS.length; i++) {
+      out.push(
+        `${name}_bucket{route="${route}",le="${BOUNDS[i]}"} ${counts[i]}`,
+      );
+    }
+    out.push(
+      `${name}_bucket{route="${route}",le="+Inf"} ${r.latency.count}`,
+      `${name}_sum{route="${route}"} ${seconds(r.latency.sum)}`,
+      `${name}_count{route="${route}"} ${r.latency.count}`,
+    );
+  }
+
+  family(
+    "vibe_worker_requests_total",
+    "counter",
+    "HTTP requests handled by each worker",
+  );
+  for (const [pid, w] of snapshot.workers) {
+    out.push(`vibe_worker_requests_total{worker="${pid}"} ${w.requests}`);
+  }
+
+  const gauges = [
+    ["vibe_worker_heap_used_bytes", "V8 heap in use", "heapUsed"],
+    ["vibe_worker_heap_total_bytes", "V8 heap allocated", "heapTotal"],
+    ["vibe_worker_rss_bytes", "Resident set size", "rss"],
+    ["vibe_worker_uptime_seconds", "Process uptime", "uptime"],
+  ];
+  for (const [name, help, key] of gauges) {
+    family(name, "gauge", help);
+    for (const [pid, w] of snapshot.workers) {
+      out.push(`${name}{worker="${pid}"} ${w[key]}`);
+    }
+  }
+
+  family(
+    "vibe_worker_event_loop_delay_seconds",
+    "summary",
+    "Event-loop delay since the previous sample",
+  );
+  for (const [pid, w] of snapshot.workers) {
+    const name = "vibe_worker_event_loop_delay_seconds";
+    out.push(
+      `${name}{worker="${pid}",quantile="0.5"} ${seconds(w.loopP50)}`,
+      `${name}{worker="${pid}",quantile="0.99"} ${seconds(w.loopP99)}`,
+    );
+  }
+
+  family(
+    "vibe_cache_requests_total",
+    "counter",
+    "Response cache lookups by result",
+  );
+  for (const k of CACHE_RESULTS) {
+    out.push(`vibe_cache_requests_total{result="${k}"} ${snapshot.cache[k]}`);
+  }
+
+  if (openMetrics) out.push("# EOF");
+  return out.join("\n") + "\n";
+}
+
+function wantsOpenMetrics(req) {
+  const accept = req.headers.accept;
+  return !!accept && accept.includes("application/openmetrics-text");
+}
+
+function sendText(res, text, openMetrics) {
+  res.writeHead(200, {
+    "content-type": openMetrics ? OPENMETRICS_TYPE : PROMETHEUS_TYPE,
+  });
+  res.end(text);
+}
+
+// ==========================================
+// Recording (every process that serves requests)
+// ==========================================
+
+let endHookInstalled = false;
+
+/**
+ * Record each response when it ends. Installed once on the HTTP/1.1 and
+ * HTTP/2 response prototypes, so requests pay no listener; only responses
+ * stamped by the server (`_vibeStart`) are counted.
+ */
+function installEndHook() {
+  if (endHookInstalled) return;
+  endHookInstalled = true;
+
+  for (const Response of RESPONSE_CLASSES) {
+    const end = Response.prototype.end;
+    Response.prototype.end = function (chunk, encoding, callback) {
+      const start = this._vibeStart;
+      if (start !== undefined && start >= 0) {
+        this._vibeStart = -1;
+        this._vibeOptions.metrics.record(
+          this._vibeRoute,
+          this.statusCode,
+          performance.now() - start,
+        );
+      }
+      return end.call(this, chunk, encoding, callback);
+    };
+  }
+}
+
+const pending = new Map();
+let nextId = 0;
+let listenerInstalled = false;
+
+function installReplyListener() {
+  if (listenerInstalled) return;
+  listenerInstalled = true;
+
+  process.on("message", (msg) => {
+    if (!msg || msg.type !== MSG) return;
+    const waiter = pending.get(msg.id);
+    if (!waiter) return; // timed out already
+    pending.delete(msg.id);
+    clearTimeout(waiter.timer);
+    waiter.resolve(msg.text);
+  });
+}
+
+/**
+ * Per-process request metrics
+ */
+export class Metrics {
+  /**
+   * @param {MetricsOptions} [options]
+   */
+  constructor(options = {}) {
+    this.path = options.path || "/metrics";
+    this.interval = options.interval || 5000;
+    this.timeout = options.timeout || 1000;
+
+    /** @type {RouteStats[]} indexed by route._metricsId; 0 is unmatched */
+    this.routes = [new RouteStats("unmatched")];
+    this.requests = 0;
+
+    this.loop = monitorEventLoopDelay({ resolution: LOOP_RESOLUTION });
+    this.clustered = cluster.isWorker && typeof process.send === "function";
+    this._cacheSent = emptyCache();
+    this._timer = null;
+  }
+
+  /**
+   * Assign route ids and start recording. Called by the server at listen().
+   * @param {import("../../vibe.js").VibeRoute[]} routes
+   */
+  bind(routes) {
+    for (const route of routes) {
+      route._metricsId = this.routes.length;
+      this.routes.push(new RouteStats(`${route.method} ${route.path}`));
+    }
+    installEndHook();
+    this.loop.enable();
+
+    if (this.clustered) {
+      installReplyListener();
+      this._timer = setInterval(() => this.push(), this.interval);
+      this._timer.unref();
+    }
+  }
+
+  /**
+   * @param {number} id - Route id (0: no route matched)
+   * @param {number} status - Response status code
+   * @param {number} ms - Duration
+   */
+  record(id, status, ms) {
+    const route = this.routes[id];
+    const cls = ((status / 100) | 0) - 1;
+    route.statuses[cls < 0 ? 0 : cls > 4 ? 4 : cls]++;
+    route.latency.record(ms);
+    this.requests++;
+  }
+
+  /**
+   * Send what was recorded since the last push to the primary, then
+   * start over (the primary keeps the totals)
+   */
+  push() {
+    if (!process.connected) return;
+
+    const routes = [];
+    for (const r of this.routes) {
+      if (r.count === 0) continue;
+      routes.push({
+        label: r.label,
+        statuses: Array.from(r.statuses),
+        latency: r.latency.sparse(),
+      });
+      r.reset();
+    }
+
+    const totals = cacheTotals();
+    const cache = {};
+    for (const k of CACHE_RESULTS) cache[k] = totals[k] - this._cacheSent[k];
+    this._cacheSent = totals;
+
+    process.send({
+      type: MSG,
+      op: "push",
+      routes,
+      requests: this.requests,
+      process: sampleProcess(this.loop),
+      cache,
+    });
+    this.requests = 0;
+  }
+
+  /**
+   * Metrics text: this process alone, or all workers as merged by the
+   * primary (null if the primary does not answer in time)
+   * @param {boolean} [openMetrics=false]
+   * @returns {string | Promise<string | null>}
+   */
+  scrape(openMetrics = false) {
+    if (!this.clustered) {
+      const workers = new Map([
+        [process.pid, { requests: this.requests, ...sampleProcess(this.loop) }],
+      ]);
+      return formatMetrics(
+        { routes: this.routes, workers, cache: cacheTotals() },
+        openMetrics,
+      );
+    }
+
+    this.push(); // include this worker's latest requests
+    if (!process.connected) return Promise.resolve(null);
+    const id = ++nextId;
+    return new Promise((resolve) => {
+      const timer = setTimeout(() => {
+        pending.delete(id);
+        resolve(null);
+      }, this.timeout);
+      pending.set(id, { resolve, timer });
+      process.send({ type: MSG, op: "scrape", id, openMetrics });
+    });
+  }
+
+  /**
+   * Route handler for the metrics path
+   */
+  async serve(req, res) {
+    const openMetrics = wantsOpenMetrics(req);
+    const text = await this.scrape(openMetrics);
+    if (text === null) {
+      res.writeHead(503, { "content-type": "text/plain" });
+      res.end("Metrics unavailable");
+      return;
+    }
+    sendText(res, text, openMetrics);
+  }
+
+  /** Stop pushing and sampling */
+  close() {
+    clearInterval(this._timer);
+    this.loop.disable();
+  }
+}
+
+// ==========================================
+// Primary side
+// ==========================================
+
+let hostInstalled = false;
+
+/**
+ * Merge metrics pushed by workers and answer scrapes. Called by
+ * clusterize(); only needed directly when workers are forked by hand.
+ * @param {{ port?: number, host?: string, path?: string }} [options] - Also serve the merged metrics on this port
+ * @returns {{ routes: Map<string, RouteStats>, workers: Map<number, Object>, cache: Object } | undefined}
+ */
+export function hostMetrics(options = {}) {
+  if (hostInstalled || !cluster.isPrimary) return undefined;
+  hostInstalled = true;
+
+  const totals = {
+    routes: new Map(),
+    workers: new Map(), // pid → latest gauges + request total
+    cache: emptyCache(),
+  };
+  const snapshot = () => ({
+    routes: totals.routes.values(),
+    workers: totals.workers,
+    cache: totals.cache,
+  });
+
+  cluster.on("message", (worker, msg) => {
+    if (!msg || msg.type !== MSG) return;
+
+    if (msg.op === "push") {
+      for (const r of msg.routes) {
+        let stats = totals.routes.get(r.label);
+        if (!stats) {
+          stats = new RouteStats(r.label);
+          totals.routes.set(r.label, stats);
+        }
+        for (let i = 0; i < r.statuses.length; i++) {
+          stats.statuses[i] += r.statuses[i];
+        }
+        stats.latency.mergeSparse(r.latency);
+      }
+      for (const k of CACHE_RESULTS) totals.cache[k] += msg.cache[k];
+      const pid = worker.process.pid;
+      const requests = (totals.workers.get(pid)?.requests || 0) + msg.requests;
+      totals.workers.set(pid, { ...msg.process, requests });
+    } else if (msg.op === "scrape") {
+      worker.send({
+        type: MSG,
+        id: msg.id,
+        text: formatMetrics(snapshot(), msg.openMetrics),
+      });
+    }
+  });
+
+  // Gauges of a dead worker are meaningless; its counts stay in the totals
+  cluster.on("exit", (worker) => totals.workers.delete(worker.process.pid));
+
+  if (options.port) {
+    const path = options.path || "/metrics";
+    http
+      .createServer((req, res) => {
+        if (req.url.split("?")[0] !== path) {
+          res.writeHead(404, { "content-type": "text/plain" });
+          res.end("Not Found");
+          return;
+        }
+        const openMetrics = wantsOpenMetrics(req);
+        sendText(res, formatMetrics(snapshot(), openMetrics), openMetrics);
+      })
+      .listen(options.port, options.host || "0.0.0.0")
+      .unref();
+  }
+
+  return totals;
+}
+
+export default Metrics;
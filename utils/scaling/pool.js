@@ -1,18 +1,30 @@
 /**
  * Generic Connection Pool
  * Manages a pool of reusable resources (connections, clients, etc.)
+ *
+ * Every acquire/release is O(1): idle resources sit in a deque (most
+ * recently used at the back, handed out first; least recently used at the
+ * front, evicted first) and callers wait in a FIFO ring buffer. A timed-out
+ * waiter is only marked; it is skipped when it reaches the front, and the
+ * queue is compacted when marked entries dominate it. Creating, replacing
+ * and destroying resources happens in the background, so a slow teardown
+ * never holds up a caller.
  */
+import { Deque } from "../helpers/deque.js";
+import { Histogram } from "../helpers/histogram.js";
 
 /**
  * Pool configuration
  * @typedef {Object} PoolOptions
  * @property {Function} create - Async function to create a new resource
  * @property {Function} destroy - Async function to destroy a resource
- * @property {Function} [validate] - Function to validate a resource is still usable
+ * @property {Function} [validate] - Function (sync or async) to validate a resource is still usable
  * @property {number} [min=0] - Minimum pool size
  * @property {number} [max=10] - Maximum pool size
+ * @property {number} [minIdle=0] - Idle resources to keep ready; refilled in the background after acquires
  * @property {number} [acquireTimeout=30000] - Timeout for acquiring resource (ms)
  * @property {number} [idleTimeout=60000] - Time before idle resources are destroyed (ms)
+ * @property {number} [validateInterval=0] - Validate idle resources in the background every N ms and replace failures (0: only on acquire)
  */
 
 /**
@@ -23,6 +35,20 @@
  * @property {number} lastUsed - Last usage timestamp
  */
 
+/**
+ * Caller waiting for a resource
+ * @typedef {Object} Waiter
+ * @property {Function} resolve
+ * @property {Function} reject
+ * @property {NodeJS.Timeout} timeout
+ * @property {number} start - performance.now() at acquire()
+ * @property {boolean} done - Served, timed out or rejected; skipped in the queue
+ */
+
+// Compact the waiter queue once this many timed-out entries are in it
+// and they outnumber the live ones
+const COMPACT_AFTER = 64;
+
 /**
  * Generic resource pool
  */
@@ -39,73 +65,244 @@ export class Pool {
     this.validate = options.validate || (() => true);
     this.min = options.min || 0;
     this.max = options.max || 10;
+    this.minIdle = Math.min(options.minIdle || 0, this.max);
     this.acquireTimeout = options.acquireTimeout || 30000;
     this.idleTimeout = options.idleTimeout || 60000;
-
-    /** @type {PooledResource[]} */
-    this.available = [];
-    /** @type {Set<any>} */
-    this.inUse = new Set();
-    /** @type {Array<{resolve: Function, reject: Function, timeout: NodeJS.Timeout}>} */
-    this.waiting = [];
+    this.validateInterval = options.validateInterval || 0;
+
+    /** @type {Deque} PooledResource entries */
+    this.available = new Deque();
+    /** @type {Map<any, PooledResource>} */
+    this.inUse = new Map();
+    /** @type {Deque} Waiter entries */
+    this.waiting = new Deque();
+    this.waitingCount = 0; // live entries in `waiting`
+
+    // Resources that count against `max` without being available or in use
+    this.creating = 0;
+    this.destroying = 0;
+
+    this.created = 0;
+    this.destroyed = 0;
+    this.createErrors = 0;
+    this.timeouts = 0;
+    this.waitTime = new Histogram(); // acquire() → resource handed over
 
     this._closed = false;
     this._idleCheckInterval = null;
+    this._validateCheckInterval = null;
+    this._validating = false;
 
     // Initialize minimum resources
     this._initialize();
   }
 
-  async _initialize() {
-    const promises = [];
-    for (let i = 0; i < this.min; i++) {
-      promises.push(this._createResource());
-    }
-    await Promise.all(promises);
+  _initialize() {
+    this._refill();
 
-    // Start idle cleanup
+    // Start idle cleanup; timers must not keep the process alive
     this._idleCheckInterval = setInterval(
       () => this._cleanupIdle(),
       this.idleTimeout / 2,
     );
+    this._idleCheckInterval.unref();
+
+    if (this.validateInterval > 0) {
+      this._validateCheckInterval = setInterval(
+        () => this._validateIdle(),
+        this.validateInterval,
+      );
+      this._validateCheckInterval.unref();
+    }
   }
 
+  /**
+   * Everything counted against `max`
+   * @returns {number}
+   */
+  get size() {
+    return (
+      this.available.length + this.inUse.size + this.creating + this.destroying
+    );
+  }
+
+  /**
+   * Create a resource. It lands in `inUse` in the same tick `creating`
+   * drops, so the pool never looks smaller than it is.
+   * @returns {Promise<PooledResource>}
+   */
   async _createResource() {
+    this.creating++;
+    let resource;
     try {
-      const resource = await this.create();
-      const pooled = {
-        resource,
-        createdAt: Date.now(),
-        lastUsed: Date.now(),
-      };
-      this.available.push(pooled);
-      return pooled;
+      resource = await this.create();
     } catch (err) {
+      this.creating--;
+      this.createErrors++;
       console.error("[Pool] Failed to create resource:", err);
       throw err;
     }
+    this.creating--;
+    this.created++;
+    const now = Date.now();
+    const pooled = { resource, createdAt: now, lastUsed: now };
+    this.inUse.set(resource, pooled);
+    return pooled;
   }
 
-  _cleanupIdle() {
-    const now = Date.now();
-    const toRemove = [];
+  /**
+   * Create one resource in the background and hand it to the oldest
+   * waiter, or park it as idle
+   */
+  _spawn() {
+    this._createResource().then(
+      (pooled) => {
+        if (this._closed) {
+          this._retire(pooled.resource);
+          return;
+        }
+        this.inUse.delete(pooled.resource);
+        if (!this._handOff(pooled)) this.available.push(pooled);
+      },
+      (err) => {
+        // Fail a caller now rather than at its timeout
+        const waiter = this._nextWaiter();
+        if (waiter) this._settle(waiter).reject(err);
+      },
+    );
+  }
+
+  /**
+   * Top up to `min` total and `minIdle` idle resources, and create for
+   * waiters that nothing else will serve
+   */
+  _refill() {
+    if (this._closed) return;
+    while (
+      this.size < this.max &&
+      (this.waitingCount > this.creating ||
+        this.size < this.min ||
+        this.available.length + this.creating < this.minIdle)
+    ) {
+      this._spawn();
+    }
+  }
 
-    for (let i = 0; i < this.available.length; i++) {
-      const pooled = this.available[i];
-      const idle = now - pooled.lastUsed;
+  /**
+   * Remove a resource from the pool and destroy it in the background.
+   * It keeps counting against `max` until destroy() settles.
+   */
+  _retire(resource) {
+    this.inUse.delete(resource);
+    this.destroying++;
+    Promise.resolve()
+      .then(() => this.destroy(resource))
+      .catch(() => {})
+      .finally(() => {
+        this.destroying--;
+        this.destroyed++;
+        this._refill();
+      });
+  }
 
-      // Keep minimum resources
-      if (this.available.length - toRemove.length <= this.min) break;
+  _cleanupIdle() {
+    const now = Date.now();
+    const keepIdle = this.minIdle;
+
+    // Least recently used first; stop at the first one still fresh
+    while (
+      this.available.length > keepIdle &&
+      this.size > this.min &&
+      now - this.available.peek().lastUsed > this.idleTimeout
+    ) {
+      this._retire(this.available.shift().resource);
+    }
+  }
 
-      if (idle > this.idleTimeout) {
-        toRemove.push(i);
+  /**
+   * Background health check of idle resources. Resources acquired while
+   * the check runs are left alone (acquire validates them anyway).
+   */
+  async _validateIdle() {
+    if (this._validating || this._closed || this.available.length === 0) {
+      return;
+    }
+    this._validating = true;
+    try {
+      const idle = [...this.available];
+      const results = await Promise.all(
+        idle.map((pooled) =>
+          Promise.resolve()
+            .then(() => this.validate(pooled.resource))
+            .catch(() => false),
+        ),
+      );
+      const failed = new Set(idle.filter((pooled, i) => !results[i]));
+      if (failed.size === 0 || this._closed) return;
+
+      const kept = new Deque(this.available.length);
+      for (const pooled of this.available) {
+        if (failed.has(pooled)) {
+          this._retire(pooled.resource); // replaced by _refill when done
+        } else {
+          kept.push(pooled);
+        }
       }
+      this.available = kept;
+    } finally {
+      this._validating = false;
     }
+  }
 
-    // Remove in reverse order to preserve indices
-    for (let i = toRemove.length - 1; i >= 0; i--) {
-      const pooled = this.available.splice(toRemove[i], 1)[0];
-      this.destroy(pooled.resource).catch(() => {});
+  /**
+   * Oldest waiter that has not timed out
+   * @returns {Waiter | undefined}
+   */
+  _nextWaiter() {
+    while (this.waiting.length > 0) {
+      const waiter = this.waiting.shift();
+      if (!waiter.done) return waiter;
+    }
+    return undefined;
+  }
+
+  /** Take a waiter out of the live count and stop its timer */
+  _settle(waiter) {
+    waiter.done = true;
+    this.waitingCount--;
+    clearTimeout(waiter.timeout);
+    return waiter;
+  }
+
+  /**
+   * Give a resource to the oldest waiter
+   * @param {PooledResource} pooled
+   * @returns {boolean} false when nobody is waiting
+   */
+  _handOff(pooled) {
+    const waiter = this._nextWaiter();
+    if (!waiter) return false;
+    this._settle(waiter);
+    pooled.lastUsed = Date.now();
+    this.inUse.set(pooled.resource, pooled);
+    this.waitTime.record(performance.now() - waiter.start);
+    waiter.resolve(pooled.resource);
+    return true;
+  }
+
+  _timeout(waiter) {
+    if (waiter.done) return;
+    this._settle(waiter);
+    this.timeouts++;
+    waiter.reject(new Error("Acquire timeout"));
+
+    // Timed-out entries stay queued until they reach the front; drop them
+    // in one pass if they pile up (amortized O(1) per waiter)
+    const dead = this.waiting.length - this.waitingCount;
+    if (dead >= COMPACT_AFTER && dead > this.waitingCount) {
+      const live = new Deque(this.waitingCount);
+      for (const w of this.waiting) if (!w.done) live.push(w);
+      this.waiting = live;
     }
   }
 
@@ -115,39 +312,48 @@ export class Pool {
    */
   async acquire() {
     if (this._closed) throw new Error("Pool is closed");
+    const start = performance.now();
 
-    // Try to get available resource
+    // Most recently used first; invalid ones are destroyed in the background
     while (this.available.length > 0) {
       const pooled = this.available.pop();
+      this.inUse.set(pooled.resource, pooled); // counted while validating
 
-      // Validate resource
-      if (this.validate(pooled.resource)) {
+      let valid = this.validate(pooled.resource);
+      if (valid && typeof valid.then === "function") {
+        valid = await valid.catch(() => false);
+      }
+      if (valid && !this._closed) {
         pooled.lastUsed = Date.now();
-        this.inUse.add(pooled.resource);
+        this.waitTime.record(performance.now() - start);
+        this._refill();
         return pooled.resource;
       }
-
-      // Resource invalid, destroy it
-      await this.destroy(pooled.resource).catch(() => {});
+      this._retire(pooled.resource);
+      if (this._closed) throw new Error("Pool is closed");
     }
 
     // Create new if under max
-    if (this.inUse.size < this.max) {
+    if (this.size < this.max) {
       const pooled = await this._createResource();
-      const resource = this.available.pop().resource;
-      this.inUse.add(resource);
-      return resource;
+      if (this._closed) {
+        this._retire(pooled.resource);
+        throw new Error("Pool is closed");
+      }
+      this.waitTime.record(performance.now() - start);
+      this._refill();
+      return pooled.resource;
     }
 
     // Wait for available resource
     return new Promise((resolve, reject) => {
-      const timeout = setTimeout(() => {
-        const idx = this.waiting.findIndex((w) => w.resolve === resolve);
-        if (idx >= 0) this.waiting.splice(idx, 1);
-        reject(new Error("Acquire timeout"));
-      }, this.acquireTimeout);
-
-      this.waiting.push({ resolve, reject, timeout });
+      const waiter = { resolve, reject, timeout: null, start, done: false };
+      waiter.timeout = setTimeout(
+        () => this._timeout(waiter),
+        this.acquireTimeout,
+      );
+      this.waiting.push(waiter);
+      this.waitingCount++;
     });
   }
 
@@ -156,25 +362,21 @@ export class Pool {
    * @param {any} resource
    */
   release(resource) {
-    if (!this.inUse.has(resource)) return;
-
-    this.inUse.delete(resource);
+    const pooled = this.inUse.get(resource);
+    if (!pooled) return;
 
-    // If someone is waiting, give to them
-    if (this.waiting.length > 0) {
-      const { resolve, timeout } = this.waiting.shift();
-      clearTimeout(timeout);
-      this.inUse.add(resource);
-      resolve(resource);
+    if (this._closed) {
+      this._retire(resource);
       return;
     }
 
+    // If someone is waiting, give to them
+    this.inUse.delete(resource);
+    if (this._handOff(pooled)) return;
+
     // Return to available pool
-    this.available.push({
-      resource,
-      createdAt: Date.now(), // Approximate
-      lastUsed: Date.now(),
-    });
+    pooled.lastUsed = Date.now();
+    this.available.push(pooled);
   }
 
   /**
@@ -192,41 +394,54 @@ export class Pool {
   }
 
   /**
-   * Close the pool and destroy all resources
+   * Close the pool and destroy all resources.
+   * Resources still in use are destroyed when they are released.
    */
   async close() {
     this._closed = true;
 
-    if (this._idleCheckInterval) {
-      clearInterval(this._idleCheckInterval);
-    }
+    clearInterval(this._idleCheckInterval);
+    clearInterval(this._validateCheckInterval);
 
     // Reject waiting
-    for (const { reject, timeout } of this.waiting) {
-      clearTimeout(timeout);
-      reject(new Error("Pool closed"));
+    let waiter;
+    while ((waiter = this._nextWaiter()) !== undefined) {
+      this._settle(waiter).reject(new Error("Pool closed"));
     }
-    this.waiting = [];
 
     // Destroy available
-    const destroyPromises = this.available.map((p) =>
-      this.destroy(p.resource).catch(() => {}),
-    );
-    this.available = [];
+    const destroyPromises = [];
+    let pooled;
+    while ((pooled = this.available.shift()) !== undefined) {
+      const resource = pooled.resource;
+      destroyPromises.push(
+        Promise.resolve()
+          .then(() => this.destroy(resource))
+          .catch(() => {})
+          .finally(() => this.destroyed++),
+      );
+    }
 
     await Promise.all(destroyPromises);
   }
 
   /**
-   * Get pool statistics
-   * @returns {{ available: number, inUse: number, waiting: number, max: number }}
+   * Get pool statistics (wait: acquire wait time in milliseconds)
    */
   get stats() {
     return {
       available: this.available.length,
       inUse: this.inUse.size,
-      waiting: this.waiting.length,
+      waiting: this.waitingCount,
       max: this.max,
+      size: this.size,
+      creating: this.creating,
+      destroying: this.destroying,
+      created: this.created,
+      destroyed: this.destroyed,
+      createErrors: this.createErrors,
+      timeouts: this.timeouts,
+      wait: this.waitTime.toJSON(),
     };
   }
 }
@@ -0,0 +1,226 @@
+/**
+ * Cross-Worker Response Cache for Cluster Mode
+ * One LRUCache hosted by the cluster primary and reached over the cluster
+ * IPC channel, so every worker sees the same entries. Entries hold the
+ * final response bytes, so a hit needs no JSON work at all.
+ */
+import cluster from "node:cluster";
+import { LRUCache, createCacheStats } from "./cache.js";
+
+// IPC message tag (keeps cache traffic apart from app messages)
+const MSG = "vibe:cache";
+
+/**
+ * Shared cache options
+ * @typedef {Object} SharedCacheOptions
+ * @property {string} [name="default"] - Cache namespace on the primary
+ * @property {number} [max=1000] - Maximum number of entries
+ * @property {number} [maxBytes=Infinity] - Byte budget over stored bodies
+ * @property {number} [ttl=60000] - Default TTL in milliseconds
+ * @property {"lru" | "tinylfu"} [admission="lru"] - Admission policy (see LRUCache)
+ * @property {number} [timeout=100] - Max wait (ms) for the primary; a late reply counts as a miss
+ */
+
+// ==========================================
+// Primary side
+// ==========================================
+
+const hosted = new Map();
+let hostInstalled = false;
+
+/**
+ * Serve shared cache requests from workers. Called by clusterize();
+ * only needed directly when workers are forked by hand.
+ */
+export function hostSharedCache() {
+  if (hostInstalled || !cluster.isPrimary) return;
+  hostInstalled = true;
+
+  cluster.on("message", (worker, msg) => {
+    if (!msg || msg.type !== MSG) return;
+
+    let cache = hosted.get(msg.name);
+    if (!cache) {
+      cache = new LRUCache(msg.options);
+      hosted.set(msg.name, cache);
+    }
+
+    switch (msg.op) {
+      case "get": {
+        // Workers with a stale window need expired entries kept that long
+        if (msg.stale > cache.staleRetention) cache.staleRetention = msg.stale;
+        const entry = cache.get(msg.key, msg.stale);
+        worker.send({
+          type: MSG,
+          id: msg.id,
+          entry: entry && { ...entry, value: entry.value.toString("latin1") },
+        });
+        break;
+      }
+      case "set":
+        // Stored as bytes, so maxBytes charges the body's real size
+        cache.set(
+          msg.key,
+          Buffer.from(msg.value, "latin1"),
+          msg.ttl,
+          msg.etag,
+          msg.contentType,
+        );
+        break;
+      case "delete":
+        cache.delete(msg.key);
+        break;
+      case "clear":
+        cache.clear();
+        break;
+    }
+  });
+}
+
+// ==========================================
+// Worker side
+// ==========================================
+
+const pending = new Map();
+let nextId = 0;
+let listenerInstalled = false;
+
+function installReplyListener() {
+  if (listenerInstalled) return;
+  listenerInstalled = true;
+
+  process.on("message", (msg) => {
+    if (!msg || msg.type !== MSG) return;
+    const waiter = pending.get(msg.id);
+    if (!waiter) return; // timed out already
+    pending.delete(msg.id);
+    clearTimeout(waiter.timer);
+    // Bodies travel as latin1 strings (byte-exact over JSON IPC)
+    const entry = msg.entry;
+    if (entry) entry.value = Buffer.from(entry.value, "latin1");
+    waiter.resolve(entry);
+  });
+}
+
+/**
+ * Response cache shared by all cluster workers.
+ * Same get/set/delete/clear API as LRUCache, but `get()` returns a Promise
+ * inside a worker. Outside of a worker it falls back to a local LRUCache.
+ */
+export class SharedCache {
+  /**
+   * @param {SharedCacheOptions} options
+   */
+  constructor(options = {}) {
+    this.name = options.name || "default";
+    this.options = {
+      max: options.max,
+      maxBytes: options.maxBytes,
+      ttl: options.ttl,
+      admission: options.admission,
+    };
+    this.ttl = options.ttl || 60000;
+    this.timeout = options.timeout || 100;
+    this.stats = createCacheStats(); // per worker
+
+    this.local =
+      cluster.isWorker && typeof process.send === "function"
+        ? null
+        : new LRUCache(this.options);
+
+    if (!this.local) installReplyListener();
+  }
+
+  /**
+   * Get entry from the shared cache
+   * @param {string} key
+   * @param {number} [stale=0] - Also return entries expired less than this many ms ago
+   * @returns {Promise<import("./cache.js").CacheEntry | null> | import("./cache.js").CacheEntry | null}
+   */
+  get(key, stale = 0) {
+    if (this.local) return this.local.get(key, stale);
+    if (!process.connected) return null;
+
+    const id = ++nextId;
+    return new Promise((resolve) => {
+      const timer = setTimeout(() => {
+        pending.delete(id);
+        resolve(null);
+      }, this.timeout);
+      pending.set(id, { resolve, timer });
+      this._send({ op: "get", id, key, stale });
+    });
+  }
+
+  /**
+   * Store a value as response bytes
+   * @param {string} key
+   * @param {Buffer | string | any} value - Body bytes, string, or data to JSON-serialize
+   * @param {number} [ttl]
+   * @param {string} [etag] - Precomputed ETag (derived from the bytes if omitted)
+   * @param {string} [contentType]
+   * @returns {import("./cache.js").CacheEntry}
+   */
+  set(key, value, ttl, etag, contentType) {
+    const bytes = Buffer.isBuffer(value)
+      ? value
+      : Buffer.from(typeof value === "string" ? value : JSON.stringify(value));
+    if (!etag) etag = LRUCache.etag(bytes);
+    if (!contentType) contentType = "application/json";
+
+    if (this.local) return this.local.set(key, bytes, ttl, etag, contentType);
+
+    this._send({
+      op: "set",
+      key,
+      value: bytes.toString("latin1"),
+      ttl,
+      etag,
+      contentType,
+    });
+    return {
+      value: bytes,
+      expires: Date.now() + (ttl || this.ttl),
+      etag,
+      contentType,
+    };
+  }
+
+  /**
+   * Delete entry from the shared cache
+   * @param {string} key
+   * @returns {boolean}
+   */
+  delete(key) {
+    if (this.local) return this.local.delete(key);
+    this._send({ op: "delete", key });
+    return true;
+  }
+
+  /**
+   * Clear all entries (in every worker)
+   */
+  clear() {
+    if (this.local) return this.local.clear();
+    this._send({ op: "clear" });
+  }
+
+  _send(msg) {
+    if (!process.connected) return;
+    msg.type = MSG;
+    msg.name = this.name;
+    msg.options = this.options;
+    process.send(msg);
+  }
+}
+
+/**
+ * Create a shared cache
+ * @param {SharedCacheOptions} options
+ * @returns {SharedCache}
+ */
+export function createSharedCache(options) {
+  return new SharedCache(options);
+}
+
+export default SharedCache;
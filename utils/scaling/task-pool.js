@@ -0,0 +1,344 @@
+/**
+ * Worker Thread Task Pool
+ * Runs CPU-heavy functions (image resize, PDF rendering, bcrypt, ...) on
+ * worker_threads so they never stall the event loop that serves requests.
+ *
+ * Each worker owns a job deque. New jobs are spread over the deques round-
+ * robin; a worker takes from the front of its own deque and, once that is
+ * empty, steals the newest job from the longest other deque. Workers start
+ * on first use and are unref'd while idle, so an unused pool costs nothing.
+ */
+import os from "os";
+import { Worker } from "worker_threads";
+import { pathToFileURL } from "url";
+import { Deque } from "../helpers/deque.js";
+import { Histogram } from "../helpers/histogram.js";
+
+const WORKER_URL = new URL("./task-worker.js", import.meta.url);
+
+/**
+ * Task pool configuration
+ * @typedef {Object} TaskPoolOptions
+ * @property {number} [size] - Worker threads (default: CPU count - 1, at least 1)
+ * @property {number} [maxQueue=Infinity] - Pending (queued + running) jobs before run() rejects
+ * @property {import("worker_threads").ResourceLimits} [resourceLimits] - Per-worker heap limits
+ */
+
+/**
+ * A task: a self-contained function (its source is sent to the workers, so
+ * it cannot use variables from the enclosing scope) or a module export.
+ * @typedef {Function | { module: string | URL, export?: string }} TaskDefinition
+ */
+
+/**
+ * Buffers that can be moved to another thread instead of copied: plain
+ * ArrayBuffers and views that span their whole buffer (pooled Buffer slabs
+ * are shared with other Buffers and stay behind). Looks two levels deep.
+ * SharedArrayBuffers are shared by reference anyway.
+ *
+ * @param {any} value
+ * @param {ArrayBuffer[]} [list]
+ * @returns {ArrayBuffer[]}
+ */
+export function collectTransferables(value, list = [], depth = 0) {
+  if (value === null || typeof value !== "object") return list;
+  if (value instanceof ArrayBuffer) {
+    if (!list.includes(value)) list.push(value);
+  } else if (ArrayBuffer.isView(value)) {
+    const buffer = value.buffer;
+    if (
+      buffer instanceof ArrayBuffer &&
+      value.byteLength === buffer.byteLength &&
+      !list.includes(buffer)
+    ) {
+      list.push(buffer);
+    }
+  } else if (
+    depth < 2 &&
+    (Array.isArray(value) || Object.getPrototypeOf(value) === Object.prototype)
+  ) {
+    for (const key in value) {
+      collectTransferables(value[key], list, depth + 1);
+    }
+  }
+  return list;
+}
+
+function toMessage(name, task) {
+  if (typeof task === "function") {
+    const source = task.toString();
+    if (source.includes("[native code]")) {
+      throw new TypeError(
+        `Task "${name}" must be a plain function (bound and native functions cannot be sent to a worker)`,
+      );
+    }
+    return { type: "define", name, source };
+  }
+  if (task && task.module) {
+    const mod = task.module;
+    const href =
+      mod instanceof URL
+        ? mod.href
+        : /^[a-z]+:/i.test(mod)
+          ? mod
+          : pathToFileURL(mod).href;
+    return { type: "define", name, module: href, export: task.export };
+  }
+  throw new TypeError(`Task "${name}" must be a function or { module }`);
+}
+
+function rebuildError(data) {
+  const err = new Error(data.message);
+  err.name = data.name;
+  if (data.stack) err.stack = data.stack;
+  if (data.code !== undefined) err.code = data.code;
+  return err;
+}
+
+/**
+ * Pool of worker threads with per-worker deques and work stealing
+ */
+export class TaskPool {
+  /**
+   * @param {TaskPoolOptions} [options]
+   */
+  constructor(options = {}) {
+    const cpus = os.availableParallelism?.() ?? os.cpus().length;
+    this.size = options.size || Math.max(1, cpus - 1);
+    this.maxQueue = options.maxQueue || Infinity;
+    this.resourceLimits = options.resourceLimits;
+
+    /** @type {Map<string, object>} define messages, replayed to new workers */
+    this.definitions = new Map();
+    this.slots = [];
+    this.pending = 0;
+    this.nextSlot = 0;
+    this.nextId = 0;
+    this.closed = false;
+
+    this.completed = 0;
+    this.failed = 0;
+    this.stolen = 0;
+    this.waitTime = new Histogram(); // queued → started
+    this.runTime = new Histogram(); // started → settled
+  }
+
+  /**
+   * Register a task under a name (replaces an earlier one)
+   * @param {string} name
+   * @param {TaskDefinition} task
+   */
+  define(name, task) {
+    const msg = toMessage(name, task);
+    if (msg.source !== undefined) {
+      // Surface syntax errors here rather than on the first run
+      try {
+        new Function(`return (${msg.source});`);
+      } catch {
+        new Function(`return ({ ${msg.source} });`);
+      }
+    }
+    this.definitions.set(name, msg);
+    for (const slot of this.slots) slot.worker.postMessage(msg);
+    return this;
+  }
+
+  /**
+   * Run a task on a worker
+   * @param {string} name
+   * @param {any[]} [args=[]] - Structured-cloned into the worker
+   * @param {{ transfer?: boolean | Transferable[] }} [options] - Move buffers instead of copying (true: detect them in args; the caller's copies become unusable)
+   * @returns {Promise<any>}
+   */
+  run(name, args = [], options) {
+    if (this.closed) return Promise.reject(new Error("Task pool is closed"));
+    if (!this.definitions.has(name)) {
+      return Promise.reject(new Error(`Unknown task "${name}"`));
+    }
+    if (this.pending >= this.maxQueue) {
+      const err = new Error("Task queue is full");
+      err.code = "ERR_TASK_QUEUE_FULL";
+      return Promise.reject(err);
+    }
+    if (this.slots.length === 0) this._start();
+
+    const transfer = options?.transfer;
+    return new Promise((resolve, reject) => {
+      const job = {
+        id: ++this.nextId,
+        name,
+        args,
+        transfer:
+          transfer === true ? collectTransferables(args) : transfer || [],
+        resolve,
+        reject,
+        queuedAt: performance.now(),
+        startedAt: 0,
+      };
+      this.pending++;
+
+      const slot = this.slots[this.nextSlot];
+      this.nextSlot = (this.nextSlot + 1) % this.slots.length;
+      slot.queue.push(job);
+      this._pump(slot);
+
+      // Owner is busy: let an idle worker take it right away
+      if (slot.current !== job) {
+        for (const other of this.slots) {
+          if (other.current === null) {
+            this._pump(other);
+            break;
+          }
+        }
+      }
+    });
+  }
+
+  _start() {
+    for (let i = 0; i < this.size; i++) {
+      this.slots.push({ worker: null, queue: new Deque(), current: null });
+      this._spawn(this.slots[i]);
+    }
+  }
+
+  _spawn(slot) {
+    const worker = new Worker(WORKER_URL, {
+      resourceLimits: this.resourceLimits,
+    });
+    slot.worker = worker;
+    worker.unref();
+    for (const msg of this.definitions.values()) worker.postMessage(msg);
+
+    worker.on("message", (msg) => this._settle(slot, msg));
+    worker.on("error", (err) => {
+      // Uncaught in the worker: fail its job; "exit" follows
+      const job = slot.current;
+      if (job && slot.worker === worker) {
+        this._finish(slot, job);
+        this.failed++;
+        job.reject(err);
+      }
+    });
+    worker.on("exit", () => {
+      if (slot.worker !== worker) return;
+      const job = slot.current;
+      if (job) {
+        this._finish(slot, job);
+        this.failed++;
+        job.reject(new Error("Task worker exited"));
+      }
+      if (this.closed) return;
+      // Replace it; its queued jobs are still in the deque
+      this._spawn(slot);
+      this._pump(slot);
+    });
+  }
+
+  _pump(slot) {
+    if (slot.current !== null) return;
+    let job = slot.queue.shift();
+    if (job === undefined) job = this._steal(slot);
+    if (job === undefined) return;
+
+    slot.current = job;
+    job.startedAt = performance.now();
+    this.waitTime.record(job.startedAt - job.queuedAt);
+    slot.worker.ref(); // keep the process alive while work is pending
+    try {
+      slot.worker.postMessage(
+        { type: "run", id: job.id, name: job.name, args: job.args },
+        job.transfer,
+      );
+    } catch (err) {
+      // Arguments that cannot be cloned
+      this._finish(slot, job);
+      this.failed++;
+      job.reject(err);
+      this._pump(slot);
+    }
+  }
+
+  _steal(thief) {
+    let victim = null;
+    for (const slot of this.slots) {
+      if (
+        slot !== thief &&
+        slot.queue.length > 0 &&
+        (victim === null || slot.queue.length > victim.queue.length)
+      ) {
+        victim = slot;
+      }
+    }
+    if (victim === null) return undefined;
+    this.stolen++;
+    return victim.queue.pop();
+  }
+
+  _finish(slot, job) {
+    slot.current = null;
+    this.pending--;
+    this.runTime.record(performance.now() - job.startedAt);
+    if (slot.queue.length === 0) slot.worker.unref();
+  }
+
+  _settle(slot, msg) {
+    const job = slot.current;
+    if (!job || job.id !== msg.id) return;
+    this._finish(slot, job);
+    if (msg.ok) {
+      this.completed++;
+      job.resolve(msg.value);
+    } else {
+      this.failed++;
+      job.reject(rebuildError(msg.error));
+    }
+    this._pump(slot);
+  }
+
+  /**
+   * Reject queued jobs and stop every worker
+   * @returns {Promise<void>}
+   */
+  async close() {
+    this.closed = true;
+    const err = new Error("Task pool is closed");
+    for (const slot of this.slots) {
+      let job;
+      while ((job = slot.queue.shift()) !== undefined) {
+        this.pending--;
+        job.reject(err);
+      }
+    }
+    await Promise.all(this.slots.map((slot) => slot.worker.terminate()));
+  }
+
+  /**
+   * Queue depth and latency (milliseconds)
+   */
+  get stats() {
+    return {
+      size: this.size,
+      started: this.slots.length > 0,
+      busy: this.slots.filter((s) => s.current !== null).length,
+      pending: this.pending,
+      queued: this.slots.reduce((n, s) => n + s.queue.length, 0),
+      queues: this.slots.map((s) => s.queue.length),
+      completed: this.completed,
+      failed: this.failed,
+      stolen: this.stolen,
+      wait: this.waitTime.toJSON(),
+      run: this.runTime.toJSON(),
+    };
+  }
+}
+
+/**
+ * Create a task pool
+ * @param {TaskPoolOptions} [options]
+ * @returns {TaskPool}
+ */
+export function createTaskPool(options) {
+  return new TaskPool(options);
+}
+
+export default TaskPool;
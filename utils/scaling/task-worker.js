@@ -0,0 +1,82 @@
+/**
+ * Task Pool Worker
+ * Runs inside a worker_threads Worker started by TaskPool. Receives task
+ * definitions (function source or module export) once, then runs jobs
+ * one at a time and posts each result back.
+ */
+import { parentPort } from "worker_threads";
+import { collectTransferables } from "./task-pool.js";
+
+/** @type {Map<string, Function | Promise<Function>>} */
+const tasks = new Map();
+
+// Function source as sent by the pool. Method shorthand
+// (`handle(req) { ... }`) is not an expression, so retry it as one.
+function compile(source) {
+  try {
+    return new Function(`return (${source});`)();
+  } catch (err) {
+    if (!(err instanceof SyntaxError)) throw err;
+    return Object.values(new Function(`return ({ ${source} });`)())[0];
+  }
+}
+
+function define(msg) {
+  if (msg.source !== undefined) {
+    tasks.set(msg.name, compile(msg.source));
+    return;
+  }
+  const loading = import(msg.module).then((mod) => {
+    const fn = mod[msg.export || "default"];
+    if (typeof fn !== "function") {
+      throw new TypeError(
+        `Task "${msg.name}": ${msg.module} has no function export "${msg.export || "default"}"`,
+      );
+    }
+    tasks.set(msg.name, fn);
+    return fn;
+  });
+  loading.catch(() => {}); // reported when the task first runs
+  tasks.set(msg.name, loading);
+}
+
+async function run(msg) {
+  try {
+    const fn = await tasks.get(msg.name);
+    if (typeof fn !== "function") {
+      throw new Error(`Unknown task "${msg.name}"`);
+    }
+    const value = await fn(...msg.args);
+    // The worker's copy is discarded anyway: move buffers, don't clone them
+    parentPort.postMessage(
+      { id: msg.id, ok: true, value },
+      collectTransferables(value),
+    );
+  } catch (err) {
+    parentPort.postMessage({
+      id: msg.id,
+      ok: false,
+      error: {
+        name: err?.name || "Error",
+        message: err?.message ?? String(err),
+        stack: err?.stack,
+        code: err?.code,
+      },
+    });
+  }
+}
+
+parentPort.on("message", (msg) => {
+  if (msg.type === "define") {
+    try {
+      define(msg);
+    } catch (err) {
+      // Keep the failure so every run of this task reports it
+      const failure = Promise.reject(err);
+      failure.catch(() => {});
+      tasks.set(msg.name, failure);
+    }
+  } else if (msg.type === "run") {
+    run(msg);
+  }
+});
@@ -3,6 +3,9 @@
 /// <reference types="node" />
 
 import { IncomingMessage, ServerResponse } from "http";
+import { Readable } from "stream";
+import { SecureContextOptions, TlsOptions } from "tls";
+import { ServerOptions as Http2ServerOptions } from "http2";
 
 // ==========================================
 // Core Data Structures
@@ -18,10 +21,52 @@ export interface UploadedFile {
   originalName?: string;
   /** MIME type of the file (e.g., "image/png") */
   type: string;
-  /** Absolute or relative path to the file on disk */
-  filePath: string;
+  /** Absolute or relative path to the file on disk (disk sink only) */
+  filePath?: string;
   /** File size in bytes */
   size: number;
+  /** Hex digest when `media.hash` is set */
+  hash?: string;
+  /** Extra fields returned by the sink's commit() */
+  [key: string]: any;
+}
+
+/** What is known about an uploaded file when its sink is opened */
+export interface UploadInfo {
+  /** Form field name */
+  field: string;
+  /** Original filename from the client */
+  filename: string;
+  mimeType: string;
+}
+
+/** An opened upload returned by UploadSink.open() */
+export interface UploadTarget {
+  /** Receives the file bytes (with backpressure) */
+  stream: NodeJS.WritableStream;
+  /** Runs after all bytes are written; fields are merged into UploadedFile */
+  commit?: () =>
+    | Promise<Record<string, any> | void>
+    | Record<string, any>
+    | void;
+  /** Runs when the upload fails or exceeds maxSize */
+  abort?: (err: Error) => Promise<void> | void;
+}
+
+/** Where uploaded file bytes go */
+export interface UploadSink {
+  open(info: UploadInfo): Promise<UploadTarget> | UploadTarget;
+}
+
+/** Object-store client driven by multipartSink() */
+export interface MultipartClient<U = any> {
+  create(info: UploadInfo): Promise<U>;
+  uploadPart(upload: U, partNumber: number, body: Buffer): Promise<any>;
+  complete(
+    upload: U,
+    parts: { partNumber: number; etag: any }[],
+  ): Promise<Record<string, any> | void>;
+  abort?(upload: U): Promise<void>;
 }
 
 /**
@@ -47,27 +92,77 @@ export interface MediaOptions {
    * @example ["image/jpeg", "image/png", "application/pdf"]
    */
   allowedTypes?: string[];
-  /** Enable streaming mode for large files. Use req.on('file', ...) */
+  /**
+   * Enable streaming mode for large files. Use req.on('file', ...).
+   * Large or chunked JSON bodies are left unread for parseJsonStream(req)
+   */
   streaming?: boolean;
+  /** JSON bodies above this many bytes are streamed (default: 1 MB) */
+  streamThreshold?: number;
+  /**
+   * Where file bytes go. Default: disk under `dest`.
+   * A function is called per file and must return a Writable
+   */
+  sink?:
+    | UploadSink
+    | ((
+        info: UploadInfo,
+      ) => NodeJS.WritableStream | Promise<NodeJS.WritableStream>);
+  /** Hash each file inline with this algorithm (e.g. "sha256") */
+  hash?: string;
+  /** Max files written at once across all requests to this route */
+  concurrency?: number;
 }
 
+/** JSON Schema primitive type names */
+export type JsonSchemaType =
+  | "string"
+  | "number"
+  | "integer"
+  | "boolean"
+  | "object"
+  | "array"
+  | "null";
+
 /**
- * JSON Schema property definition for schema-based serialization.
+ * JSON Schema property definition for schema-based serialization and
+ * body validation.
  */
 export interface JsonSchemaProperty {
-  /** The type of the property */
-  type:
-    | "string"
-    | "number"
-    | "integer"
-    | "boolean"
-    | "object"
-    | "array"
-    | "null";
+  /** The type of the property (an array allows several, e.g. ["string", "null"]) */
+  type?: JsonSchemaType | JsonSchemaType[];
+  /** Also allow `null` */
+  nullable?: boolean;
   /** Nested properties (for type: "object") */
   properties?: Record<string, JsonSchemaProperty>;
+  /** Properties that must be present */
+  required?: string[];
+  /** Keys not listed in `properties`: `false` rejects them (validation), a schema describes them */
+  additionalProperties?: boolean | JsonSchemaProperty;
   /** Item schema (for type: "array") */
   items?: JsonSchemaProperty;
+  /** Allowed values */
+  enum?: any[];
+  /** The only allowed value */
+  const?: any;
+  /** Local reference, e.g. "#/definitions/user" */
+  $ref?: string;
+  /** Reusable sub-schemas for `$ref` */
+  definitions?: Record<string, JsonSchemaProperty>;
+  $defs?: Record<string, JsonSchemaProperty>;
+  /** `"safe"`: string never needs JSON escaping (serialization) */
+  format?: string;
+  /** Value filled in for a missing property (with `schema.coerce`) */
+  default?: any;
+  minLength?: number;
+  maxLength?: number;
+  pattern?: string;
+  minimum?: number;
+  maximum?: number;
+  exclusiveMinimum?: number;
+  exclusiveMaximum?: number;
+  minItems?: number;
+  maxItems?: number;
 }
 
 /**
@@ -83,16 +178,20 @@ export interface JsonSchemaProperty {
  *   }
  * }
  */
-export interface JsonSchema extends JsonSchemaProperty {
-  type: "object" | "array";
-}
+export interface JsonSchema extends JsonSchemaProperty {}
 
 /**
  * Schema options for a route.
- * Used for pre-compiled response serialization (2-3x faster than JSON.stringify).
+ * Used for pre-compiled response serialization (2-3x faster than JSON.stringify),
+ * request body validation and typed query parsing.
  *
  * @example
  * {
+ *   body: {
+ *     type: "object",
+ *     required: ["name"],
+ *     properties: { name: { type: "string" } }
+ *   },
  *   response: {
  *     type: "object",
  *     properties: {
@@ -105,6 +204,12 @@ export interface JsonSchema extends JsonSchemaProperty {
 export interface SchemaOptions {
   /** Response schema for pre-compiled JSON serialization */
   response?: JsonSchema;
+  /** Request body schema, compiled into a validator; invalid bodies get a 400 */
+  body?: JsonSchema;
+  /** Query schema, compiled into a typed parser and validator; invalid queries get a 400 */
+  querystring?: JsonSchema;
+  /** Convert scalar strings to the declared type and fill `default`s in the body */
+  coerce?: boolean;
 }
 
 /**
@@ -139,11 +244,31 @@ export interface RouteOptions {
    * }
    */
   intercept?: Interceptor | Interceptor[];
+  /**
+   * Global interceptors (the functions passed to `app.plugin()`) that do
+   * not run for this route; `true` skips all of them.
+   * @example
+   * app.get("/health", { skipInterceptors: [auth, requestLogger] }, "ok");
+   */
+  skipInterceptors?: true | Interceptor | Interceptor[];
   /**
    * Configuration for file uploads (multipart/form-data).
    * Files will be available in req.files array.
    */
   media?: MediaOptions;
+  /**
+   * Run the handler on the worker thread pool instead of the event loop.
+   * The handler's source is sent to the workers, so it must be
+   * self-contained. It receives a TaskRequest (no `res`) and returns the
+   * response value.
+   */
+  offload?: boolean;
+  /**
+   * Load shedding for this route. `false` exempts it (health checks); a
+   * `Pool` sheds with 503 while the pool already has `max` callers
+   * queued; `limit` gives the route its own adaptive concurrency limit.
+   */
+  admission?: false | Pool | RouteAdmissionOptions;
   /**
    * JSON Schema for pre-compiled response serialization.
    * Generates a zero-overhead serializer at route registration time.
@@ -183,6 +308,20 @@ export interface LoggerConfig {
   prettyPrint?: boolean;
   /** Custom writable stream to output logs to (defaults to process.stdout) */
   stream?: NodeJS.WritableStream;
+  /**
+   * Batch records in memory and write them in chunks instead of one write
+   * per record. `true` uses the defaults. Flushed on exit and shutdown.
+   */
+  buffer?:
+    | boolean
+    | {
+        /** Buffer size in bytes; a full buffer is flushed. Default: 65536 */
+        size?: number;
+        /** Max time in ms a record waits before it is written. Default: 1000 */
+        interval?: number;
+        /** Write batches from a worker thread (stream must expose a numeric `fd`). Default: false */
+        worker?: boolean;
+      };
 }
 
 /**
@@ -208,11 +347,68 @@ export interface LoggerAPI {
   fatal(obj: object | string | Error, msg?: string, color?: ColorName): void;
   /** Returns a child logger with merged bindings (e.g., { reqId }) */
   child(bindings: Record<string, any>): LoggerAPI;
+  /** Synchronously writes out any buffered records (no-op without `buffer`) */
+  flush(): void;
 }
 
 export interface VibeConfig {
   /** Configuration for the native Vibe terminal logger */
   logger?: LoggerConfig | boolean;
+  /**
+   * Compile the route trie into one generated matcher function per HTTP
+   * method when `listen()` is called. Default: false
+   */
+  compiledRouter?: boolean;
+  /**
+   * Param routes above which the trie replaces linear matching. "auto"
+   * times both on the app's routes at listen(). Default: 20
+   */
+  trieThreshold?: number | "auto";
+  /** Static file engine options for the public folder */
+  static?: StaticOptions;
+  /** When handler results are written incrementally as a JSON array */
+  streaming?: StreamingOptions;
+  /** Largest JSON request body in bytes; larger ones get a 413. Default: 1000000 */
+  maxJsonSize?: number;
+  /** Worker thread pool behind app.task() and offloaded routes */
+  tasks?: TaskPoolOptions;
+  /** Adaptive concurrency limit for the whole app; excess requests get a 503. Default: off */
+  admission?: boolean | AdmissionOptions;
+  /** On shutdown, time in-flight requests get to finish (ms). Default: 10000 */
+  drainTimeout?: number;
+  /** Per-route request metrics served at `metrics.path`. Default: off */
+  metrics?: boolean | MetricsOptions;
+  /** Per-phase timing of sampled requests (spans, flame summaries). Default: off */
+  trace?: boolean | TraceOptions;
+  /** Serve HTTPS with these TLS options (`key`, `cert`, ...). Default: plain HTTP */
+  https?: SecureContextOptions & TlsOptions;
+  /**
+   * Serve HTTP/2. With `https`: TLS with ALPN and an HTTP/1.1 fallback
+   * (`allowHTTP1`); without: cleartext h2c. Default: false
+   */
+  http2?: boolean | Http2ServerOptions;
+}
+
+export interface StreamingOptions {
+  /** Arrays from routes with an array response schema stream at this length. Default: 1000 */
+  minItems?: number;
+  /** Characters buffered per `res.write()`. Default: 16384 */
+  chunkSize?: number;
+}
+
+export interface StaticOptions {
+  /** Files up to this size in bytes are held in memory. Default: 65536 */
+  inlineSize?: number;
+  /** Idle file descriptors kept open for large files. Default: 64 */
+  maxFds?: number;
+  /** Watch the public folder and keep the manifest current. Default: true */
+  watch?: boolean;
+  /** Generate missing .br/.gz variants in the background. Default: false */
+  compress?: boolean;
+  /** Smallest file in bytes worth compressing. Default: 1024 */
+  compressMinSize?: number;
+  /** Largest file in bytes compressed into memory. Default: 10485760 */
+  compressMaxSize?: number;
 }
 
 // ==========================================
@@ -225,8 +421,11 @@ export interface VibeConfig {
 export interface VibeRequest extends IncomingMessage {
   /** Route parameters extracted from the URL (e.g., `/users/:id`) */
   params: Record<string, string>;
-  /** Query string parameters (e.g., `?page=2`) */
-  query: Record<string, string>;
+  /**
+   * Query string parameters (e.g., `?page=2`): strings, an array for a
+   * repeated key, "" for a bare flag; typed with `schema.querystring`
+   */
+  query: Record<string, any>;
   /** Parsed body of the request */
   body: Record<string, any>;
   /** Uploaded files array (if multipart/form-data) */
@@ -235,10 +434,12 @@ export interface VibeRequest extends IncomingMessage {
   ip?: string;
   /** Detailed client IP info */
   fullIp?: string;
-  /** Automatically generated UUID for the request lifecycle */
+  /** Unique request ID (per-process prefix + counter), formatted on first read */
   id: string;
   /** Context-bound logger automatically stamped with the req.id constraint */
   log: LoggerAPI;
+  /** Matched route record (set before route interceptors run) */
+  route?: { method: string; path: string; handler: Handler | any };
   /** Custom properties added via decorateRequest */
   [key: string]: any;
 }
@@ -284,11 +485,21 @@ export interface VibeResponse extends ServerResponse {
 // Handlers & Interceptors
 // ==========================================
 
-/** Route handler function */
+/**
+ * Route handler function. Async iterables and Readables are written
+ * incrementally as a JSON array (byte Readables are piped as-is).
+ */
 export type Handler = (
   req: VibeRequest,
   res: VibeResponse,
-) => void | Promise<void> | object | string | number;
+) =>
+  | void
+  | Promise<void>
+  | object
+  | string
+  | number
+  | AsyncIterable<any>
+  | Readable;
 
 /** Middleware/interceptor function */
 export type Interceptor = (
@@ -430,19 +641,44 @@ export interface VibeApp extends RouterAPI {
   decorate: (name: string, value: any) => void;
 
   /**
-   * Decorate request objects with a custom property
+   * Decorate request objects with a custom property.
+   * Throws if the name clashes with a built-in request property.
    * @param name Property name
-   * @param value Property value or factory function
+   * @param value Property value, or factory function run on first read (once per request)
    */
   decorateRequest: (name: string, value: any) => void;
 
   /**
-   * Decorate response objects with a custom property
+   * Decorate response objects with a custom property or method.
+   * Throws if the name clashes with a built-in response method.
    * @param name Property name
-   * @param value Property value or factory function
+   * @param value Property value; functions become methods (`this` is the response)
    */
   decorateReply: (name: string, value: any) => void;
 
+  /**
+   * Register a function to run on the worker thread pool.
+   * Function tasks must be self-contained; use `{ module, export }` for
+   * code with imports.
+   * @returns Runs the task with the given arguments
+   */
+  task: <R = any>(
+    name: string,
+    fn: TaskDefinition,
+  ) => (...args: any[]) => Promise<R>;
+
+  /** The app's worker thread pool (created on first use) */
+  readonly tasks: TaskPool;
+
+  /** The app-wide admission controller (null unless `admission` is configured) */
+  readonly admission: AdmissionController | null;
+
+  /** Request metrics (null unless `metrics` is configured) */
+  readonly metrics: Metrics | null;
+
+  /** Request tracer (null unless `trace` is configured) */
+  readonly tracer: Tracer | null;
+
   /**
    * Group routes under prefix or include sub-router (legacy)
    */
@@ -497,30 +733,79 @@ export default function vibe(config?: VibeConfig): VibeApp;
 export interface CacheOptions {
   /** Maximum number of entries. Default: 1000 */
   max?: number;
+  /** Byte budget over stored value sizes (serialized size for objects). Default: Infinity */
+  maxBytes?: number;
   /** Default TTL in milliseconds. Default: 60000 */
   ttl?: number;
+  /** Expiry bucket width and sweep period in ms. Default: 1000 */
+  sweepInterval?: number;
+  /**
+   * Admission policy. "tinylfu" only admits a new key over the LRU victim
+   * when it has been requested at least as often. Default: "lru"
+   */
+  admission?: "lru" | "tinylfu";
+}
+
+export interface CacheStats {
+  /** Served from a fresh entry */
+  hits: number;
+  /** Ran the handler to fill the cache */
+  misses: number;
+  /** Served an expired entry inside the stale window */
+  stale: number;
+  /** Waited on another request's in-flight handler */
+  coalesced: number;
+}
+
+export interface CacheMiddlewareOptions {
+  /**
+   * Window in ms after expiry in which the old entry is served immediately
+   * while one background refresh runs. Default: 0
+   */
+  staleWhileRevalidate?: number;
 }
 
 export interface CacheEntry {
+  /** Cached value (a Buffer body when set by cacheMiddleware) */
   value: any;
   expires: number;
   etag: string;
+  /** Content-Type of a cached body */
+  contentType?: string;
 }
 
 export class LRUCache {
   constructor(options?: CacheOptions);
 
+  /** Counters maintained by cacheMiddleware */
+  stats: CacheStats;
+
+  /** Total stored bytes (tracked when maxBytes is set) */
+  readonly bytes: number;
+
+  /** Expired entries are kept this long for stale reads (raised by cacheMiddleware) */
+  staleRetention: number;
+
+  /** Reclaim expired entries now (also runs on the sweep timer); returns the count removed */
+  prune(): number;
+
   /** Generate cache key from request */
   static key(method: string, url: string): string;
 
-  /** Generate ETag from value */
-  static etag(value: any): string;
+  /** Generate ETag from value (FNV-1a over its bytes) */
+  static etag(value: Buffer | string | any): string;
 
-  /** Get value from cache */
-  get(key: string): CacheEntry | null;
+  /** Get value from cache (`stale`: also return entries expired less than this many ms ago) */
+  get(key: string, stale?: number): CacheEntry | null;
 
-  /** Set value in cache */
-  set(key: string, value: any, ttl?: number): CacheEntry;
+  /** Set value in cache (etag is derived from value if omitted) */
+  set(
+    key: string,
+    value: any,
+    ttl?: number,
+    etag?: string,
+    contentType?: string,
+  ): CacheEntry;
 
   /** Delete entry from cache */
   delete(key: string): boolean;
@@ -535,10 +820,61 @@ export class LRUCache {
   has(key: string): boolean;
 }
 
+export interface SharedCacheOptions extends CacheOptions {
+  /** Cache namespace on the primary. Default: "default" */
+  name?: string;
+  /** Max wait for the primary in ms; a late reply counts as a miss. Default: 100 */
+  timeout?: number;
+}
+
+/**
+ * Response cache shared by all cluster workers, hosted by the primary and
+ * reached over cluster IPC. Values are stored as response bytes.
+ * Outside a worker it falls back to a local LRUCache.
+ */
+export class SharedCache {
+  constructor(options?: SharedCacheOptions);
+
+  /** Counters maintained by cacheMiddleware (per worker) */
+  stats: CacheStats;
+
+  /** Get entry (a Promise inside a cluster worker) */
+  get(
+    key: string,
+    stale?: number,
+  ): Promise<CacheEntry | null> | CacheEntry | null;
+
+  /** Store body bytes, a string, or data to JSON-serialize */
+  set(
+    key: string,
+    value: Buffer | string | any,
+    ttl?: number,
+    etag?: string,
+    contentType?: string,
+  ): CacheEntry;
+
+  /** Delete entry from the shared cache */
+  delete(key: string): boolean;
+
+  /** Clear all entries for every worker */
+  clear(): void;
+}
+
+export function createSharedCache(options?: SharedCacheOptions): SharedCache;
+
+/**
+ * Serve SharedCache requests from workers. clusterize() calls this for you;
+ * only needed when forking workers by hand.
+ */
+export function hostSharedCache(): void;
+
 /**
  * Create cache middleware for route-level caching
  */
-export function cacheMiddleware(cache: LRUCache): Interceptor;
+export function cacheMiddleware(
+  cache: LRUCache | SharedCache,
+  options?: CacheMiddlewareOptions,
+): Interceptor;
 
 // ==========================================
 // Connection Pool
@@ -549,16 +885,20 @@ export interface PoolOptions<T> {
   create: () => Promise<T>;
   /** Async function to destroy a resource */
   destroy: (resource: T) => Promise<void>;
-  /** Function to validate a resource is still usable */
-  validate?: (resource: T) => boolean;
+  /** Function (sync or async) to validate a resource is still usable */
+  validate?: (resource: T) => boolean | Promise<boolean>;
   /** Minimum pool size. Default: 0 */
   min?: number;
   /** Maximum pool size. Default: 10 */
   max?: number;
+  /** Idle resources to keep ready, refilled in the background. Default: 0 */
+  minIdle?: number;
   /** Timeout for acquiring resource (ms). Default: 30000 */
   acquireTimeout?: number;
   /** Time before idle resources are destroyed (ms). Default: 60000 */
   idleTimeout?: number;
+  /** Validate idle resources every N ms and replace failures. Default: 0 (on acquire only) */
+  validateInterval?: number;
 }
 
 export interface PoolStats {
@@ -566,6 +906,16 @@ export interface PoolStats {
   inUse: number;
   waiting: number;
   max: number;
+  /** Everything counted against max (including creating/destroying) */
+  size: number;
+  creating: number;
+  destroying: number;
+  created: number;
+  destroyed: number;
+  createErrors: number;
+  timeouts: number;
+  /** Acquire wait time (ms) */
+  wait: LatencySummary;
 }
 
 export class Pool<T = any> {
@@ -592,6 +942,281 @@ export class Pool<T = any> {
  */
 export function createPool<T>(options: PoolOptions<T>): Pool<T>;
 
+// ==========================================
+// Worker Thread Task Pool
+// ==========================================
+
+export interface TaskPoolOptions {
+  /** Worker threads. Default: CPU count - 1 (at least 1) */
+  size?: number;
+  /** Pending (queued + running) jobs before run() rejects. Default: Infinity */
+  maxQueue?: number;
+  /** Per-worker V8 heap limits */
+  resourceLimits?: import("worker_threads").ResourceLimits;
+}
+
+/** A self-contained function, or a module export loaded in each worker */
+export type TaskDefinition =
+  | ((...args: any[]) => any)
+  | { module: string | URL; export?: string };
+
+/** What an offloaded route handler receives instead of `req` */
+export interface TaskRequest {
+  method: string;
+  url: string;
+  params: Record<string, string>;
+  query: Record<string, any>;
+  headers: Record<string, string | string[] | undefined>;
+  body: any;
+  ip?: string;
+  id: string;
+}
+
+/** Latency summary in milliseconds */
+export interface LatencySummary {
+  count: number;
+  mean: number;
+  p50: number;
+  p90: number;
+  p99: number;
+  max: number;
+}
+
+export interface TaskPoolStats {
+  size: number;
+  started: boolean;
+  busy: number;
+  pending: number;
+  queued: number;
+  /** Queued jobs per worker */
+  queues: number[];
+  completed: number;
+  failed: number;
+  /** Jobs taken by an idle worker from another worker's queue */
+  stolen: number;
+  /** Time from run() until a worker started the job */
+  wait: LatencySummary;
+  /** Time the job spent on the worker */
+  run: LatencySummary;
+}
+
+export class TaskPool {
+  constructor(options?: TaskPoolOptions);
+
+  /** Register (or replace) a task */
+  define(name: string, task: TaskDefinition): this;
+
+  /**
+   * Run a task. `transfer: true` moves whole-buffer ArrayBuffers found in
+   * args instead of copying them (the caller's copies become unusable).
+   */
+  run<R = any>(
+    name: string,
+    args?: any[],
+    options?: { transfer?: boolean | ArrayBuffer[] },
+  ): Promise<R>;
+
+  /** Reject queued jobs and stop all workers */
+  close(): Promise<void>;
+
+  readonly stats: TaskPoolStats;
+}
+
+export function createTaskPool(options?: TaskPoolOptions): TaskPool;
+
+// ==========================================
+// Admission Control
+// ==========================================
+
+export interface AdmissionOptions {
+  /** Limit algorithm. Default: "gradient" */
+  algorithm?: "gradient" | "aimd";
+  /** Starting concurrency limit. Default: 20 */
+  initialLimit?: number;
+  /** Default: 1 */
+  minLimit?: number;
+  /** Default: 1000 */
+  maxLimit?: number;
+  /** aimd: latency (ms) counted as overload. Default: 2000 */
+  timeout?: number;
+  /** Multiplier applied to the limit on overload. Default: 0.9 */
+  backoff?: number;
+  /** gradient: latency ratio tolerated before shrinking. Default: 1.5 */
+  tolerance?: number;
+  /** gradient: weight of each new limit. Default: 0.2 */
+  smoothing?: number;
+  /** p99 event-loop delay (ms) counted as overload; 0 disables. Default: 100 */
+  maxEventLoopDelay?: number;
+  /** Status for shed requests. Default: 503 */
+  status?: 503 | 429 | number;
+  /** Retry-After seconds for shed requests. Default: 1 */
+  retryAfter?: number;
+}
+
+export interface RouteAdmissionOptions {
+  /** Shed while this pool has `maxWaiting` callers queued */
+  pool?: Pool;
+  /** Default: the pool's max */
+  maxWaiting?: number;
+  /** Own adaptive limit instead of the app-wide one */
+  limit?: boolean | AdmissionOptions;
+  status?: number;
+  /** Default: from the pool's p90 wait time, else the controller's */
+  retryAfter?: number;
+}
+
+export interface AdmissionStats {
+  algorithm: "gradient" | "aimd";
+  limit: number;
+  inflight: number;
+  admitted: number;
+  shed: number;
+  /** Latest latency sample (ms) */
+  rtt: number;
+  /** Long-term average latency (ms, gradient) */
+  longRtt: number;
+  /** p99 event-loop delay over the last interval (ms) */
+  eventLoopDelay: number;
+  overloaded: boolean;
+}
+
+export class AdmissionController {
+  constructor(options?: AdmissionOptions);
+
+  /** Claim a slot: the start time, or -1 when the request should be shed */
+  acquire(): number;
+
+  /** Return a slot; `sample: false` skips the limit update (client aborts) */
+  release(start: number, sample?: boolean): void;
+
+  /** Stop sampling the event loop */
+  close(): void;
+
+  readonly stats: AdmissionStats;
+}
+
+export function createAdmission(options?: AdmissionOptions): AdmissionController;
+
+// ==========================================
+// Metrics
+// ==========================================
+
+export interface MetricsOptions {
+  /** Route serving the scrape. Default: "/metrics" */
+  path?: string;
+  /** Cluster workers push to the primary this often (ms). Default: 5000 */
+  interval?: number;
+  /** Max wait (ms) for the primary's merged scrape. Default: 1000 */
+  timeout?: number;
+}
+
+export interface HostMetricsOptions {
+  port?: number;
+  /** Default: "0.0.0.0" */
+  host?: string;
+  /** Default: "/metrics" */
+  path?: string;
+}
+
+export class Metrics {
+  constructor(options?: MetricsOptions);
+
+  readonly path: string;
+
+  /** Record one response (route id 0: unmatched) */
+  record(id: number, status: number, ms: number): void;
+
+  /** Metrics text for this process, or merged by the primary in cluster mode */
+  scrape(openMetrics?: boolean): string | Promise<string | null>;
+
+  /** Stop pushing and sampling */
+  close(): void;
+}
+
+/** Merge metrics pushed by workers (called by clusterize) */
+export function hostMetrics(options?: HostMetricsOptions): object | undefined;
+
+/** Render a metrics snapshot as Prometheus text or OpenMetrics */
+export function formatMetrics(snapshot: object, openMetrics?: boolean): string;
+
+// ==========================================
+// Tracing
+// ==========================================
+
+/** Called with the time (ms) a sampled request spent in a phase */
+export type PhaseHook = (req: VibeRequest, ms: number) => void;
+
+export interface OtelAttribute {
+  key: string;
+  value: { stringValue: string } | { intValue: string };
+}
+
+/** Span in OTLP/JSON shape */
+export interface OtelSpan {
+  traceId: string;
+  spanId: string;
+  /** Empty for a root span */
+  parentSpanId: string;
+  name: string;
+  /** 1: internal (phase), 2: server (request) */
+  kind: 1 | 2;
+  startTimeUnixNano: string;
+  endTimeUnixNano: string;
+  attributes: OtelAttribute[];
+  /** 0: unset, 2: error */
+  status: { code: 0 | 2 };
+}
+
+export interface TraceOptions {
+  /** Fraction of requests traced; a sampled `traceparent` always is. Default: 1 */
+  sampleRate?: number;
+  /** Each finished span: phase spans first, then the request span */
+  onSpan?: (span: OtelSpan) => void;
+  /** Route matched */
+  onRoute?: PhaseHook;
+  /** Body read and parsed */
+  onBodyParsed?: PhaseHook;
+  /** Handler returned (or its promise settled) */
+  onHandler?: PhaseHook;
+  /** Result serialized and written */
+  onSerialize?: PhaseHook;
+}
+
+/** Mean milliseconds per phase of one route */
+export interface RouteTrace {
+  count: number;
+  total: number;
+  routing: number;
+  interceptors: number;
+  body: number;
+  validation: number;
+  handler: number;
+  serialize: number;
+}
+
+export class Tracer {
+  constructor(options?: TraceOptions);
+
+  readonly sampleRate: number;
+  /** Requests traced so far */
+  readonly sampled: number;
+
+  /** Mean time per phase, keyed by "METHOD /path" ("unmatched" for 404s) */
+  summary(): Record<string, RouteTrace>;
+
+  /** Total microseconds per route and phase, one `route;phase us` line each */
+  folded(): string;
+
+  /** Forget the collected totals */
+  reset(): void;
+}
+
+/** Wrap spans in an OTLP/JSON export request (POST to /v1/traces) */
+export function toOtlp(
+  spans: OtelSpan[],
+  serviceName?: string,
+): { resourceSpans: object[] };
+
 // ==========================================
 // Cluster Mode
 // ==========================================
@@ -603,6 +1228,20 @@ export interface ClusterOptions {
   restart?: boolean;
   /** Delay before restarting (ms). Default: 1000 */
   restartDelay?: number;
+  /**
+   * Each worker binds its own SO_REUSEPORT socket and the kernel balances
+   * accepts (Node >= 22.12 / 23.1 on Linux). Falls back to the primary's
+   * round-robin elsewhere. Default: false
+   */
+  reusePort?: boolean;
+  /** Time a retiring worker gets to finish in-flight requests (ms). Default: 10000 */
+  drainTimeout?: number;
+  /** Time a new worker gets to start listening during a reload (ms). Default: 30000 */
+  startTimeout?: number;
+  /** Signal that starts a rolling reload; false disables. Default: "SIGHUP" */
+  reloadSignal?: NodeJS.Signals | false;
+  /** Also serve the workers' merged metrics from the primary on this port */
+  metrics?: HostMetricsOptions;
   /** Called when worker starts */
   onWorkerStart?: (worker: any) => void;
   /** Called when worker exits */
@@ -614,6 +1253,15 @@ export interface ClusterOptions {
  */
 export function clusterize(startFn: () => void, options?: ClusterOptions): void;
 
+/**
+ * Rolling reload from the primary: start a replacement worker, wait until
+ * it listens, then drain the old one; one worker at a time
+ */
+export function reloadWorkers(): Promise<void>;
+
+/** Whether this Node.js build can listen with `reusePort` */
+export function supportsReusePort(): boolean;
+
 /** Check if current process is the primary */
 export function isPrimary(): boolean;
 
@@ -630,15 +1278,47 @@ export function getWorkerCount(): number;
 // Streaming Utilities
 // ==========================================
 
+/** Options for incremental JSON parsing */
+export interface JsonStreamOptions {
+  /** Max bytes of a single selected value (default: unlimited) */
+  maxItemSize?: number;
+}
+
 /**
- * Parse JSON stream (line-delimited JSON)
+ * Parse a JSON body incrementally and resolve with the whole document
  */
 export function parseJsonStream(
   stream: NodeJS.ReadableStream,
-  onData: (data: any) => void,
-  onEnd?: () => void,
-  onError?: (err: Error) => void,
-): void;
+): Promise<any>;
+
+/**
+ * Yield each value matched by a path (e.g. `"$.items[*]"`) as bytes arrive.
+ * Memory is bounded by the largest selected value.
+ */
+export function parseJsonStream<T = any>(
+  stream: NodeJS.ReadableStream,
+  path: string,
+  options?: JsonStreamOptions,
+): AsyncGenerator<T>;
+
+/** Write uploads into an absolute directory under unique names */
+export function diskSink(options: { dir: string }): UploadSink;
+
+/**
+ * Upload files as fixed-size parts to an object store (S3-style).
+ * At most `queueSize` parts are in flight per file (default 4).
+ */
+export function multipartSink<U = any>(
+  client: MultipartClient<U>,
+  options?: { partSize?: number; queueSize?: number },
+): UploadSink;
+
+/** Hand each file to a Writable created by the application */
+export function writableSink(
+  create: (
+    info: UploadInfo,
+  ) => NodeJS.WritableStream | Promise<NodeJS.WritableStream>,
+): UploadSink;
 
 // ==========================================
 // Express Middleware Adapter
@@ -1,11 +1,25 @@
+import crypto from "crypto";
 import server from "./utils/core/server.js";
 import { adapt } from "./utils/helpers/adapt.js";
 import { color } from "./utils/helpers/colors.js";
 import { RouteTrie } from "./utils/core/trie.js";
 import { PathToRegex } from "./utils/core/handler.js";
 import { compileSerializer } from "./utils/core/compile-serializer.js";
+import { compileValidator } from "./utils/core/compile-validator.js";
+import { compileQuery } from "./utils/core/compile-query.js";
 import { createLogger, Logger } from "./utils/core/logger.js";
 import { handleError } from "./utils/core/handler.js";
+import { getStaticFiles } from "./utils/core/static.js";
+import {
+  installReplyDecorator,
+  installRequestDecorator,
+} from "./utils/core/decorators.js";
+import { createLimiter, writableSink } from "./utils/core/upload-sinks.js";
+import { TaskPool } from "./utils/scaling/task-pool.js";
+import { AdmissionController } from "./utils/scaling/admission.js";
+import { Metrics } from "./utils/scaling/metrics.js";
+export { Tracer, toOtlp } from "./utils/core/tracing.js";
+import { Tracer } from "./utils/core/tracing.js";
 
 /**
  * Helper to generate regex for a path
@@ -16,6 +30,51 @@ function pathToRegex(path) {
   return PathToRegex(path).pathRegex;
 }
 
+/**
+ * Route media options with defaults applied. A bare function sink is
+ * wrapped as a Writable sink, and `concurrency` becomes a limiter shared
+ * by every request to the route.
+ * @param {MediaOptions} media
+ * @returns {MediaOptions}
+ */
+function resolveMedia(media) {
+  const resolved = {
+    public: true,
+    dest: null,
+    maxSize: 10 * 1024 * 1024,
+    allowedTypes: null,
+    ...media,
+  };
+  if (typeof resolved.sink === "function") {
+    resolved.sink = writableSink(resolved.sink);
+  }
+  if (resolved.concurrency > 0) {
+    resolved.limiter = createLimiter(resolved.concurrency);
+  }
+  return resolved;
+}
+
+/**
+ * Route admission options. A bare Pool (or `{ pool }`) sheds requests
+ * while the pool already has `maxWaiting` callers queued (default: its
+ * `max`); `limit` gives the route its own adaptive limit instead of the
+ * app-wide one.
+ * @param {false | import("./utils/scaling/pool.js").Pool | Object} admission
+ * @returns {false | Object}
+ */
+function resolveAdmission(admission) {
+  if (admission === false) return false;
+  const resolved =
+    typeof admission.acquire === "function"
+      ? { pool: admission }
+      : { ...admission };
+  if (resolved.pool) resolved.maxWaiting ??= resolved.pool.max;
+  resolved.controller = resolved.limit
+    ? new AdmissionController(resolved.limit === true ? {} : resolved.limit)
+    : null;
+  return resolved;
+}
+
 /**
  * @typedef {import("http").IncomingMessage} IncomingMessage
  * @typedef {import("http").ServerResponse} ServerResponse
@@ -80,14 +139,20 @@ function pathToRegex(path) {
  * @property {string|null} [dest] Subfolder inside public or root
  * @property {number} [maxSize] Max file size in bytes
  * @property {string[]} [allowedTypes] Allowed MIME types (e.g., ["image/png", "image/jpeg"])
+ * @property {import("./utils/core/upload-sinks.js").UploadSink | ((info: import("./utils/core/upload-sinks.js").UploadInfo) => import("stream").Writable)} [sink] Where file bytes go (default: disk under dest)
+ * @property {string} [hash] Hash each file inline with this algorithm (e.g. "sha256")
+ * @property {number} [concurrency] Max files written at once across all requests to the route
  */
 
 /**
  * Additional route configuration.
  * @typedef {Object} RouteOptions
  * @property {Interceptor | Interceptor[]} [intercept]
+ * @property {true | Interceptor | Interceptor[]} [skipInterceptors] Global interceptors (as passed to plugin()) not to run for this route; true skips all
  * @property {MediaOptions} [media]
- * @property {{ response?: Object }} [schema] Schema for pre-compiled serialization
+ * @property {{ response?: Object, body?: Object, querystring?: Object, coerce?: boolean }} [schema] Schemas compiled at registration: response serializer, body validator (coerce: convert scalar strings, fill defaults), typed query parser and validator
+ * @property {boolean} [offload] Run the handler on the worker thread pool (it receives a plain request snapshot, no `res`)
+ * @property {false | import("./utils/scaling/pool.js").Pool | { pool?: import("./utils/scaling/pool.js").Pool, maxWaiting?: number, limit?: boolean | import("./utils/scaling/admission.js").AdmissionOptions, status?: number, retryAfter?: number }} [admission] Load shedding: false exempts the route; a Pool sheds while it is saturated
  */
 
 /**
@@ -98,11 +163,21 @@ function pathToRegex(path) {
  * @property {RegExp | null} pathRegex
  * @property {Handler | string | number | object} handler
  * @property {Interceptor | Interceptor[] | null} intercept
+ * @property {true | Interceptor[] | null} [skipInterceptors]
+ * @property {Function} [_dispatch] Composed pipeline, built at listen()
  * @property {((data: any) => string) | null} serialize
+ * @property {((body: any) => string | null) | null} validate
+ * @property {((qs: string) => Record<string, any>) | null} parseQuery
+ * @property {((query: any) => string | null) | null} validateQuery
  * @property {MediaOptions | null} media
+ * @property {string | null} [offload] Task name when the handler runs on the worker pool
+ * @property {false | Object | null} [admission] Resolved admission options (null: app-wide only)
  * @property {boolean} [isStatic]
  * @property {number} [_handlerType]
  * @property {string | null} [_prebuilt]
+ * @property {Buffer} [_prebuiltBody] Encoded once at registration
+ * @property {Object} [_prebuiltHeaders] content-type, content-length and etag
+ * @property {string} [_etag] Strong ETag of the prebuilt body
  */
 
 /**
@@ -133,6 +208,18 @@ function pathToRegex(path) {
  * Initializes a Vibe application instance.
  * @param {Object} [config={}]
  * @param {Object|boolean} [config.logger] - Logger configuration
+ * @param {boolean} [config.compiledRouter=false] - Compile the route trie into generated matchers at listen()
+ * @param {number | "auto"} [config.trieThreshold] - Param routes above which the trie replaces linear matching ("auto": time both at listen())
+ * @param {Object} [config.static] - Static file engine options (inlineSize, maxFds, watch)
+ * @param {Object} [config.streaming] - Incremental JSON thresholds (minItems, chunkSize)
+ * @param {number} [config.maxJsonSize=1e6] - Largest JSON body in bytes (larger ones get a 413)
+ * @param {number} [config.drainTimeout=10000] - On shutdown, time in-flight requests get to finish (ms)
+ * @param {import("tls").SecureContextOptions & import("tls").TlsOptions} [config.https] - Serve HTTPS with these TLS options (key, cert, ...)
+ * @param {boolean | import("http2").ServerOptions} [config.http2] - Serve HTTP/2 (with https: TLS plus HTTP/1.1 fallback; without: cleartext h2c)
+ * @param {boolean | import("./utils/scaling/metrics.js").MetricsOptions} [config.metrics] - Per-route request metrics served at metrics.path (default: off)
+ * @param {boolean | import("./utils/core/tracing.js").TraceOptions} [config.trace] - Per-phase request timing, OpenTelemetry spans and flame summaries (default: off)
+ * @param {import("./utils/scaling/task-pool.js").TaskPoolOptions} [config.tasks] - Worker thread pool for app.task() and offloaded routes
+ * @param {boolean | import("./utils/scaling/admission.js").AdmissionOptions} [config.admission] - Adaptive concurrency limit; excess requests get a 503 (default: off)
  * @returns {VibeApp}
  */
 const vibe = (config = {}) => {
@@ -142,8 +229,10 @@ const vibe = (config = {}) => {
   // Route array for O(n) matching (used when routes <= threshold)
   const routes = [];
 
-  // Threshold for switching between linear and trie matching
-  const TRIE_THRESHOLD = 50;
+  // Param routes above which the trie replaces linear matching. Measured
+  // (tests/bench/micro.js): linear wins up to ~16 param routes, the trie
+  // from ~24, on API-shaped routes with Zipf-skewed traffic
+  const TRIE_THRESHOLD = 20;
 
   // Static routes Map for O(1) lookup (routes without params)
   const staticRoutes = new Map();
@@ -162,8 +251,28 @@ const vibe = (config = {}) => {
     routes,
     staticRoutes,
     routeCount: 0,
-    trieThreshold: TRIE_THRESHOLD,
+    trieThreshold: config.trieThreshold ?? TRIE_THRESHOLD,
+    compiledRouter: config.compiledRouter === true,
+    maxJsonSize: config.maxJsonSize || 1e6,
+    drainTimeout: config.drainTimeout || 10000,
+    https: config.https || null,
+    http2: config.http2 || false,
     publicFolder: "public",
+    static: config.static || {},
+    staticFiles: null,
+    streaming: { minItems: 1000, chunkSize: 16 * 1024, ...config.streaming },
+    tasks: null, // TaskPool, created on first app.task() / offload route
+    admission: config.admission
+      ? new AdmissionController(
+          config.admission === true ? {} : config.admission,
+        )
+      : null,
+    metrics: config.metrics
+      ? new Metrics(config.metrics === true ? {} : config.metrics)
+      : null,
+    tracer: config.trace
+      ? new Tracer(config.trace === true ? {} : config.trace)
+      : null,
     interceptors: [],
     decorators: {},
     requestDecorators: {},
@@ -173,6 +282,9 @@ const vibe = (config = {}) => {
     errorHandler: handleError,
   };
 
+  // Worker threads start on the first task run, not here
+  const taskPool = () => (options.tasks ||= new TaskPool(config.tasks));
+
   // Register default landing route
   const defaultRoute = {
     method: "GET",
@@ -181,14 +293,24 @@ const vibe = (config = {}) => {
     handler: (req, res) => res.sendHtml("vibe.html"),
     intercept: null,
     media: { public: true, dest: null, maxSize: 10 * 1024 * 1024 },
+    isStatic: true,
   };
   trie.insert("GET", "/", defaultRoute);
+  staticRoutes.set("GET/", defaultRoute);
   routes.push(defaultRoute);
   options.routeCount = 1;
 
   // Current prefix for scoped routes (used in register)
   let currentPrefix = "";
 
+  // Prometheus / OpenMetrics scrape (merged across workers in cluster mode)
+  if (options.metrics) {
+    const metrics = options.metrics;
+    registerRoute("GET", metrics.path, { admission: false }, (req, res) =>
+      metrics.serve(req, res),
+    );
+  }
+
   /**
    * Route registration methods
    */
@@ -217,38 +339,30 @@ const vibe = (config = {}) => {
       pathRegex: null,
       handler: null,
       intercept: null,
+      skipInterceptors: null, // Global interceptors this route opts out of
       serialize: null,
+      validate: null,
+      parseQuery: null, // Compiled from schema.querystring
+      validateQuery: null,
       media: null, // Only set when explicitly configured
+      offload: null, // Task name when the handler runs on a worker thread
+      admission: null, // Route load shedding (null: app-wide limit only)
       // Pre-computed handler metadata (avoids typeof checks on hot path)
       _handlerType: 0, // 0=unknown, 1=function, 2=prebuilt-string
       _prebuilt: null, // Pre-stringified response for static handlers
+      _prebuiltBody: null, // ...encoded, with its headers and ETag
+      _prebuiltHeaders: null,
+      _etag: null,
     };
 
+    if (handler !== undefined) {
+      applyRouteOptions(route, opts, handler);
+    } else {
+      route.handler = opts;
+    }
+
     // Handle overriding root route
     if (fullPath === "/") {
-      if (handler !== undefined) {
-        if (typeof opts !== "object" || Array.isArray(opts)) {
-          throw new Error("Options must be an object when using 3-arg form");
-        }
-        route.intercept = opts.intercept
-          ? wrapIntercepts(opts.intercept)
-          : null;
-        if (opts.media) {
-          route.media = {
-            public: true,
-            dest: null,
-            maxSize: 10 * 1024 * 1024,
-            allowedTypes: null,
-            ...opts.media,
-          };
-        }
-        if (opts.schema?.response) {
-          route.serialize = compileSerializer(opts.schema.response);
-        }
-        route.handler = handler;
-      } else {
-        route.handler = opts;
-      }
       route.pathRegex = /^\/$/;
       route.isStatic = true;
       finalizeRoute(route);
@@ -266,28 +380,6 @@ const vibe = (config = {}) => {
       return;
     }
 
-    if (handler !== undefined) {
-      if (typeof opts !== "object" || Array.isArray(opts)) {
-        throw new Error("Options must be an object when using 3-arg form");
-      }
-      route.intercept = opts.intercept ? wrapIntercepts(opts.intercept) : null;
-      if (opts.media) {
-        route.media = {
-          public: true,
-          dest: null,
-          maxSize: 10 * 1024 * 1024,
-          allowedTypes: null,
-          ...opts.media,
-        };
-      }
-      if (opts.schema?.response) {
-        route.serialize = compileSerializer(opts.schema.response);
-      }
-      route.handler = handler;
-    } else {
-      route.handler = opts;
-    }
-
     // Generate regex for linear matching
     route.pathRegex = pathToRegex(fullPath);
 
@@ -310,25 +402,86 @@ const vibe = (config = {}) => {
   }
 
   /**
-   * Pre-computes handler type and pre-stringifies static values.
-   * This moves work from request-time to registration-time.
+   * Applies the 3-arg form's options to a route: interceptors, media,
+   * offload, admission and the compiled schemas.
+   * @param {VibeRoute} route
+   * @param {RouteOptions} opts
+   * @param {Handler} handler
+   */
+  function applyRouteOptions(route, opts, handler) {
+    if (typeof opts !== "object" || opts === null || Array.isArray(opts)) {
+      throw new Error("Options must be an object when using 3-arg form");
+    }
+    route.intercept = opts.intercept ? wrapIntercepts(opts.intercept) : null;
+    if (opts.skipInterceptors) {
+      route.skipInterceptors = resolveSkip(opts.skipInterceptors);
+    }
+    if (opts.media) route.media = resolveMedia(opts.media);
+    if (opts.offload) {
+      if (typeof handler !== "function") {
+        throw new Error("offload requires a function handler");
+      }
+      route.offload = `route:${route.method} ${route.path}`;
+      taskPool().define(route.offload, handler);
+    }
+    if (opts.admission !== undefined) {
+      route.admission = resolveAdmission(opts.admission);
+    }
+    if (opts.schema?.response) {
+      route.serialize = compileSerializer(opts.schema.response);
+    }
+    if (opts.schema?.body) {
+      route.validate = compileValidator(opts.schema.body, {
+        coerce: opts.schema.coerce,
+      });
+    }
+    if (opts.schema?.querystring) {
+      route.parseQuery = compileQuery(opts.schema.querystring);
+      route.validateQuery = compileValidator(opts.schema.querystring, {
+        coerce: true,
+        name: "query",
+      });
+    }
+    route.handler = handler;
+  }
+
+  /**
+   * Pre-computes handler type and pre-builds static responses.
+   * This moves work from request-time to registration-time: a static
+   * value is encoded once, with its Content-Length, type and ETag.
    */
   function finalizeRoute(route) {
     const h = route.handler;
     if (typeof h === "function") {
       route._handlerType = 1; // function
-    } else if (typeof h === "string") {
-      route._handlerType = 2; // pre-built string
-      route._prebuilt = h;
+      return;
+    }
+    if (typeof h === "string") {
+      route._prebuilt = h; // pre-built string
     } else if (typeof h === "object" && h !== null) {
-      route._handlerType = 2; // pre-built JSON
-      route._prebuilt = route.serialize
+      route._prebuilt = route.serialize // pre-built JSON
         ? route.serialize(h)
         : JSON.stringify(h);
     } else if (typeof h === "number" || typeof h === "boolean") {
-      route._handlerType = 2; // pre-built primitive
-      route._prebuilt = String(h);
+      route._prebuilt = String(h); // pre-built primitive
+    } else {
+      return;
     }
+    route._handlerType = 2;
+
+    // Looks like JSON ({ or [): served as JSON, anything else as text
+    const body = Buffer.from(route._prebuilt);
+    const c = body[0];
+    const hash = crypto.createHash("sha1").update(body).digest("base64url");
+    const etag = `"${hash.slice(0, 22)}"`;
+    route._prebuiltBody = body;
+    route._prebuiltHeaders = Object.freeze({
+      "content-type":
+        c === 123 || c === 91 ? "application/json" : "text/plain",
+      "content-length": body.length,
+      etag,
+    });
+    route._etag = etag;
   }
 
   /**
@@ -343,6 +496,16 @@ const vibe = (config = {}) => {
     return [adapt(intercept)];
   }
 
+  /**
+   * Normalizes a route's skipInterceptors option
+   * @param {true | Interceptor | Interceptor[]} skip
+   * @returns {true | Interceptor[]}
+   */
+  function resolveSkip(skip) {
+    if (skip === true) return true;
+    return Array.isArray(skip) ? skip : [skip];
+  }
+
   /**
    * Starts the HTTP server
    * @param {number} port - The port to listen on
@@ -462,7 +625,8 @@ const vibe = (config = {}) => {
    * @param {Interceptor} interceptor
    */
   function plugin(interceptor) {
-    options.interceptors.push(adapt(interceptor));
+    // Kept next to its source so routes can opt out by reference
+    options.interceptors.push({ source: interceptor, run: adapt(interceptor) });
   }
 
   /**
@@ -480,26 +644,30 @@ const vibe = (config = {}) => {
   }
 
   /**
-   * Decorates the request object with a custom property
+   * Decorates the request object with a custom property.
+   * Installed as a prototype getter: nothing is copied per request.
    * @param {string} name - Property name
-   * @param {any} value - Property value (or factory function)
+   * @param {any} value - Property value (or factory function, run on first read)
    */
   function decorateRequest(name, value) {
     if (name in options.requestDecorators) {
       throw new Error(`Request decorator '${name}' already exists`);
     }
+    installRequestDecorator(name);
     options.requestDecorators[name] = value;
   }
 
   /**
-   * Decorates the response object with a custom property
+   * Decorates the response object with a custom property or method.
+   * Installed as a prototype getter: nothing is copied per request.
    * @param {string} name - Property name
-   * @param {any} value - Property value (or factory function)
+   * @param {any} value - Property value (functions become methods)
    */
   function decorateReply(name, value) {
     if (name in options.replyDecorators) {
       throw new Error(`Reply decorator '${name}' already exists`);
     }
+    installReplyDecorator(name);
     options.replyDecorators[name] = value;
   }
 
@@ -519,35 +687,40 @@ const vibe = (config = {}) => {
     (options.publicFolder = foldername || "public");
 
   /**
-   * Adds static file serving route
+   * Adds static file serving route.
+   * The folder is scanned into an in-memory manifest once, here at listen().
    */
   function addStatic() {
     const routePath = `/${options.publicFolder}/*`;
+    const prefixLength = routePath.length - 1; // "/public/"
+    const files = getStaticFiles(options);
     const route = {
       method: "GET",
       path: routePath,
       pathRegex: pathToRegex(routePath),
-      handler: (req, res) => {
-        try {
-          const filePath = req.url
-            .split("/")
-            .filter(Boolean)
-            .slice(1)
-            .join("/");
-          res.sendFile(filePath);
-        } catch (err) {
-          log(err.message, "red");
-          res.status(404).send("Not Found");
-        }
-      },
+      handler: (req, res) => files.serve(req, res, req.url.slice(prefixLength)),
       intercept: null,
-      media: { public: true, dest: null },
+      media: null,
     };
     trie.insert("GET", routePath, route);
     routes.push(route);
     options.routeCount++;
   }
 
+  /**
+   * Registers a function to run on the worker thread pool.
+   * Function tasks are sent as source, so they must be self-contained
+   * (no variables from the enclosing scope); use `{ module, export }` for
+   * code that imports other modules.
+   * @param {string} name
+   * @param {import("./utils/scaling/task-pool.js").TaskDefinition} fn
+   * @returns {(...args: any[]) => Promise<any>} Runs the task with these arguments
+   */
+  function task(name, fn) {
+    const pool = taskPool().define(name, fn);
+    return (...args) => pool.run(name, args);
+  }
+
   /**
    * Log messages out using the Vibe stylized legacy logger.
    * Native string logging bypasses the Pino JSON interface.
@@ -580,8 +753,35 @@ const vibe = (config = {}) => {
     decorate,
     decorateRequest,
     decorateReply,
+    task,
   };
 
+  // Worker thread pool behind app.task() and { offload: true }
+  Object.defineProperty(app, "tasks", {
+    get: taskPool,
+  });
+
+  // Request metrics (null unless config.metrics is set)
+  Object.defineProperty(app, "metrics", {
+    get() {
+      return options.metrics;
+    },
+  });
+
+  // Request tracer (null unless config.trace is set)
+  Object.defineProperty(app, "tracer", {
+    get() {
+      return options.tracer;
+    },
+  });
+
+  // App-wide admission controller (null unless config.admission is set)
+  Object.defineProperty(app, "admission", {
+    get() {
+      return options.admission;
+    },
+  });
+
   // Add a getter for decorators
   Object.defineProperty(app, "decorators", {
     get() {
@@ -598,11 +798,33 @@ export { color, adapt };
 // Scalability utilities
 export {
   clusterize,
+  reloadWorkers,
+  supportsReusePort,
   isPrimary,
   isWorker,
   getWorkerId,
   getWorkerCount,
 } from "./utils/scaling/cluster.js";
 export { LRUCache, cacheMiddleware } from "./utils/scaling/cache.js";
+export {
+  SharedCache,
+  createSharedCache,
+  hostSharedCache,
+} from "./utils/scaling/shared-cache.js";
 export { Pool, createPool } from "./utils/scaling/pool.js";
+export { TaskPool, createTaskPool } from "./utils/scaling/task-pool.js";
+export {
+  AdmissionController,
+  createAdmission,
+} from "./utils/scaling/admission.js";
+export {
+  Metrics,
+  hostMetrics,
+  formatMetrics,
+} from "./utils/scaling/metrics.js";
 export { parseJsonStream } from "./utils/core/parser.js";
+export {
+  diskSink,
+  multipartSink,
+  writableSink,
+} from "./utils/core/upload-sinks.js";